@@ -0,0 +1,160 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Bing壁纸设置器 - 本地模拟 Bing 服务器
+
+用于测量首字节时间（bing_wallpaper_ttfb_ms）等网络相关的优化效果：
+程序通过 BING_WALLPAPER_BASE_URL 指向这里，请求 /HPImageArchive.aspx 时返回固定的壁纸信息，
+请求 /th 时返回 --image 指定的图片。
+
+--rtt 在服务前加一层转发，每个方向的数据都延迟 RTT/2 再送达，模拟真实网络的往返时间，
+这样 TCP/TLS 握手和连接复用带来的差异才能体现出来（回环地址上握手几乎不花时间）。
+
+示例：
+    ./scripts/mock_bing_server.py --image ~/Pictures/BingWallpapers/xxx.jpg --rtt 60
+    SSL_CERT_FILE=/tmp/bing-mock/cert.pem BING_WALLPAPER_BASE_URL=https://127.0.0.1:8443 ./bin/BingWallpaperSetter
+"""
+
+import argparse
+import asyncio
+import datetime
+import json
+import os
+import ssl
+import subprocess
+import sys
+import threading
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import urlparse
+
+
+def ensure_certificate(cert_dir):
+    """生成自签名证书，客户端用 SSL_CERT_FILE 信任它"""
+    os.makedirs(cert_dir, exist_ok=True)
+    cert = os.path.join(cert_dir, "cert.pem")
+    key = os.path.join(cert_dir, "key.pem")
+    if not (os.path.exists(cert) and os.path.exists(key)):
+        subprocess.run(["openssl", "req", "-x509", "-newkey", "rsa:2048", "-nodes",
+                        "-keyout", key, "-out", cert, "-days", "30",
+                        "-subj", "/CN=127.0.0.1",
+                        "-addext", "subjectAltName=IP:127.0.0.1,DNS:localhost"],
+                       check=True, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    return cert, key
+
+
+def make_handler(image):
+    class Handler(BaseHTTPRequestHandler):
+        protocol_version = "HTTP/1.1"
+
+        def log_message(self, fmt, *args):
+            sys.stderr.write("[模拟服务器] " + (fmt % args) + "\n")
+
+        def send_body(self, status, content_type, body, extra_headers=None):
+            self.send_response(status)
+            self.send_header("Content-Type", content_type)
+            self.send_header("Content-Length", str(len(body)))
+            for name, value in (extra_headers or {}).items():
+                self.send_header(name, value)
+            self.end_headers()
+            self.wfile.write(body)
+
+        def do_GET(self):
+            path = urlparse(self.path).path
+            if path == "/HPImageArchive.aspx":
+                date = datetime.date.today().strftime("%Y%m%d")
+                body = json.dumps({"images": [{
+                    "startdate": date,
+                    "url": "/th?id=OHR.MockWallpaper_ZH-CN0000000000_UHD.jpg",
+                    "title": "模拟壁纸",
+                    "copyright": "模拟壁纸 (© Mock)",
+                }]}).encode("utf-8")
+                self.send_body(200, "application/json", body)
+            elif path == "/th":
+                self.send_body(200, "image/jpeg", image, {"ETag": '"mock-image"'})
+            else:
+                self.send_body(404, "text/plain", b"not found")
+
+    return Handler
+
+
+async def delayed_pipe(reader, writer, one_way):
+    """按到达时间加上单程延迟转发，只模拟传播延迟，不限制带宽"""
+    queue = asyncio.Queue()
+    loop = asyncio.get_running_loop()
+
+    async def receive():
+        while True:
+            data = await reader.read(65536)
+            await queue.put((loop.time() + one_way, data))
+            if not data:
+                return
+
+    async def send():
+        while True:
+            deadline, data = await queue.get()
+            await asyncio.sleep(max(0.0, deadline - loop.time()))
+            if not data:
+                break
+            writer.write(data)
+            await writer.drain()
+        writer.close()
+
+    await asyncio.gather(receive(), send(), return_exceptions=True)
+
+
+async def run_proxy(listen_port, target_port, rtt_ms):
+    one_way = rtt_ms / 2000.0
+
+    async def handle(client_reader, client_writer):
+        # 内核已完成三次握手，这里补上一个往返的建连时间
+        await asyncio.sleep(2 * one_way)
+        server_reader, server_writer = await asyncio.open_connection("127.0.0.1", target_port)
+        await asyncio.gather(delayed_pipe(client_reader, server_writer, one_way),
+                             delayed_pipe(server_reader, client_writer, one_way),
+                             return_exceptions=True)
+
+    server = await asyncio.start_server(handle, "127.0.0.1", listen_port)
+    async with server:
+        await server.serve_forever()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="本地模拟 Bing 服务器")
+    parser.add_argument("--port", type=int, default=8443, help="监听端口（默认 8443）")
+    parser.add_argument("--image", required=True, help="/th 返回的 JPEG 图片")
+    parser.add_argument("--rtt", type=int, default=0, help="模拟的往返时间，毫秒（默认 0）")
+    parser.add_argument("--plain", action="store_true", help="使用 http 而不是 https")
+    parser.add_argument("--cert-dir", default="/tmp/bing-mock", help="自签名证书目录")
+    args = parser.parse_args()
+
+    with open(args.image, "rb") as f:
+        image = f.read()
+
+    server_port = args.port if args.rtt <= 0 else 0
+    httpd = ThreadingHTTPServer(("127.0.0.1", server_port), make_handler(image))
+    scheme = "http"
+    if not args.plain:
+        cert, key = ensure_certificate(args.cert_dir)
+        context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        context.load_cert_chain(cert, key)
+        # 没有 HTTP/2 实现，客户端通过 ALPN 回退到 HTTP/1.1
+        context.set_alpn_protocols(["http/1.1"])
+        httpd.socket = context.wrap_socket(httpd.socket, server_side=True)
+        scheme = "https"
+        print("证书: " + cert + "（客户端设置 SSL_CERT_FILE 指向它）")
+
+    print("BING_WALLPAPER_BASE_URL=%s://127.0.0.1:%d  RTT=%d ms" % (scheme, args.port, args.rtt))
+    sys.stdout.flush()
+    if args.rtt <= 0:
+        httpd.serve_forever()
+        return
+
+    threading.Thread(target=httpd.serve_forever, daemon=True).start()
+    try:
+        asyncio.run(run_proxy(args.port, httpd.server_address[1], args.rtt))
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -125,7 +125,7 @@ Version: ${PKG_VERSION}
 Section: utils
 Priority: optional
 Architecture: ${PKG_ARCH}
-Depends: libqt5core5a, libqt5gui5, libqt5widgets5, libqt5network5
+Depends: libqt5core5a, libqt5gui5, libqt5widgets5, libqt5network5, libqt5dbus5
 Maintainer: BingWallpaper <admin@bingwallpaper.local>
 Description: Bing每日4K壁纸自动设置器
  自动从Bing获取每日4K超高清壁纸并设置为桌面背景。
@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Bing壁纸设置器 - 下载策略测试
+
+在私有的系统总线上用 python-dbusmock 模拟 NetworkManager 和 UPower，
+分别设置计费网络（Metered）、供电方式（OnBattery）和电量（Percentage），
+运行 BingWallpaperSetter --print-download-policy，检查自动更新和手动请求的下载策略。
+
+配置和数据目录指向临时目录，使用默认配置（遵守计费网络，电量低于 20% 时推迟），
+不会读取或改动当前用户的配置。
+
+依赖：python-dbusmock、dbus-python、dbus-daemon
+
+示例：
+    ./scripts/test_download_policy.py                         # 默认使用 build/bin/BingWallpaperSetter
+    BING_WALLPAPER_BIN=/usr/bin/BingWallpaperSetter ./scripts/test_download_policy.py -v
+"""
+
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import unittest
+
+try:
+    import dbus
+    import dbusmock
+except ImportError as error:
+    sys.stderr.write("缺少依赖: %s（pip install python-dbusmock dbus-python）\n" % error)
+    sys.exit(77)
+
+PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+BINARY = os.environ.get("BING_WALLPAPER_BIN",
+                        os.path.join(PROJECT_DIR, "build", "bin", "BingWallpaperSetter"))
+
+NM_PATH = "/org/freedesktop/NetworkManager"
+NM_INTERFACE = "org.freedesktop.NetworkManager"
+
+# NMMetered 枚举
+NM_METERED_YES = 1
+NM_METERED_NO = 2
+NM_METERED_GUESS_YES = 3
+NM_METERED_GUESS_NO = 4
+
+# UPower 设备类型和状态
+UPOWER_TYPE_BATTERY = 2
+UPOWER_STATE_CHARGING = 1
+UPOWER_STATE_DISCHARGING = 2
+
+
+class DownloadPolicyTest(dbusmock.DBusTestCase):
+    @classmethod
+    def setUpClass(cls):
+        if not os.access(BINARY, os.X_OK):
+            raise unittest.SkipTest("未找到程序 %s，可用 BING_WALLPAPER_BIN 指定" % BINARY)
+        cls.start_system_bus()
+        cls.dbus_con = cls.get_dbus(system_bus=True)
+
+    def setUp(self):
+        self.mocks = []
+        self.home = tempfile.mkdtemp(prefix="bing-policy-")
+
+    def tearDown(self):
+        for process in self.mocks:
+            process.terminate()
+            process.wait()
+        shutil.rmtree(self.home, ignore_errors=True)
+
+    def start_network_manager(self, metered):
+        process, obj = self.spawn_server_template("networkmanager", {}, stdout=subprocess.DEVNULL)
+        self.mocks.append(process)
+        # 模板没有 Metered 时添加，已有时更新
+        try:
+            obj.AddProperty(NM_INTERFACE, "Metered", dbus.UInt32(metered),
+                            dbus_interface=dbusmock.MOCK_IFACE)
+        except dbus.exceptions.DBusException:
+            obj.UpdateProperties(NM_INTERFACE, {"Metered": dbus.UInt32(metered)},
+                                 dbus_interface=dbusmock.MOCK_IFACE)
+
+    def start_upower(self, on_battery, percentage=None):
+        process, obj = self.spawn_server_template(
+            "upower", {"OnBattery": on_battery, "DaemonVersion": "0.99"}, stdout=subprocess.DEVNULL)
+        self.mocks.append(process)
+        if percentage is not None:
+            state = UPOWER_STATE_DISCHARGING if on_battery else UPOWER_STATE_CHARGING
+            obj.SetupDisplayDevice(dbus.UInt32(UPOWER_TYPE_BATTERY), dbus.UInt32(state),
+                                   dbus.Double(percentage), dbus.Double(percentage / 2.0),
+                                   dbus.Double(50.0), dbus.Double(10.0), dbus.Int64(3600), dbus.Int64(0),
+                                   dbus.Boolean(True), dbus.String("battery-symbolic"), dbus.UInt32(1),
+                                   dbus_interface=dbusmock.MOCK_IFACE)
+
+    def policy(self):
+        env = dict(os.environ)
+        env.update({
+            "XDG_CONFIG_HOME": os.path.join(self.home, "config"),
+            "XDG_CONFIG_DIRS": os.path.join(self.home, "xdg"),
+            "XDG_DATA_HOME": os.path.join(self.home, "data"),
+            "XDG_CACHE_HOME": os.path.join(self.home, "cache"),
+            "BING_WALLPAPER_NO_NETWORK_INFORMATION": "1",
+        })
+        output = subprocess.run([BINARY, "--print-download-policy"], env=env, check=True, timeout=30,
+                                stdout=subprocess.PIPE, stderr=subprocess.DEVNULL).stdout.decode("utf-8")
+        # 最后一行形如 automatic=defer user=reduced constraint=按流量计费的网络
+        fields = dict(field.split("=", 1) for field in output.strip().splitlines()[-1].split(" ", 2))
+        return fields["automatic"], fields["user"]
+
+    def test_unmetered_on_ac(self):
+        self.start_network_manager(NM_METERED_NO)
+        self.start_upower(False)
+        self.assertEqual(self.policy(), ("full", "full"))
+
+    def test_guessed_unmetered(self):
+        self.start_network_manager(NM_METERED_GUESS_NO)
+        self.start_upower(False)
+        self.assertEqual(self.policy(), ("full", "full"))
+
+    def test_metered_defers_automatic_updates(self):
+        self.start_network_manager(NM_METERED_YES)
+        self.start_upower(False)
+        self.assertEqual(self.policy(), ("defer", "reduced"))
+
+    def test_guessed_metered(self):
+        # 手机热点等由连接类型推测为计费网络
+        self.start_network_manager(NM_METERED_GUESS_YES)
+        self.start_upower(False)
+        self.assertEqual(self.policy(), ("defer", "reduced"))
+
+    def test_battery_reduces_quality(self):
+        self.start_network_manager(NM_METERED_NO)
+        self.start_upower(True, percentage=80.0)
+        self.assertEqual(self.policy(), ("reduced", "reduced"))
+
+    def test_low_battery_defers_automatic_updates(self):
+        self.start_network_manager(NM_METERED_NO)
+        self.start_upower(True, percentage=10.0)
+        self.assertEqual(self.policy(), ("defer", "reduced"))
+
+    def test_low_battery_while_charging(self):
+        # 接通电源时电量低不受限制
+        self.start_network_manager(NM_METERED_NO)
+        self.start_upower(False, percentage=10.0)
+        self.assertEqual(self.policy(), ("full", "full"))
+
+    def test_metered_on_battery(self):
+        self.start_network_manager(NM_METERED_YES)
+        self.start_upower(True, percentage=80.0)
+        self.assertEqual(self.policy(), ("defer", "reduced"))
+
+    def test_services_missing(self):
+        # 没有 NetworkManager 和 UPower 时状态未知，按不受限处理
+        self.assertEqual(self.policy(), ("full", "full"))
+
+
+if __name__ == "__main__":
+    unittest.main()
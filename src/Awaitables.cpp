@@ -0,0 +1,127 @@
+#include "Awaitables.h"
+#include "HedgedRequest.h"
+#include <QCoreApplication>
+#include <utility>
+
+namespace Async {
+
+namespace detail {
+
+void resumeLater(std::coroutine_handle<> handle) {
+    QMetaObject::invokeMethod(QCoreApplication::instance(), [handle]() {
+        handle.resume();
+    }, Qt::QueuedConnection);
+}
+
+void EventAwaiter::complete() {
+    if (m_completed) {
+        return;
+    }
+    m_completed = true;
+    disconnectAll();
+    m_registration.reset();
+    if (m_handle) {
+        resumeLater(m_handle);
+    }
+}
+
+void EventAwaiter::disconnectAll() {
+    for (const QMetaObject::Connection &connection : std::as_const(m_connections)) {
+        QObject::disconnect(connection);
+    }
+    m_connections.clear();
+}
+
+} // namespace detail
+
+ReplyAwaiter::ReplyAwaiter(QNetworkReply *reply, const CancellationToken &token)
+    : m_reply(reply)
+{
+    if (reply->isFinished()) {
+        m_completed = true;
+        return;
+    }
+    m_connections.append(QObject::connect(reply, &QNetworkReply::finished, [this]() {
+        complete();
+    }));
+    // 中止后 finished 会照常发出；请求随网络管理器销毁时也要保证协程恢复
+    m_registration = token.onCancel([this]() {
+        if (m_reply) {
+            m_reply->abort();
+        }
+        complete();
+    });
+}
+
+HedgedAwaiter::HedgedAwaiter(HedgedRequest *request, const CancellationToken &token)
+    : m_request(request)
+{
+    m_connections.append(QObject::connect(request, &HedgedRequest::replyReady,
+                                          [this](QNetworkReply *reply, const QString &endpoint) {
+        m_result.reply = reply;
+        m_result.endpoint = endpoint;
+        complete();
+    }));
+    m_connections.append(QObject::connect(request, &HedgedRequest::failed, [this](const QString &error) {
+        m_result.error = error;
+        complete();
+    }));
+    m_registration = token.onCancel([this]() {
+        if (m_request) {
+            m_request->abort();
+        }
+        m_result.error = "请求已取消";
+        complete();
+    });
+}
+
+ProcessAwaiter::ProcessAwaiter(const QString &program, const QStringList &arguments, int timeoutMs,
+                               const CancellationToken &token)
+    : m_process(new QProcess)
+{
+    m_connections.append(QObject::connect(m_process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+                                          [this](int exitCode, QProcess::ExitStatus exitStatus) {
+        m_result.exitCode = exitStatus == QProcess::NormalExit ? exitCode : -1;
+        m_result.output = m_process->readAllStandardOutput();
+        complete();
+    }));
+    // 启动失败时不会再发出 finished
+    m_connections.append(QObject::connect(m_process, &QProcess::errorOccurred, [this](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            m_result.started = false;
+            complete();
+        }
+    }));
+
+    if (timeoutMs >= 0) {
+        m_timeoutTimer.setSingleShot(true);
+        QObject::connect(&m_timeoutTimer, &QTimer::timeout, [this]() {
+            if (!m_completed) {
+                m_result.timedOut = true;
+                m_process->kill();
+            }
+        });
+        m_timeoutTimer.start(timeoutMs);
+    }
+
+    m_registration = token.onCancel([this]() {
+        m_process->kill();
+        complete();
+    });
+
+    if (!m_completed) {
+        m_result.started = true;
+        m_process->start(program, arguments);
+    }
+}
+
+ProcessAwaiter::~ProcessAwaiter() {
+    disconnectAll();
+    if (m_process->state() != QProcess::NotRunning) {
+        m_process->kill();
+    }
+    // 可能仍在 QProcess 的信号处理过程中，延迟删除
+    m_process->deleteLater();
+}
+
+} // namespace Async
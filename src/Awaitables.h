@@ -0,0 +1,215 @@
+#ifndef AWAITABLES_H
+#define AWAITABLES_H
+
+#include <QObject>
+#include <QList>
+#include <QPointer>
+#include <QTimer>
+#include <QThreadPool>
+#include <QProcess>
+#include <QNetworkReply>
+#include <QStringList>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include "Task.h"
+
+class HedgedRequest;
+
+/**
+ * @brief 与 Qt 事件循环对接的可等待对象
+ *
+ * 协程总是在主线程的下一轮事件循环中恢复，而不是在发出信号的调用栈里直接恢复，
+ * 这样协程可以放心地销毁发出信号的对象（网络请求、子进程、本地套接字）。
+ * 取消时立即执行对应的中止操作并恢复协程，协程应在每次 co_await 之后检查令牌。
+ * GCC 12 会按位复制 co_await 表达式中的花括号临时对象和 lambda 临时对象并重复析构，
+ * 等待对象一律通过下面的函数创建，传给 runInThread() 的 lambda 先存入具名变量。
+ */
+namespace Async {
+
+namespace detail {
+
+/**
+ * @brief 在主线程的下一轮事件循环中恢复协程，可以在任意线程调用
+ */
+void resumeLater(std::coroutine_handle<> handle);
+
+/**
+ * @brief 等待一次事件的公共部分
+ *
+ * 构造时就开始监听，事件在 co_await 之前到达时不会挂起。
+ * 信号连接捕获了 this，所以对象不能复制或移动。
+ */
+class EventAwaiter {
+public:
+    EventAwaiter() = default;
+    EventAwaiter(const EventAwaiter &) = delete;
+    EventAwaiter &operator=(const EventAwaiter &) = delete;
+    ~EventAwaiter() { disconnectAll(); }
+
+    bool await_ready() const noexcept { return m_completed; }
+    void await_suspend(std::coroutine_handle<> handle) noexcept { m_handle = handle; }
+
+protected:
+    void complete();
+    void disconnectAll();
+
+    bool m_completed = false;
+    std::coroutine_handle<> m_handle;
+    QList<QMetaObject::Connection> m_connections;
+    CancellationToken::Registration m_registration;
+};
+
+} // namespace detail
+
+/**
+ * @brief 等待网络请求结束，取消时中止请求
+ */
+class ReplyAwaiter : public detail::EventAwaiter {
+public:
+    ReplyAwaiter(QNetworkReply *reply, const CancellationToken &token);
+
+    /**
+     * @return 请求对象；取消后可能已随网络管理器一起销毁，此时为 nullptr
+     */
+    QNetworkReply *await_resume() const noexcept { return m_reply; }
+
+private:
+    QPointer<QNetworkReply> m_reply;
+};
+
+struct HedgedResult {
+    QNetworkReply *reply = nullptr;     // 胜出的请求，失败时为 nullptr
+    QString endpoint;
+    QString error;
+};
+
+/**
+ * @brief 等待对冲请求收到第一个有效响应头
+ */
+class HedgedAwaiter : public detail::EventAwaiter {
+public:
+    HedgedAwaiter(HedgedRequest *request, const CancellationToken &token);
+
+    HedgedResult await_resume() const { return m_result; }
+
+private:
+    QPointer<HedgedRequest> m_request;
+    HedgedResult m_result;
+};
+
+/**
+ * @brief 等待信号发出一次，结果为信号参数组成的 tuple，取消时为空
+ */
+template<typename Sender, typename... Args>
+class SignalAwaiter : public detail::EventAwaiter {
+public:
+    using Result = std::tuple<std::decay_t<Args>...>;
+
+    SignalAwaiter(Sender *sender, void (Sender::*signal)(Args...), const CancellationToken &token) {
+        m_connections.append(QObject::connect(sender, signal, [this](Args... args) {
+            if (!m_completed) {
+                m_result.emplace(args...);
+                complete();
+            }
+        }));
+        m_registration = token.onCancel([this]() {
+            complete();
+        });
+    }
+
+    std::optional<Result> await_resume() { return std::move(m_result); }
+
+private:
+    std::optional<Result> m_result;
+};
+
+struct ProcessResult {
+    bool started = false;
+    bool timedOut = false;
+    int exitCode = -1;                  // 崩溃或被结束时为 -1
+    QByteArray output;
+
+    bool succeeded() const { return started && !timedOut && exitCode == 0; }
+};
+
+/**
+ * @brief 异步运行外部命令，超时或取消时结束进程
+ */
+class ProcessAwaiter : public detail::EventAwaiter {
+public:
+    ProcessAwaiter(const QString &program, const QStringList &arguments, int timeoutMs,
+                   const CancellationToken &token);
+    ~ProcessAwaiter();
+
+    ProcessResult await_resume() const { return m_result; }
+
+private:
+    QProcess *m_process;
+    QTimer m_timeoutTimer;
+    ProcessResult m_result;
+};
+
+/**
+ * @brief 在线程池中执行函数，完成后回到主线程恢复
+ *
+ * 工作线程中的计算无法被打断，需要提前结束时由函数自己轮询 CancellationToken::isCancelled()。
+ */
+template<typename Function>
+class ThreadAwaiter {
+public:
+    using Result = std::invoke_result_t<Function &>;
+    static_assert(!std::is_void_v<Result>, "runInThread 的函数需要返回结果");
+
+    explicit ThreadAwaiter(Function function)
+        : m_function(std::move(function)), m_state(std::make_shared<State>()) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+        QThreadPool::globalInstance()->start([state = m_state, function = std::move(m_function), handle]() mutable {
+            state->result.emplace(function());
+            detail::resumeLater(handle);
+        });
+    }
+
+    Result await_resume() { return std::move(*m_state->result); }
+
+private:
+    // 结果由工作线程写入，经事件队列回到主线程后才读取
+    struct State {
+        std::optional<Result> result;
+    };
+
+    Function m_function;
+    std::shared_ptr<State> m_state;
+};
+
+inline ReplyAwaiter awaitReply(QNetworkReply *reply, const CancellationToken &token = CancellationToken()) {
+    return ReplyAwaiter(reply, token);
+}
+
+inline HedgedAwaiter awaitHedged(HedgedRequest *request, const CancellationToken &token = CancellationToken()) {
+    return HedgedAwaiter(request, token);
+}
+
+template<typename Sender, typename... Args>
+SignalAwaiter<Sender, Args...> awaitSignal(Sender *sender, void (Sender::*signal)(Args...),
+                                           const CancellationToken &token = CancellationToken()) {
+    return SignalAwaiter<Sender, Args...>(sender, signal, token);
+}
+
+inline ProcessAwaiter runProcess(const QString &program, const QStringList &arguments, int timeoutMs,
+                                 const CancellationToken &token = CancellationToken()) {
+    return ProcessAwaiter(program, arguments, timeoutMs, token);
+}
+
+template<typename Function>
+ThreadAwaiter<Function> runInThread(Function function) {
+    return ThreadAwaiter<Function>(std::move(function));
+}
+
+} // namespace Async
+
+#endif // AWAITABLES_H
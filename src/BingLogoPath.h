@@ -0,0 +1,68 @@
+#ifndef BINGLOGOPATH_H
+#define BINGLOGOPATH_H
+
+#include <QPainterPath>
+
+/**
+ * @brief Bing 标志的轮廓，由官方 SVG 的路径数据转换而来
+ *
+ * 坐标范围约为 (4, 0) ~ (19.6, 24)，按 24x24 的画布设计。
+ * 只在编译时由图标生成工具使用，程序运行时直接加载生成好的图标资源。
+ */
+inline QPainterPath bingLogoPath() {
+    QPainterPath path;
+    path.moveTo(4.842, 0.005);
+    path.cubicTo(5.046, -0.042, 5.263, 0.005, 5.446, 0.147);
+    path.lineTo(8.066, 1.960);
+    path.cubicTo(8.435, 2.216, 8.558, 2.312, 8.703, 2.456);
+    path.cubicTo(9.174, 2.926, 9.455, 3.546, 9.500, 4.221);
+    path.lineTo(9.508, 5.068);
+    path.lineTo(9.511, 6.509);
+    path.lineTo(9.515, 19.511);
+    path.lineTo(9.659, 19.417);
+    path.lineTo(16.674, 15.064);
+    path.lineTo(16.689, 15.067);
+    path.lineTo(16.718, 15.077);
+    path.cubicTo(16.320, 14.907, 15.825, 14.738, 15.063, 14.511);
+    path.lineTo(14.579, 14.365);
+    path.cubicTo(13.995, 14.185, 13.869, 14.127, 13.658, 13.985);
+    path.cubicTo(13.525, 13.894, 13.405, 13.784, 13.288, 13.673);
+    path.cubicTo(13.108, 13.488, 12.953, 13.272, 12.878, 13.081);
+    path.lineTo(11.320, 9.063);
+    path.cubicTo(11.154, 8.619, 11.154, 8.573, 11.164, 8.433);
+    path.cubicTo(11.192, 8.153, 11.373, 7.918, 11.640, 7.805);
+    path.cubicTo(11.754, 7.756, 11.883, 7.729, 11.970, 7.795);
+    path.lineTo(12.094, 7.805);
+    path.lineTo(12.146, 7.826);
+    path.cubicTo(12.206, 7.852, 12.306, 7.901, 12.459, 7.980);
+    path.lineTo(16.089, 9.888);
+    path.cubicTo(17.452, 10.634, 18.574, 11.804, 19.381, 13.419);
+    path.cubicTo(19.575, 14.409, 19.540, 15.456, 19.279, 16.431);
+    path.cubicTo(19.063, 17.236, 18.640, 18.125, 18.225, 18.644);
+    path.lineTo(18.145, 18.743);
+    path.lineTo(18.098, 18.793);
+    path.cubicTo(18.088, 18.803, 18.085, 18.803, 18.088, 18.795);
+    path.lineTo(18.131, 18.721);
+    path.lineTo(18.059, 18.835);
+    path.cubicTo(18.048, 18.866, 17.826, 19.115, 17.679, 19.260);
+    path.lineTo(17.509, 19.421);
+    path.cubicTo(17.289, 19.623, 17.078, 19.781, 16.677, 20.041);
+    path.lineTo(13.544, 23.0);
+    path.cubicTo(12.603, 23.600, 11.684, 23.912, 10.631, 23.992);
+    path.cubicTo(10.401, 24.010, 9.777, 24.000, 9.557, 23.975);
+    path.cubicTo(9.035, 23.919, 8.534, 23.780, 7.899, 23.563);
+    path.cubicTo(6.045, 22.825, 4.676, 21.275, 4.194, 19.368);
+    path.cubicTo(4.126, 19.110, 4.083, 18.914, 4.073, 18.798);
+    path.lineTo(4.027, 18.473);
+    path.cubicTo(4.020, 18.395, 4.016, 18.327, 4.013, 18.305);
+    path.lineTo(4.007, 18.276);
+    path.lineTo(4.0, 11.617);
+    path.lineTo(4.010, 0.866);
+    path.cubicTo(4.011, 0.805, 4.014, 0.770, 4.017, 0.755);
+    path.cubicTo(4.062, 0.464, 4.264, 0.218, 4.535, 0.116);
+    path.cubicTo(4.647, 0.071, 4.751, 0.039, 4.842, 0.005);
+    path.closeSubpath();
+    return path;
+}
+
+#endif // BINGLOGOPATH_H
@@ -2,28 +2,114 @@
 #include <QStandardPaths>
 #include <QFile>
 #include <QDateTime>
-#include <QProcess>
+#include <QDate>
 #include <QDebug>
 #include <QFileInfo>
-#include <QSettings>
-#include <QRegExp>
+#include <QRegularExpression>
+#include <QElapsedTimer>
+#include <QSaveFile>
+#include <QSslSocket>
+#include <QTimer>
+#include <QGuiApplication>
+#include <QScreen>
+#include <utility>
+#include "Metrics.h"
+#include "ImageAnalyzer.h"
+#include "LockScreenGenerator.h"
+#include "JpegVerifier.h"
+#include "SettingsStore.h"
+#include "WallpaperCommands.h"
+
+namespace {
+
+const int MAX_STALL_RETRIES = 3;
+// 启动后稍等再检查壁纸库，不和首次更新争抢磁盘和网络
+const int STARTUP_VERIFY_DELAY_MS = 10000;
+// 插拔显示器或调整排列时布局会连续变化几次，稳定后再重新合成
+const int SCREEN_LAYOUT_SETTLE_MS = 2000;
+const int MAX_OFFSET = 7;
+
+/**
+ * @brief 检查 206 响应的 Content-Range 是否正好接在已下载部分之后
+ * @param expectedTotal 第一次请求得到的文件大小，未知时为 -1
+ */
+bool continuesFrom(const QByteArray &contentRange, qint64 offset, qint64 expectedTotal) {
+    // 格式为 "bytes 起始-结束/总长"，总长未知时为 "*"
+    static const QRegularExpression pattern("\\Abytes\\s+(\\d+)-(\\d+)/(\\d+|\\*)\\z");
+    QRegularExpressionMatch match = pattern.match(QString::fromLatin1(contentRange).trimmed());
+    if (!match.hasMatch() || match.captured(1).toLongLong() != offset) {
+        return false;
+    }
+    return expectedTotal <= 0 || match.captured(3) == "*" || match.captured(3).toLongLong() == expectedTotal;
+}
+
+}
 
 BingWallpaperSetter::BingWallpaperSetter(QObject *parent)
     : QObject(parent)
     , m_networkManager(new QNetworkAccessManager(this))
-    , m_bingApiUrl("https://www.bing.com/HPImageArchive.aspx?format=js&idx=%1&n=1&mkt=zh-CN")
-    , m_currentReply(nullptr)
+    , m_bingApiUrl("/HPImageArchive.aspx?format=js&idx=%1&n=1&mkt=%2")
+    , m_market("zh-CN")
     , m_isCustomDirectory(false)
     , m_currentOffset(0)
+    , m_library(new WallpaperLibrary(this))
+    , m_endpointStats(nullptr)
+    , m_downloadPolicy(new DownloadPolicy(this))
+    , m_integrityScanner(new IntegrityScanner(this))
+    , m_screenLayoutTimer(new QTimer(this))
+    , m_prefetcher(new Prefetcher(this))
+    , m_verifyingLibrary(false)
+    , m_deferredUpdate(false)
+    , m_stallTimeoutMs(15000)
+    , m_progressivePreviewEnabled(false)
+    , m_nextJobId(0)
+    , m_latestJobId(-1)
+    , m_applyMutex(std::make_shared<Async::AsyncMutex>())
 {
+    connect(m_downloadPolicy, &DownloadPolicy::deferralLifted, this, &BingWallpaperSetter::onDeferralLifted);
+    connect(m_prefetcher, &Prefetcher::idleReached, this, [this]() {
+        Async::spawn(runPrefetch(Prefetcher::Adjacent));
+    });
+    connect(m_prefetcher, &Prefetcher::publishDue, this, [this]() {
+        Async::spawn(runPrefetch(Prefetcher::Published));
+    });
+    
+    // API 和图片请求共用同一条 HTTP/2 连接；保留 TLS 会话票据以便下次启动时快速恢复握手
+    m_sslConfiguration = QSslConfiguration::defaultConfiguration();
+    m_sslConfiguration.setAllowedNextProtocols({QSslConfiguration::ALPNProtocolHTTP2,
+                                                QSslConfiguration::NextProtocolHttp1_1});
+    m_sslConfiguration.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+    loadSessionTicket();
     loadSettings();
     setupWallpaperDirectory();
+    m_library->importDirectory(m_wallpaperDir);
+    
+    QTimer::singleShot(STARTUP_VERIFY_DELAY_MS, this, [this]() {
+        verifyLibrary(false);
+    });
+    
+    m_screenLayoutTimer->setSingleShot(true);
+    m_screenLayoutTimer->setInterval(SCREEN_LAYOUT_SETTLE_MS);
+    connect(m_screenLayoutTimer, &QTimer::timeout, this, &BingWallpaperSetter::onScreenLayoutChanged);
+    if (auto *app = qobject_cast<QGuiApplication *>(QCoreApplication::instance())) {
+        auto scheduleRelayout = [this]() {
+            m_screenLayoutTimer->start();
+        };
+        const QList<QScreen *> screens = QGuiApplication::screens();
+        for (QScreen *screen : screens) {
+            connect(screen, &QScreen::geometryChanged, this, scheduleRelayout);
+        }
+        connect(app, &QGuiApplication::screenAdded, this, [this, scheduleRelayout](QScreen *screen) {
+            connect(screen, &QScreen::geometryChanged, this, scheduleRelayout);
+            scheduleRelayout();
+        });
+        connect(app, &QGuiApplication::screenRemoved, this, scheduleRelayout);
+    }
 }
 
 BingWallpaperSetter::~BingWallpaperSetter() {
-    if (m_currentReply) {
-        m_currentReply->abort();
-    }
+    // 中止所有进行中的请求和子进程，挂起的协程恢复后发现已取消便直接退出
+    m_lifetime.cancel();
 }
 
 void BingWallpaperSetter::setupWallpaperDirectory() {
@@ -43,22 +129,58 @@ void BingWallpaperSetter::setupWallpaperDirectory() {
 }
 
 void BingWallpaperSetter::loadSettings() {
-    QSettings settings("BingWallpaper", "Settings");
-    QString customDir = settings.value("wallpaperDirectory", "").toString();
+    SettingsStore *settings = SettingsStore::instance();
+    
+    m_endpointStats = new EndpointStats(configuredEndpoints(settings->value(SettingsKeys::Endpoints)), this);
+    
+    // 超过这么多秒没有收到数据就中止并断点续传
+    m_stallTimeoutMs = settings->value(SettingsKeys::StallTimeout) * 1000;
+    
+    QString customDir = settings->value(SettingsKeys::WallpaperDirectory);
     
     if (!customDir.isEmpty() && QDir(customDir).exists()) {
         m_wallpaperDir = customDir;
         m_isCustomDirectory = true;
         qDebug() << "加载自定义壁纸目录:" << m_wallpaperDir;
     }
+    
+    // 其他实例或管理员修改配置文件后立即生效
+    settings->onChanged(SettingsKeys::Endpoints, this, [this](const QStringList &endpoints) {
+        m_endpointStats->setEndpoints(configuredEndpoints(endpoints));
+    });
+    settings->onChanged(SettingsKeys::StallTimeout, this, [this](int seconds) {
+        m_stallTimeoutMs = seconds * 1000;
+    });
+    settings->onChanged(SettingsKeys::WallpaperDirectory, this, [this](const QString &directory) {
+        QString target = !directory.isEmpty() && QDir(directory).exists() ? directory : m_defaultWallpaperDir;
+        if (target != m_wallpaperDir) {
+            applyWallpaperDirectory(target);
+        }
+    });
+}
+
+QStringList BingWallpaperSetter::configuredEndpoints(QStringList endpoints) const {
+    // 依次尝试的服务器地址，国内网络下 cn.bing.com 往往比 www.bing.com 快
+    // 测试时可以指向本地的模拟服务器，例如 http://127.0.0.1:8080
+    QString baseUrl = qEnvironmentVariable("BING_WALLPAPER_BASE_URL");
+    if (!baseUrl.isEmpty()) {
+        endpoints = QStringList() << baseUrl;
+        qDebug() << "使用自定义服务器:" << baseUrl;
+    }
+    for (QString &endpoint : endpoints) {
+        while (endpoint.endsWith('/')) {
+            endpoint.chop(1);
+        }
+    }
+    return endpoints;
 }
 
 void BingWallpaperSetter::saveSettings() {
-    QSettings settings("BingWallpaper", "Settings");
+    SettingsStore *settings = SettingsStore::instance();
     if (m_isCustomDirectory) {
-        settings.setValue("wallpaperDirectory", m_wallpaperDir);
+        settings->setValue(SettingsKeys::WallpaperDirectory, m_wallpaperDir);
     } else {
-        settings.remove("wallpaperDirectory");
+        settings->remove(SettingsKeys::WallpaperDirectory);
     }
 }
 
@@ -68,6 +190,11 @@ void BingWallpaperSetter::setWallpaperDirectory(const QString &directory) {
         return;
     }
     
+    applyWallpaperDirectory(directory);
+    saveSettings();
+}
+
+void BingWallpaperSetter::applyWallpaperDirectory(const QString &directory) {
     m_wallpaperDir = directory;
     m_isCustomDirectory = (directory != m_defaultWallpaperDir);
     
@@ -77,15 +204,221 @@ void BingWallpaperSetter::setWallpaperDirectory(const QString &directory) {
         dir.mkpath(m_wallpaperDir);
     }
     
-    saveSettings();
+    m_library->importDirectory(m_wallpaperDir);
     qDebug() << "壁纸目录已设置为:" << m_wallpaperDir;
+    emit wallpaperDirectoryChanged(m_wallpaperDir);
 }
 
 bool BingWallpaperSetter::isCustomDirectory() const {
     return m_isCustomDirectory;
 }
 
-void BingWallpaperSetter::downloadAndSetWallpaper(int button) {
+WallpaperLibrary *BingWallpaperSetter::library() const {
+    return m_library;
+}
+
+void BingWallpaperSetter::setWallpaperFromFile(const QString &imagePath) {
+    Async::spawn(applyFromFile(imagePath));
+}
+
+Async::Task<void> BingWallpaperSetter::applyFromFile(QString imagePath) {
+    Async::CancellationToken token = m_lifetime;
+    // 重新设置当前壁纸时保留各显示器的分配，从壁纸库选择的图片用于所有显示器
+    QMap<QString, QString> screenImages;
+    if (imagePath == m_currentWallpaperPath) {
+        screenImages = m_currentScreenWallpapers;
+    }
+    bool success = co_await setWallpaper(imagePath, screenImages, token);
+    if (token.isCancelled()) {
+        co_return;
+    }
+    if (!success) {
+        emit wallpaperApplyFailed(imagePath);
+        co_return;
+    }
+    m_currentWallpaperPath = imagePath;
+    m_currentScreenWallpapers = screenImages;
+    emit wallpaperSet(imagePath);
+    if (!m_library->entry(imagePath).isAnalyzed()) {
+        Async::spawn(analyzeWallpaper(imagePath));
+    }
+}
+
+void BingWallpaperSetter::setProgressivePreviewEnabled(bool enabled) {
+    // 窗口隐藏时没有人看预览，不必解码
+    m_progressivePreviewEnabled = enabled;
+    if (m_activePreview) {
+        m_activePreview->setEnabled(enabled);
+    }
+}
+
+QNetworkRequest BingWallpaperSetter::createRequest(const QUrl &url) const {
+    QNetworkRequest request(url);
+    request.setHeader(QNetworkRequest::UserAgentHeader, "Mozilla/5.0");
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+    // 与预热连接使用相同的 TLS 配置，否则连接无法复用
+    if (url.scheme() == "https") {
+        request.setSslConfiguration(m_sslConfiguration);
+    }
+    return request;
+}
+
+void BingWallpaperSetter::prewarmConnections() {
+    // 测量优化效果时用来得到未预热的对照数据
+    if (qEnvironmentVariableIsSet("BING_WALLPAPER_NO_PREWARM")) {
+        return;
+    }
+    // 正在请求时连接已经建立
+    if (!m_jobs.isEmpty()) {
+        return;
+    }
+    // 计费网络下自动更新会被推迟，不必预先握手
+    if (m_downloadPolicy->decide(false) == DownloadPolicy::Defer) {
+        return;
+    }
+    
+    // 对冲请求通常只会用到前两个地址
+    const QStringList endpoints = m_endpointStats->orderedEndpoints().mid(0, 2);
+    for (const QString &endpoint : endpoints) {
+        QUrl url(endpoint);
+        if (url.scheme() == "https") {
+            if (!QSslSocket::supportsSsl()) {
+                continue;
+            }
+            m_networkManager->connectToHostEncrypted(url.host(), url.port(443), m_sslConfiguration);
+        } else {
+            m_networkManager->connectToHost(url.host(), url.port(80));
+        }
+        Metrics::instance()->incrementCounter("bing_wallpaper_prewarm_total");
+        qDebug() << "预热连接:" << url.host();
+    }
+}
+
+Async::HedgedAwaiter BingWallpaperSetter::startHedgedRequest(const QString &path, const QString &requestKind,
+                                                             const Async::CancellationToken &token) {
+    HedgedRequest *request = new HedgedRequest(m_networkManager, m_endpointStats, path,
+                                               [this](const QUrl &url) { return createRequest(url); }, this);
+    connect(request, &HedgedRequest::attemptStarted, this, [this, requestKind](QNetworkReply *reply) {
+        trackTimeToFirstByte(reply, requestKind);
+    });
+    // 结果只会在之后的事件循环中到达，先启动再等待不会错过
+    request->start();
+    return Async::awaitHedged(request, token);
+}
+
+void BingWallpaperSetter::trackTimeToFirstByte(QNetworkReply *reply, const QString &requestKind) {
+    QElapsedTimer timer;
+    timer.start();
+    QString metric = QString("bing_wallpaper_ttfb_ms{host=\"%1\",request=\"%2\"}")
+                         .arg(reply->url().host(), requestKind);
+    
+    // 重定向时响应头会多次到达，只记录第一次
+    connect(reply, &QNetworkReply::metaDataChanged, this, [reply, timer, metric]() {
+        if (reply->property("ttfbRecorded").toBool()) {
+            return;
+        }
+        reply->setProperty("ttfbRecorded", true);
+        Metrics::instance()->observe(metric, timer.elapsed(), {25, 50, 100, 200, 400, 800, 1600, 3200});
+        
+        bool http2 = reply->attribute(QNetworkRequest::Http2WasUsedAttribute).toBool();
+        Metrics::instance()->incrementCounter(QString("bing_wallpaper_requests_total{protocol=\"%1\"}")
+                                                  .arg(http2 ? "h2" : "http/1.1"));
+    });
+}
+
+static QString sessionTicketPath() {
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/tls_session";
+}
+
+void BingWallpaperSetter::loadSessionTicket() {
+    // 文件格式：第一行为过期时间（秒），其余为票据内容
+    QFile file(sessionTicketPath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    qint64 expiry = file.readLine().trimmed().toLongLong();
+    QByteArray ticket = file.readAll();
+    if (ticket.isEmpty() || expiry <= QDateTime::currentSecsSinceEpoch()) {
+        return;
+    }
+    m_sslConfiguration.setSessionTicket(ticket);
+}
+
+void BingWallpaperSetter::saveSessionTicket(QNetworkReply *reply) {
+    QSslConfiguration config = reply->sslConfiguration();
+    QByteArray ticket = config.sessionTicket();
+    if (ticket.isEmpty() || ticket == m_sslConfiguration.sessionTicket()) {
+        return;
+    }
+    m_sslConfiguration.setSessionTicket(ticket);
+    
+    int lifetime = config.sessionTicketLifeTimeHint();
+    if (lifetime <= 0) {
+        return;
+    }
+    
+    QDir().mkpath(QFileInfo(sessionTicketPath()).absolutePath());
+    QSaveFile file(sessionTicketPath());
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    // 票据可以恢复会话密钥，只允许本人读取
+    file.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+    file.write(QByteArray::number(QDateTime::currentSecsSinceEpoch() + lifetime) + "\n");
+    file.write(ticket);
+    file.commit();
+}
+
+QString BingWallpaperSetter::variantDirectory() const {
+    // 衍生图片放在隐藏子目录，避免被当作壁纸导入壁纸库
+    return m_wallpaperDir + "/.variants";
+}
+
+Async::Task<void> BingWallpaperSetter::analyzeWallpaper(QString imagePath) {
+    Async::CancellationToken token = m_lifetime;
+    WallpaperInfo info = m_library->entry(imagePath);
+    info.filePath = imagePath;
+    QString variantDir = variantDirectory();
+    
+    auto analyze = [&info, variantDir]() {
+        return ImageAnalyzer::analyzeFile(info.filePath, variantDir, info);
+    };
+    bool analyzed = co_await Async::runInThread(std::move(analyze));
+    if (token.isCancelled() || !analyzed) {
+        co_return;
+    }
+    onAnalysisFinished(info);
+}
+
+void BingWallpaperSetter::onAnalysisFinished(const WallpaperInfo &result) {
+    // 只更新分析字段，其余元数据以壁纸库中的为准
+    WallpaperInfo info = m_library->contains(result.filePath) ? m_library->entry(result.filePath) : result;
+    info.luminance = result.luminance;
+    info.busyness = result.busyness;
+    info.palette = result.palette;
+    info.darkVariantPath = result.darkVariantPath;
+    m_library->addOrUpdate(info);
+    
+    // 分析在壁纸设置之后才完成，补设暗色壁纸和背景色
+    QString desktop = detectDesktopEnvironment();
+    if (result.filePath == m_currentWallpaperPath && (desktop == "gnome" || desktop == "unknown")) {
+        Async::spawn(refreshGnomeAppearance(result.filePath));
+    }
+}
+
+Async::Task<void> BingWallpaperSetter::refreshGnomeAppearance(QString imagePath) {
+    Async::CancellationToken token = m_lifetime;
+    auto guard = co_await m_applyMutex->lock();
+    // 等待期间用户可能已经切换了壁纸
+    if (token.isCancelled() || imagePath != m_currentWallpaperPath) {
+        co_return;
+    }
+    co_await applyGnomeAppearance(imagePath, token);
+}
+
+void BingWallpaperSetter::downloadAndSetWallpaper(int button, bool userInitiated) {
+    // 预取让出带宽和连接，请求结束后重新计时
+    m_prefetcher->userRequestStarted();
     emit downloadStarted();
     qDebug() << "正在获取Bing今日壁纸信息...";
     
@@ -102,133 +435,607 @@ void BingWallpaperSetter::downloadAndSetWallpaper(int button) {
         m_currentOffset = 7;
     }
     
-    QString url = m_bingApiUrl.arg(QString::number(m_currentOffset));
-    QNetworkRequest request;
-    request.setUrl(QUrl(url));
-    request.setHeader(QNetworkRequest::UserAgentHeader, "Mozilla/5.0");
+    // 同一天的壁纸已在下载时不重复请求，改由它设置壁纸并报告进度
+    int reusedJobId = -1;
+    for (auto it = m_jobs.cbegin(); it != m_jobs.cend(); ++it) {
+        if (it->supersedable && it->offset == m_currentOffset && it->market == m_market) {
+            reusedJobId = it.key();
+            break;
+        }
+    }
+    // 连续翻页时之前的请求已经用不上，不再和这一次争抢带宽
+    cancelSupersededJobs(reusedJobId);
+    if (reusedJobId >= 0) {
+        m_latestJobId = reusedJobId;
+        return;
+    }
     
-    m_currentReply = m_networkManager->get(request);
-    connect(m_currentReply, &QNetworkReply::finished, this, &BingWallpaperSetter::onApiReplyFinished);
+    Job job;
+    job.id = m_nextJobId++;
+    job.offset = m_currentOffset;
+    job.market = m_market;
+    job.userInitiated = userInitiated;
+    job.supersedable = true;
+    m_jobs.insert(job.id, job);
+    m_latestJobId = job.id;
+    Async::spawn(runJob(job));
 }
 
-void BingWallpaperSetter::onApiReplyFinished() {
-    if (!m_currentReply) return;
-    
-    if (m_currentReply->error() != QNetworkReply::NoError) {
-        QString errorMsg = "API请求失败: " + m_currentReply->errorString();
-        qDebug() << errorMsg;
-        emit downloadFinished(false, errorMsg, m_currentOffset);
-        m_currentReply->deleteLater();
-        m_currentReply = nullptr;
+bool BingWallpaperSetter::isLatestJob(const Job &job) const {
+    return job.id == m_latestJobId;
+}
+
+void BingWallpaperSetter::cancelSupersededJobs(int keepJobId) {
+    QList<Async::CancellationToken> superseded;
+    for (auto it = m_jobs.begin(); it != m_jobs.end();) {
+        // 正在设置壁纸的请求让它完成，中途结束外部命令可能让桌面停在设置了一半的状态
+        if (!it->supersedable || it->applying || it.key() == keepJobId) {
+            ++it;
+            continue;
+        }
+        qDebug() << "取消已被取代的请求:" << it->offset << it->market;
+        Metrics::instance()->incrementCounter("bing_wallpaper_superseded_jobs_total");
+        // 被取消的协程恢复后直接退出，不会再调用 finishJob，这里先移除
+        superseded.append(it->token);
+        it = m_jobs.erase(it);
+    }
+    // 回调可能同步恢复协程，遍历结束后再取消
+    for (Async::CancellationToken &token : superseded) {
+        token.cancel();
+    }
+}
+
+bool BingWallpaperSetter::isReducedRendition(const WallpaperInfo &info) const {
+    return !info.imageUrl.isEmpty() && !info.imageUrl.contains("_UHD");
+}
+
+void BingWallpaperSetter::onDeferralLifted() {
+    if (!m_deferredUpdate) {
         return;
     }
+    m_deferredUpdate = false;
+    qDebug() << "网络和供电条件已允许，补上推迟的自动更新";
+    downloadAndSetWallpaper(0, false);
+}
+
+void BingWallpaperSetter::finishJob(const Job &job, bool success, const QString &message) {
+    m_jobs.remove(job.id);
+    if (m_jobs.isEmpty()) {
+        m_prefetcher->userRequestsFinished();
+    }
+    if (isLatestJob(job)) {
+        emit downloadFinished(success, message, job.offset);
+    }
+}
+
+Async::Task<void> BingWallpaperSetter::runJob(Job job) {
+    // 对象销毁时一并取消
+    Async::CancellationToken::Registration lifetime = m_lifetime.onCancel([token = job.token]() mutable {
+        token.cancel();
+    });
+    
+    WallpaperInfo info;
+    QString imagePath;
+    QString error;
+    QString message;
+    bool cached = false;
+    
+    DownloadPolicy::Decision decision = m_downloadPolicy->decide(job.userInitiated);
+    if (decision != DownloadPolicy::FullQuality) {
+        // 受限时先在壁纸库中找这一天的壁纸，连 API 请求都可以省掉
+        QString date = QDate::currentDate().addDays(-job.offset).toString("yyyyMMdd");
+        WallpaperInfo local = m_library->findByDate(date, job.market);
+        bool intact = false;
+        if (!local.filePath.isEmpty()) {
+            intact = co_await isIntactWallpaper(local.filePath, job.token);
+            if (job.token.isCancelled()) {
+                co_return;
+            }
+        }
+        if (intact) {
+            qDebug() << m_downloadPolicy->constraintDescription() << "，使用壁纸库中的壁纸:" << local.filePath;
+            info = local;
+            cached = true;
+            message = "壁纸已设置（" + m_downloadPolicy->constraintDescription() + "，使用壁纸库）";
+        } else if (decision == DownloadPolicy::Defer) {
+            m_deferredUpdate = true;
+            Metrics::instance()->incrementCounter("bing_wallpaper_deferred_updates_total");
+            finishJob(job, false, "自动更新已推迟：" + m_downloadPolicy->constraintDescription());
+            co_return;
+        }
+    }
+    
+    if (!cached) {
+        // 降级时下载较小的分辨率，条件恢复后再次更新会换成 4K
+        QString resolution = decision == DownloadPolicy::ReducedQuality ? m_downloadPolicy->reducedResolution()
+                                                                          : QString("UHD");
+        bool fetched = co_await fetchWallpaperInfo(job, resolution, info, imagePath, error);
+        if (job.token.isCancelled()) {
+            co_return;
+        }
+        if (!fetched) {
+            qDebug() << error;
+            finishJob(job, false, error);
+            co_return;
+        }
+        
+        // 只有结构完整的文件才直接使用，崩溃时写了一半的文件会被隔离后重新下载
+        WallpaperInfo existing = m_library->entry(info.filePath);
+        if (!(decision == DownloadPolicy::FullQuality && isReducedRendition(existing))) {
+            cached = co_await isIntactWallpaper(info.filePath, job.token);
+            if (job.token.isCancelled()) {
+                co_return;
+            }
+        }
+        if (cached) {
+            // 如果今天的壁纸已存在，直接使用
+            qDebug() << "今日壁纸已存在:" << info.filePath;
+            // 补全旧版本只从文件名导入的元数据
+            if (existing.title.isEmpty()) {
+                m_library->addOrUpdate(info);
+            }
+            message = "壁纸已设置（使用缓存）";
+        }
+    }
+    
+    if (!cached) {
+        // 多用户服务器上优先从共享缓存获取，失败时再自己下载
+        bool shared = co_await fetchFromSharedCache(job, info, imagePath);
+        if (job.token.isCancelled()) {
+            co_return;
+        }
+        if (shared) {
+            shared = co_await isIntactWallpaper(info.filePath, job.token);
+            if (job.token.isCancelled()) {
+                co_return;
+            }
+        }
+        if (shared) {
+            message = "壁纸已从共享缓存获取并设置！";
+        } else {
+            QByteArray imageData = co_await downloadImage(job, imagePath, error);
+            if (job.token.isCancelled()) {
+                co_return;
+            }
+            if (imageData.isEmpty()) {
+                qDebug() << error;
+                finishJob(job, false, error);
+                co_return;
+            }
+            
+            qDebug() << "壁纸将保存到:" << info.filePath;
+            if (!writeWallpaperFile(info.filePath, imageData, error)) {
+                qDebug() << error;
+                finishJob(job, false, error);
+                co_return;
+            }
+            qDebug() << "壁纸已保存到:" << info.filePath;
+            message = "壁纸下载并设置成功！";
+        }
+        m_library->addOrUpdate(info);
+        // 新文件已就位，之前隔离的损坏文件不再需要
+        QFile::remove(quarantinePath(info.filePath));
+    }
+    
+    // 清理旧壁纸
+    //cleanupOldWallpapers(7);
+    
+    // 已被更新的请求取代时只保存到壁纸库，不再设置壁纸
+    bool apply = isLatestJob(job);
+    QMap<QString, QString> screenImages;
+    if (apply) {
+        // 按配置为其他显示器准备前几天或其他地区的壁纸
+        screenImages = co_await prepareScreenWallpapers(job);
+        if (job.token.isCancelled()) {
+            co_return;
+        }
+        apply = isLatestJob(job);
+    }
+    if (apply) {
+        m_jobs[job.id].applying = true;
+        bool applied = co_await setWallpaper(info.filePath, screenImages, job.token);
+        if (job.token.isCancelled()) {
+            co_return;
+        }
+        if (!applied) {
+            finishJob(job, false, cached ? "设置壁纸失败" : "壁纸下载成功但设置失败");
+            co_return;
+        }
+        m_currentWallpaperPath = info.filePath;
+        m_currentScreenWallpapers = screenImages;
+        emit wallpaperSet(info.filePath);
+    } else {
+        qDebug() << "请求已被取代，壁纸只保存到壁纸库:" << info.filePath;
+    }
+    finishJob(job, true, message);
     
-    QByteArray data = m_currentReply->readAll();
-    m_currentReply->deleteLater();
-    m_currentReply = nullptr;
+    if (!m_library->entry(info.filePath).isAnalyzed()) {
+        Async::spawn(analyzeWallpaper(info.filePath));
+    }
+}
+
+Async::Task<bool> BingWallpaperSetter::fetchWallpaperInfo(const Job &job, const QString &resolution,
+                                                          WallpaperInfo &info, QString &imagePath, QString &error) {
+    QString path = m_bingApiUrl.arg(QString::number(job.offset), job.market);
+    
+    Async::HedgedResult hedged = co_await startHedgedRequest(path, "api", job.token);
+    if (job.token.isCancelled()) {
+        co_return false;
+    }
+    if (!hedged.reply) {
+        error = "API请求失败: " + hedged.error;
+        co_return false;
+    }
+    
+    QNetworkReply *reply = co_await Async::awaitReply(hedged.reply, job.token);
+    if (job.token.isCancelled()) {
+        co_return false;
+    }
+    reply->deleteLater();
+    if (reply->error() != QNetworkReply::NoError) {
+        error = "API请求失败: " + reply->errorString();
+        co_return false;
+    }
+    
+    QByteArray data = reply->readAll();
+    saveSessionTicket(reply);
     
     QJsonDocument doc = QJsonDocument::fromJson(data);
     if (doc.isNull() || !doc.isObject()) {
-        emit downloadFinished(false, "解析API响应失败", m_currentOffset);
-        return;
+        error = "解析API响应失败";
+        co_return false;
     }
     
     QJsonObject obj = doc.object();
     QJsonArray images = obj["images"].toArray();
     
     if (images.isEmpty()) {
-        emit downloadFinished(false, "未找到壁纸信息", m_currentOffset);
-        return;
+        error = "未找到壁纸信息";
+        co_return false;
     }
     
     QJsonObject imageInfo = images[0].toObject();
-    QString imageUrl = "https://www.bing.com" + imageInfo["url"].toString();
+    imagePath = imageInfo["url"].toString();
     QString imageTitle = imageInfo["title"].toString();
+    QString fullCopyright = imageInfo["copyright"].toString();
     
-    QStringList cr = imageInfo["copyright"].toString().split('(');
+    QStringList cr = fullCopyright.split('(');
     QString imageCopyright = cr[0].replace(QChar(0xFF0C), '_').remove(' ');
     QString imageDate = imageInfo["startdate"].toString();
     
-    // 替换为4K分辨率 (3840x2160)
-    imageUrl.replace(QRegExp("\\d+x\\d+"), "UHD");
+    // 替换为4K分辨率 (3840x2160)，受限时为较小的分辨率
+    static const QRegularExpression resolutionPattern("\\d+x\\d+");
+    imagePath.replace(resolutionPattern, resolution);
+    QString imageUrl = hedged.endpoint + imagePath;
     
     qDebug() << "壁纸标题:" << imageTitle;
-    qDebug() << "下载链接(4K):" << imageUrl;
+    qDebug() << "下载链接(" + resolution + "):" << imageUrl;
     
     // 生成文件名
     //QString dateStr = QDateTime::currentDateTime().toString("yyyyMMdd");
     QString filename = QString("bing_wallpaper_%1_%2.jpg").arg(imageDate).arg(imageCopyright);
-    m_currentWallpaperPath = m_wallpaperDir + "/" + filename;
-    
-    // 如果今天的壁纸已存在，直接使用
-    if (QFile::exists(m_currentWallpaperPath)) {
-        qDebug() << "今日壁纸已存在:" << m_currentWallpaperPath;
-        if (setWallpaper(m_currentWallpaperPath)) {
-            emit wallpaperSet(m_currentWallpaperPath);
-            emit downloadFinished(true, "壁纸已设置（使用缓存）", m_currentOffset);
-        } else {
-            emit downloadFinished(false, "设置壁纸失败", m_currentOffset);
-        }
-        return;
+    
+    info = WallpaperInfo();
+    info.filePath = m_wallpaperDir + "/" + filename;
+    info.date = imageDate;
+    info.title = imageTitle;
+    info.copyright = fullCopyright;
+    info.location = WallpaperInfo::locationFromCopyright(fullCopyright);
+    info.market = job.market;
+    info.imageUrl = imageUrl;
+    co_return true;
+}
+
+Async::Task<bool> BingWallpaperSetter::fetchFromSharedCache(const Job &job, const WallpaperInfo &info,
+                                                            const QString &imagePath) {
+    WallpaperCacheClient client;
+    if (!client.isAvailable()) {
+        co_return false;
     }
     
-    // 下载壁纸
+    qDebug() << "正在从共享缓存获取壁纸...";
+    // 连接失败时 finished 可能在 fetch() 中直接发出，先开始等待
+    auto finished = Async::awaitSignal(&client, &WallpaperCacheClient::finished, job.token);
+    client.fetch(info.date, job.market, imagePath, info.filePath);
+    auto result = co_await finished;
+    if (!result) {
+        co_return false;
+    }
+    
+    bool success = std::get<0>(*result);
+    if (!success) {
+        qDebug() << "共享缓存不可用，直接下载:" << std::get<1>(*result);
+    }
+    co_return success;
+}
+
+Async::Task<QByteArray> BingWallpaperSetter::downloadImage(const Job &job, const QString &imagePath, QString &error) {
     qDebug() << "正在下载壁纸...";
-    QNetworkRequest request;
-    request.setUrl(QUrl(imageUrl));
-    request.setHeader(QNetworkRequest::UserAgentHeader, "Mozilla/5.0");
     
-    m_currentReply = m_networkManager->get(request);
-    connect(m_currentReply, &QNetworkReply::finished, this, &BingWallpaperSetter::onImageDownloadFinished);
-    connect(m_currentReply, &QNetworkReply::downloadProgress, this, &BingWallpaperSetter::onDownloadProgress);
+    // 只对响应头做对冲，响应体只从胜出的地址下载
+    Async::HedgedResult hedged = co_await startHedgedRequest(imagePath, "image", job.token);
+    if (job.token.isCancelled()) {
+        co_return QByteArray();
+    }
+    if (!hedged.reply) {
+        error = "壁纸下载失败: " + hedged.error;
+        co_return QByteArray();
+    }
+    
+    // 预览和进度只显示最新的请求
+    const int jobId = job.id;
+    ProgressivePreview preview(QSize(640, 280));
+    preview.setEnabled(m_progressivePreviewEnabled);
+    preview.reset();
+    connect(&preview, &ProgressivePreview::previewAvailable, this, [this, jobId](const QImage &image) {
+        if (jobId == m_latestJobId) {
+            emit downloadPreviewAvailable(image);
+        }
+    });
+    if (isLatestJob(job)) {
+        m_activePreview = &preview;
+    }
+    
+    TransferMonitor monitor;
+    monitor.setStallTimeout(m_stallTimeoutMs);
+    connect(&monitor, &TransferMonitor::progressUpdated, this,
+            [this, jobId](int percentage, double bytesPerSecond, int etaSeconds) {
+        if (jobId == m_latestJobId) {
+            emit downloadProgress(percentage);
+            emit downloadRateChanged(bytesPerSecond, etaSeconds);
+        }
+    });
+    
+    QNetworkReply *reply = hedged.reply;
+    qint64 resumeOffset = 0;
+    int stallRetries = 0;
+    bool stalled = false;
+    bool restarted = false;
+    // 续传时用 If-Range 确认服务器上仍是同一个文件，文件已变化时服务器会返回完整内容；
+    // 弱 ETag 不能用于 If-Range
+    QByteArray validator = reply->rawHeader("ETag");
+    if (validator.isEmpty() || validator.startsWith("W/")) {
+        validator = reply->rawHeader("Last-Modified");
+    }
+    const qint64 expectedTotal = reply->header(QNetworkRequest::ContentLengthHeader).toLongLong();
+    monitor.start();
+    
+    while (true) {
+        connect(reply, &QNetworkReply::readyRead, &preview, [&preview, reply]() {
+            preview.append(reply->readAll());
+        });
+        // 断点续传时进度只包含本次请求的部分
+        connect(reply, &QNetworkReply::downloadProgress, &monitor,
+                [&monitor, &resumeOffset](qint64 bytesReceived, qint64 bytesTotal) {
+            monitor.update(resumeOffset + bytesReceived, bytesTotal > 0 ? resumeOffset + bytesTotal : -1);
+        });
+        // 保留已收到的数据后中止，由下面的循环断点续传
+        connect(&monitor, &TransferMonitor::stalled, reply, [&stalled, &preview, reply]() {
+            stalled = true;
+            preview.append(reply->readAll());
+            reply->abort();
+        });
+        
+        co_await Async::awaitReply(reply, job.token);
+        if (job.token.isCancelled()) {
+            co_return QByteArray();
+        }
+        monitor.disconnect(reply);
+        reply->deleteLater();
+        
+        if (!stalled && !restarted) {
+            if (reply->error() != QNetworkReply::NoError) {
+                monitor.finish(false);
+                error = "壁纸下载失败: " + reply->errorString();
+                co_return QByteArray();
+            }
+            // 数据已在 readyRead 中陆续读入预览缓冲区
+            preview.append(reply->readAll());
+            monitor.finish(true);
+            co_return preview.takeData();
+        }
+        
+        if (++stallRetries > MAX_STALL_RETRIES) {
+            monitor.finish(false);
+            error = "壁纸下载停滞，已多次重试失败";
+            co_return QByteArray();
+        }
+        
+        stalled = false;
+        restarted = false;
+        resumeOffset = preview.bufferedBytes();
+        qDebug() << "从" << resumeOffset << "字节处重试，第" << stallRetries << "次";
+        if (isLatestJob(job)) {
+            emit downloadRetrying(stallRetries);
+        }
+        
+        QNetworkRequest request = createRequest(QUrl(hedged.endpoint + imagePath));
+        if (resumeOffset > 0) {
+            request.setRawHeader("Range", "bytes=" + QByteArray::number(resumeOffset) + "-");
+            if (!validator.isEmpty()) {
+                request.setRawHeader("If-Range", validator);
+            }
+        }
+        reply = m_networkManager->get(request);
+        connect(reply, &QNetworkReply::metaDataChanged, &preview,
+                [&preview, &monitor, &resumeOffset, &restarted, expectedTotal, reply]() {
+            if (resumeOffset <= 0) {
+                return;
+            }
+            int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+            if (status == 200) {
+                // 服务器不支持 Range 或文件已变化时返回完整内容，丢弃已下载的部分
+                qDebug() << "服务器返回完整内容，重新下载";
+                preview.reset();
+                resumeOffset = 0;
+                monitor.rebase();
+            } else if (status == 206 && !continuesFrom(reply->rawHeader("Content-Range"), resumeOffset, expectedTotal)) {
+                // 不能把另一个文件的内容接在已下载部分后面，中止后从头下载
+                qDebug() << "续传内容与已下载部分不匹配:" << reply->rawHeader("Content-Range");
+                preview.reset();
+                resumeOffset = 0;
+                monitor.rebase();
+                restarted = true;
+                reply->abort();
+            }
+        });
+        monitor.restartStallTimer();
+    }
 }
 
-void BingWallpaperSetter::onDownloadProgress(qint64 bytesReceived, qint64 bytesTotal) {
-    if (bytesTotal > 0) {
-        int percentage = (bytesReceived * 100) / bytesTotal;
-        emit downloadProgress(percentage);
+bool BingWallpaperSetter::writeWallpaperFile(const QString &filePath, const QByteArray &data, QString &error) {
+    // 连接被中途关闭时可能收到不完整的内容，写入前先检查
+    JpegVerifier::Status status = JpegVerifier::verify(reinterpret_cast<const uint8_t *>(data.constData()),
+                                                       static_cast<size_t>(data.size()));
+    if (status != JpegVerifier::Status::Ok) {
+        error = QString("下载的壁纸不完整（%1）").arg(JpegVerifier::statusName(status));
+        return false;
+    }
+    
+    // 先写入临时文件再替换，崩溃或断电时不会留下写了一半的壁纸
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        error = "保存壁纸失败";
+        return false;
     }
+    file.write(data);
+    if (!file.commit()) {
+        error = "保存壁纸失败";
+        return false;
+    }
+    return true;
 }
 
-void BingWallpaperSetter::onImageDownloadFinished() {
-    if (!m_currentReply) return;
+Async::Task<bool> BingWallpaperSetter::isIntactWallpaper(QString imagePath, Async::CancellationToken token) {
+    if (!QFile::exists(imagePath)) {
+        co_return false;
+    }
     
-    if (m_currentReply->error() != QNetworkReply::NoError) {
-        QString errorMsg = "壁纸下载失败: " + m_currentReply->errorString();
-        qDebug() << errorMsg;
-        emit downloadFinished(false, errorMsg, m_currentOffset);
-        m_currentReply->deleteLater();
-        m_currentReply = nullptr;
+    auto verify = [imagePath]() {
+        return IntegrityScanner::verifyFile(imagePath);
+    };
+    JpegVerifier::Status status = co_await Async::runInThread(std::move(verify));
+    if (token.isCancelled()) {
+        co_return false;
+    }
+    if (status == JpegVerifier::Status::Ok) {
+        co_return true;
+    }
+    qDebug() << "壁纸文件已损坏，需要重新下载:" << imagePath << JpegVerifier::statusName(status);
+    quarantineWallpaper(imagePath);
+    co_return false;
+}
+
+QString BingWallpaperSetter::quarantinePath(const QString &imagePath) const {
+    // 放在同一目录下，重命名不跨文件系统；隐藏目录不会被导入壁纸库
+    QFileInfo fileInfo(imagePath);
+    return fileInfo.absolutePath() + "/.quarantine/" + fileInfo.fileName();
+}
+
+bool BingWallpaperSetter::quarantineWallpaper(const QString &imagePath) {
+    QString target = quarantinePath(imagePath);
+    QDir().mkpath(QFileInfo(target).absolutePath());
+    QFile::remove(target);
+    if (!QFile::rename(imagePath, target)) {
+        qDebug() << "隔离损坏的壁纸失败:" << imagePath;
+        return false;
+    }
+    qDebug() << "已隔离损坏的壁纸:" << target;
+    Metrics::instance()->incrementCounter("bing_wallpaper_quarantined_files_total");
+    return true;
+}
+
+void BingWallpaperSetter::verifyLibrary(bool force) {
+    if (m_verifyingLibrary) {
+        qDebug() << "壁纸库正在检查中";
         return;
     }
+    Async::spawn(runLibraryVerification(force));
+}
+
+Async::Task<void> BingWallpaperSetter::runLibraryVerification(bool force) {
+    Async::CancellationToken token = m_lifetime;
+    m_verifyingLibrary = true;
     
-    QByteArray imageData = m_currentReply->readAll();
-    m_currentReply->deleteLater();
-    m_currentReply = nullptr;
+    const QVector<WallpaperInfo> entries = m_library->entries();
+    QStringList paths;
+    for (const WallpaperInfo &entry : entries) {
+        paths.append(entry.filePath);
+    }
     
-    qDebug() << "壁纸将保存到:" << m_currentWallpaperPath;
-    // 保存壁纸
-    QFile file(m_currentWallpaperPath);
-    if (!file.open(QIODevice::WriteOnly)) {
-        emit downloadFinished(false, "保存壁纸失败", m_currentOffset);
-        return;
+    IntegrityScanner::Report report = co_await m_integrityScanner->scan(paths, force, token);
+    if (token.isCancelled()) {
+        co_return;
+    }
+    for (const QString &path : std::as_const(report.corruptFiles)) {
+        quarantineWallpaper(path);
     }
     
-    file.write(imageData);
-    file.close();
+    // 隔离区中的壁纸都尝试重新下载，包括之前因网络受限没能补上的
+    for (const WallpaperInfo &entry : entries) {
+        if (QFile::exists(entry.filePath) || !QFile::exists(quarantinePath(entry.filePath))) {
+            continue;
+        }
+        if (entry.imageUrl.isEmpty()) {
+            qDebug() << "损坏的壁纸没有下载地址，从壁纸库移除:" << entry.filePath;
+            m_library->remove(entry.filePath);
+            continue;
+        }
+        if (m_downloadPolicy->decide(false) != DownloadPolicy::FullQuality) {
+            qDebug() << m_downloadPolicy->constraintDescription() << "，下次检查时再重新下载损坏的壁纸";
+            break;
+        }
+        co_await redownloadWallpaper(entry);
+        if (token.isCancelled()) {
+            co_return;
+        }
+    }
     
-    qDebug() << "壁纸已保存到:" << m_currentWallpaperPath;
+    m_verifyingLibrary = false;
+    emit libraryVerified(report.scanned + report.skipped, report.corruptFiles.size());
+}
+
+Async::Task<bool> BingWallpaperSetter::redownloadWallpaper(WallpaperInfo info) {
+    // 作为不是最新的请求运行：不报告进度，也不设置壁纸
+    Job job;
+    job.id = m_nextJobId++;
+    job.offset = -1;
+    job.market = info.market;
+    job.userInitiated = false;
+    m_jobs.insert(job.id, job);
+    Async::CancellationToken::Registration lifetime = m_lifetime.onCancel([token = job.token]() mutable {
+        token.cancel();
+    });
     
-    // 清理旧壁纸
-    //cleanupOldWallpapers(7);
+    // 下载地址可能来自其他服务器地址，只取路径部分交给对冲请求
+    QUrl url(info.imageUrl);
+    QString imagePath = url.path(QUrl::FullyEncoded);
+    if (url.hasQuery()) {
+        imagePath += "?" + url.query(QUrl::FullyEncoded);
+    }
+    qDebug() << "重新下载损坏的壁纸:" << info.filePath;
     
-    // 设置壁纸
-    if (setWallpaper(m_currentWallpaperPath)) {
-        emit wallpaperSet(m_currentWallpaperPath);
-        emit downloadFinished(true, "壁纸下载并设置成功！", m_currentOffset);
-    } else {
-        emit downloadFinished(false, "壁纸下载成功但设置失败", m_currentOffset);
+    QString error;
+    QByteArray imageData = co_await downloadImage(job, imagePath, error);
+    if (job.token.isCancelled()) {
+        co_return false;
+    }
+    bool saved = !imageData.isEmpty() && writeWallpaperFile(info.filePath, imageData, error);
+    finishJob(job, saved, error);
+    if (!saved) {
+        qDebug() << "重新下载失败:" << error;
+        co_return false;
     }
+    
+    QFile::remove(quarantinePath(info.filePath));
+    qDebug() << "已重新下载:" << info.filePath;
+    if (info.filePath == m_currentWallpaperPath) {
+        // 桌面上显示的正是损坏的文件，重新设置一次
+        Async::spawn(applyFromFile(info.filePath));
+    } else if (!info.isAnalyzed()) {
+        Async::spawn(analyzeWallpaper(info.filePath));
+    }
+    co_return true;
 }
 
 void BingWallpaperSetter::cleanupOldWallpapers(int keepDays) {
@@ -259,99 +1066,491 @@ QString BingWallpaperSetter::detectDesktopEnvironment() {
     return "unknown";
 }
 
-bool BingWallpaperSetter::setWallpaperGnome(const QString &imagePath) {
-    QString fileUri = "file://" + imagePath;
-    
-    // 设置壁纸
-    QProcess process;
-    process.start("gsettings", QStringList() << "set" << "org.gnome.desktop.background" 
-                  << "picture-uri" << fileUri);
-    if (!process.waitForFinished(3000) || process.exitCode() != 0) {
-        qDebug() << "设置picture-uri失败";
-        return false;
+Async::Task<bool> BingWallpaperSetter::applyGSettings(QString schema, QList<WallpaperCommands::GSetting> settings,
+                                                      int timeoutMs, Async::CancellationToken token) {
+    for (const WallpaperCommands::GSetting &setting : settings) {
+        QStringList arguments = WallpaperCommands::gsettingsArguments(schema, setting);
+        Async::ProcessResult result = co_await Async::runProcess("gsettings", arguments, timeoutMs, token);
+        if (token.isCancelled()) {
+            co_return false;
+        }
+        if (!result.succeeded()) {
+            qDebug() << QString("设置%1失败").arg(setting.key);
+            if (setting.required) {
+                co_return false;
+            }
+        }
     }
-    
-    // 设置暗色主题壁纸
-    process.start("gsettings", QStringList() << "set" << "org.gnome.desktop.background" 
-                  << "picture-uri-dark" << fileUri);
-    if (!process.waitForFinished(3000) || process.exitCode() != 0) {
-        qDebug() << "设置picture-uri-dark失败";
+    co_return true;
+}
+
+QString BingWallpaperSetter::gnomeDarkPath(const QString &imagePath) const {
+    // 未分析过的图片暗色模式沿用原图，分析完成后会再次设置
+    if (!m_spannedWallpaperPath.isEmpty()) {
+        // 暗色版本只有单张图片的，跨屏时暗色模式也使用合成图
+        return m_spannedWallpaperPath;
     }
-    
-    // 设置壁纸显示选项为缩放
-    process.start("gsettings", QStringList() << "set" << "org.gnome.desktop.background" 
-                  << "picture-options" << "zoom");
-    if (!process.waitForFinished(3000) || process.exitCode() != 0) {
-        qDebug() << "设置picture-options失败";
+    QString darkPath = m_library->entry(imagePath).darkVariantPath;
+    return !darkPath.isEmpty() && QFile::exists(darkPath) ? darkPath : imagePath;
+}
+
+Async::Task<bool> BingWallpaperSetter::setWallpaperGnome(QString imagePath, QString spannedPath,
+                                                         Async::CancellationToken token) {
+    // 壁纸、暗色主题壁纸和背景色、显示选项依次设置
+    QList<WallpaperCommands::GSetting> settings =
+        WallpaperCommands::gnome(spannedPath.isEmpty() ? imagePath : spannedPath, !spannedPath.isEmpty(),
+                                 gnomeDarkPath(imagePath), m_library->entry(imagePath).palette);
+    bool success = co_await applyGSettings(WallpaperCommands::GNOME_SCHEMA, settings, 3000, token);
+    if (!success) {
+        co_return false;
     }
     
     qDebug() << "GNOME壁纸设置成功";
-    return true;
+    co_return true;
 }
 
-bool BingWallpaperSetter::setWallpaperUkui(const QString &imagePath) {
-    //QString fileUri = "file://"imagePath;
-    // 设置壁纸
-    QProcess process;
-    process.start("gsettings", QStringList() << "set" << "org.mate.background"
-                  << "picture-filename" << imagePath);
-    if (!process.waitForFinished(-1) || process.exitCode() != 0) {
-        qDebug() << "设置picture-filename失败";
-        return false;
-    }
-    // 设置壁纸显示选项为缩放
-    process.start("gsettings", QStringList() << "set" << "org.mate.background"
-                  << "picture-options" << "zoom");
-    if (!process.waitForFinished(-1) || process.exitCode() != 0) {
-        qDebug() << "设置picture-options失败";
+Async::Task<void> BingWallpaperSetter::applyGnomeAppearance(QString imagePath, Async::CancellationToken token) {
+    QList<WallpaperCommands::GSetting> settings =
+        WallpaperCommands::gnomeAppearance(gnomeDarkPath(imagePath), m_library->entry(imagePath).palette);
+    co_await applyGSettings(WallpaperCommands::GNOME_SCHEMA, settings, 3000, token);
+}
+
+Async::Task<bool> BingWallpaperSetter::setWallpaperUkui(QString imagePath, QString spannedPath,
+                                                        Async::CancellationToken token) {
+    QList<WallpaperCommands::GSetting> settings =
+        WallpaperCommands::ukui(spannedPath.isEmpty() ? imagePath : spannedPath, !spannedPath.isEmpty());
+    bool success = co_await applyGSettings(WallpaperCommands::UKUI_SCHEMA, settings, -1, token);
+    if (!success) {
+        co_return false;
     }
     qDebug() << "UKUI壁纸设置成功";
-    return true;
+    co_return true;
 }
 
-bool BingWallpaperSetter::setWallpaperKde(const QString &imagePath) {
-    QString script = QString(R"(
-var allDesktops = desktops();
-for (i=0; i<allDesktops.length; i++) {
-    d = allDesktops[i];
-    d.wallpaperPlugin = "org.kde.image";
-    d.currentConfigGroup = Array("Wallpaper", "org.kde.image", "General");
-    d.writeConfig("Image", "file://%1");
-}
-)").arg(imagePath);
-    
-    QProcess process;
-    process.start("qdbus", QStringList() << "org.kde.plasmashell" << "/PlasmaShell"
-                  << "org.kde.PlasmaShell.evaluateScript" << script);
+Async::Task<bool> BingWallpaperSetter::setWallpaperKde(QString imagePath, QMap<QString, QString> screenImages,
+                                                       Async::CancellationToken token) {
+    // Plasma 的屏幕编号与 Qt 的顺序不一定相同，按屏幕左上角坐标找到每个桌面容器对应的图片
+    QMap<QString, QString> imagesByOrigin;
+    const QList<QScreen *> screens = QGuiApplication::screens();
+    for (QScreen *screen : screens) {
+        auto it = screenImages.constFind(screen->name());
+        if (it != screenImages.constEnd()) {
+            QPoint origin = screen->geometry().topLeft();
+            imagesByOrigin[QString("%1,%2").arg(origin.x()).arg(origin.y())] = it.value();
+        }
+    }
+    QStringList arguments = WallpaperCommands::qdbusArguments(WallpaperCommands::plasmaScript(imagePath, imagesByOrigin));
     
-    if (!process.waitForFinished(5000) || process.exitCode() != 0) {
+    Async::ProcessResult result = co_await Async::runProcess("qdbus", arguments, 5000, token);
+    if (token.isCancelled()) {
+        co_return false;
+    }
+    if (!result.succeeded()) {
         qDebug() << "设置KDE壁纸失败";
-        return false;
+        co_return false;
     }
     
     qDebug() << "KDE壁纸设置成功";
-    return true;
+    co_return true;
 }
 
-bool BingWallpaperSetter::setWallpaper(const QString &imagePath) {
+Async::Task<bool> BingWallpaperSetter::setWallpaper(QString imagePath, QMap<QString, QString> screenImages,
+                                                    Async::CancellationToken token) {
     if (!QFile::exists(imagePath)) {
         qDebug() << "壁纸文件不存在:" << imagePath;
-        return false;
+        co_return false;
+    }
+    
+    // 多个请求同时设置壁纸时依次执行外部命令，避免互相覆盖
+    auto guard = co_await m_applyMutex->lock();
+    if (token.isCancelled()) {
+        co_return false;
     }
     
     QString desktop = detectDesktopEnvironment();
     qDebug() << "检测到桌面环境:" << desktop;
     
+    // KDE 可以为每个桌面容器单独设置，其他桌面只能设置一张跨屏合成图
+    QString spannedPath;
+    if (!screenImages.isEmpty() && desktop != "kde" && QGuiApplication::screens().size() > 1) {
+        spannedPath = co_await composeSpannedWallpaper(imagePath, screenImages, token);
+        if (token.isCancelled()) {
+            co_return false;
+        }
+    }
+    m_spannedWallpaperPath = spannedPath;
+    
+    bool success;
     if (desktop == "gnome") {
-        return setWallpaperGnome(imagePath);
+        success = co_await setWallpaperGnome(imagePath, spannedPath, token);
     } else if (desktop == "kde") {
-        return setWallpaperKde(imagePath);
+        success = co_await setWallpaperKde(imagePath, screenImages, token);
     } else if (desktop == "ukui") {
-        return setWallpaperUkui(imagePath);
+        success = co_await setWallpaperUkui(imagePath, spannedPath, token);
     } else {
         qDebug() << "未知桌面环境，尝试使用GNOME方法...";
-        return setWallpaperGnome(imagePath);
+        success = co_await setWallpaperGnome(imagePath, spannedPath, token);
+    }
+    if (token.isCancelled()) {
+        co_return false;
+    }
+    
+    // 桌面壁纸先生效，锁屏图片在后台生成后再设置
+    if (success) {
+        Async::spawn(updateLockScreen(imagePath));
+    }
+    co_return success;
+}
+
+Async::Task<QMap<QString, QString>> BingWallpaperSetter::prepareScreenWallpapers(Job job) {
+    QMap<QString, QString> screenImages;
+    const QStringList assignments = SettingsStore::instance()->value(SettingsKeys::ScreenAssignments);
+    const QList<QScreen *> screens = QGuiApplication::screens();
+    if (assignments.isEmpty() || screens.size() < 2) {
+        co_return screenImages;
     }
+    QStringList screenNames;
+    for (QScreen *screen : screens) {
+        screenNames.append(screen->name());
+    }
+    
+    // 多块显示器分配到同一张图片时只获取一次
+    QHash<QString, QString> screenKeys;
+    QStringList keys;
+    std::vector<Async::Task<QString>> fetches;
+    for (const QString &assignment : assignments) {
+        // 格式为 "显示器名=相对天数[@地区]"，如 "HDMI-1=1" 显示比主壁纸早一天的图片
+        QString screenName = assignment.section('=', 0, 0).trimmed();
+        QString target = assignment.section('=', 1).trimmed();
+        bool ok = false;
+        int relativeOffset = target.section('@', 0, 0).toInt(&ok);
+        QString market = target.section('@', 1).trimmed();
+        if (!ok || !screenNames.contains(screenName)) {
+            continue;
+        }
+        int offset = qBound(0, job.offset + relativeOffset, MAX_OFFSET);
+        if (market.isEmpty()) {
+            market = job.market;
+        }
+        if (offset == job.offset && market == job.market) {
+            continue;
+        }
+        
+        QString key = QString("%1@%2").arg(offset).arg(market);
+        screenKeys.insert(screenName, key);
+        if (!keys.contains(key)) {
+            keys.append(key);
+            fetches.push_back(fetchScreenWallpaper(offset, market, job.token));
+        }
+    }
+    if (fetches.empty()) {
+        co_return screenImages;
+    }
+    
+    // 各张图片同时获取，三块屏幕的等待时间与一块相近
+    std::vector<QString> paths = co_await Async::whenAll(std::move(fetches));
+    if (job.token.isCancelled()) {
+        co_return QMap<QString, QString>();
+    }
+    for (auto it = screenKeys.constBegin(); it != screenKeys.constEnd(); ++it) {
+        // 获取失败的显示器显示主壁纸
+        const QString &path = paths[keys.indexOf(it.value())];
+        if (!path.isEmpty()) {
+            screenImages.insert(it.key(), path);
+        }
+    }
+    co_return screenImages;
+}
+
+Async::Task<QString> BingWallpaperSetter::fetchScreenWallpaper(int offset, QString market,
+                                                               Async::CancellationToken token) {
+    QString date = QDate::currentDate().addDays(-offset).toString("yyyyMMdd");
+    WallpaperInfo local = m_library->findByDate(date, market);
+    if (!local.filePath.isEmpty()) {
+        bool intact = co_await isIntactWallpaper(local.filePath, token);
+        if (token.isCancelled()) {
+            co_return QString();
+        }
+        if (intact) {
+            co_return local.filePath;
+        }
+    }
+    
+    DownloadPolicy::Decision decision = m_downloadPolicy->decide(false);
+    if (decision == DownloadPolicy::Defer) {
+        qDebug() << m_downloadPolicy->constraintDescription() << "，不为其他显示器下载壁纸";
+        co_return QString();
+    }
+    
+    // 作为不是最新的请求运行：不报告进度，也不登记到 m_jobs，不会接手用户对同一天的请求
+    Job job;
+    job.id = m_nextJobId++;
+    job.offset = offset;
+    job.market = market;
+    job.userInitiated = false;
+    Async::CancellationToken::Registration parent = token.onCancel([child = job.token]() mutable {
+        child.cancel();
+    });
+    
+    QString resolution = decision == DownloadPolicy::ReducedQuality ? m_downloadPolicy->reducedResolution()
+                                                                      : QString("UHD");
+    WallpaperInfo info;
+    QString imagePath;
+    QString error;
+    bool fetched = co_await fetchWallpaperInfo(job, resolution, info, imagePath, error);
+    if (job.token.isCancelled()) {
+        co_return QString();
+    }
+    if (!fetched) {
+        qDebug() << "获取其他显示器的壁纸失败:" << error;
+        co_return QString();
+    }
+    
+    bool cached = co_await isIntactWallpaper(info.filePath, job.token);
+    if (job.token.isCancelled()) {
+        co_return QString();
+    }
+    if (!cached) {
+        QByteArray imageData = co_await downloadImage(job, imagePath, error);
+        if (job.token.isCancelled()) {
+            co_return QString();
+        }
+        if (imageData.isEmpty() || !writeWallpaperFile(info.filePath, imageData, error)) {
+            qDebug() << "获取其他显示器的壁纸失败:" << error;
+            co_return QString();
+        }
+        QFile::remove(quarantinePath(info.filePath));
+    }
+    if (!cached || m_library->entry(info.filePath).title.isEmpty()) {
+        m_library->addOrUpdate(info);
+    }
+    co_return info.filePath;
+}
+
+QList<ScreenCompositor::Tile> BingWallpaperSetter::screenTiles(const QString &imagePath,
+                                                               const QMap<QString, QString> &screenImages) const {
+    const QList<QScreen *> screens = QGuiApplication::screens();
+    // 缩放比例不同的显示器统一按最大比例渲染，每块屏幕都不会被放大
+    qreal scale = 1.0;
+    for (QScreen *screen : screens) {
+        scale = qMax(scale, screen->devicePixelRatio());
+    }
+    
+    QList<ScreenCompositor::Tile> tiles;
+    for (QScreen *screen : screens) {
+        QRect geometry = screen->geometry();
+        ScreenCompositor::Tile tile;
+        tile.screenName = screen->name();
+        tile.geometry = QRect(qRound(geometry.x() * scale), qRound(geometry.y() * scale),
+                              qRound(geometry.width() * scale), qRound(geometry.height() * scale));
+        tile.imagePath = screenImages.value(screen->name(), imagePath);
+        tiles.append(tile);
+    }
+    return tiles;
+}
+
+Async::Task<QString> BingWallpaperSetter::composeSpannedWallpaper(QString imagePath, QMap<QString, QString> screenImages,
+                                                                  Async::CancellationToken token) {
+    QList<ScreenCompositor::Tile> tiles = screenTiles(imagePath, screenImages);
+    QString variantDir = variantDirectory();
+    QElapsedTimer timer;
+    timer.start();
+    
+    auto compose = [tiles, variantDir]() {
+        return ScreenCompositor::compose(tiles, variantDir);
+    };
+    QString spannedPath = co_await Async::runInThread(std::move(compose));
+    if (token.isCancelled()) {
+        co_return QString();
+    }
+    if (spannedPath.isEmpty()) {
+        qDebug() << "合成跨屏壁纸失败，所有显示器使用同一张壁纸";
+        co_return QString();
+    }
+    Metrics::instance()->observe("bing_wallpaper_spanned_compose_ms", timer.elapsed(),
+                                 {25, 50, 100, 250, 500, 1000, 2500});
+    co_return spannedPath;
+}
+
+void BingWallpaperSetter::onScreenLayoutChanged() {
+    // 跨屏合成图和按坐标匹配的 KDE 配置都依赖显示器布局，布局变化后重新设置
+    if (m_currentScreenWallpapers.isEmpty() || m_currentWallpaperPath.isEmpty()) {
+        return;
+    }
+    qDebug() << "显示器布局已变化，重新设置各显示器的壁纸";
+    Async::spawn(applyFromFile(m_currentWallpaperPath));
+}
+
+Async::Task<void> BingWallpaperSetter::runPrefetch(Prefetcher::Pass pass) {
+    Async::CancellationToken token = m_prefetcher->beginPass(pass);
+    Async::CancellationToken::Registration lifetime = m_lifetime.onCancel([token]() mutable {
+        token.cancel();
+    });
+    
+    // 有请求进行中时不预取；计费网络或电池供电时不做投机下载
+    if (!m_prefetcher->isEnabled() || !m_jobs.isEmpty()
+        || m_downloadPolicy->decide(false) != DownloadPolicy::FullQuality) {
+        m_prefetcher->endPass(false);
+        co_return;
+    }
+    
+    // 今天的壁纸排在最前；空闲时再取用户最可能点击的前一天和后一天
+    QList<int> offsets;
+    offsets << 0;
+    if (pass == Prefetcher::Adjacent) {
+        offsets << m_currentOffset + 1 << m_currentOffset - 1;
+    }
+    QString today = QDate::currentDate().toString("yyyyMMdd");
+    QString market = m_market;
+    bool published = false;
+    QList<int> done;
+    for (int offset : std::as_const(offsets)) {
+        if (offset < 0 || offset > MAX_OFFSET || done.contains(offset)) {
+            continue;
+        }
+        done.append(offset);
+        QString date = co_await prefetchWallpaper(offset, market, token);
+        // 被用户请求打断时 Prefetcher 已经安排好重试
+        if (token.isCancelled()) {
+            co_return;
+        }
+        if (offset == 0 && date == today) {
+            published = true;
+        }
+    }
+    m_prefetcher->endPass(published);
+}
+
+Async::Task<QString> BingWallpaperSetter::prefetchWallpaper(int offset, QString market,
+                                                            Async::CancellationToken token) {
+    QString date = QDate::currentDate().addDays(-offset).toString("yyyyMMdd");
+    WallpaperInfo local = m_library->findByDate(date, market);
+    // 受限时下载的较小版本也趁空闲换成 4K
+    if (!local.filePath.isEmpty() && !isReducedRendition(local)) {
+        bool intact = co_await isIntactWallpaper(local.filePath, token);
+        if (token.isCancelled()) {
+            co_return QString();
+        }
+        if (intact) {
+            co_return local.date;
+        }
+    }
+    
+    // 作为不是最新的请求运行，也不登记到 m_jobs，不会推迟空闲计时
+    Job job;
+    job.id = m_nextJobId++;
+    job.offset = offset;
+    job.market = market;
+    job.userInitiated = false;
+    Async::CancellationToken::Registration parent = token.onCancel([child = job.token]() mutable {
+        child.cancel();
+    });
+    
+    WallpaperInfo info;
+    QString imagePath;
+    QString error;
+    QString resolution = "UHD";
+    bool fetched = co_await fetchWallpaperInfo(job, resolution, info, imagePath, error);
+    if (job.token.isCancelled()) {
+        co_return QString();
+    }
+    if (!fetched) {
+        qDebug() << "预取失败:" << error;
+        co_return QString();
+    }
+    
+    WallpaperInfo existing = m_library->entry(info.filePath);
+    if (!isReducedRendition(existing)) {
+        bool intact = co_await isIntactWallpaper(info.filePath, job.token);
+        if (job.token.isCancelled()) {
+            co_return QString();
+        }
+        if (intact) {
+            if (existing.title.isEmpty()) {
+                m_library->addOrUpdate(info);
+            }
+            co_return info.date;
+        }
+    }
+    
+    QNetworkRequest request = createRequest(QUrl(info.imageUrl));
+    QByteArray imageData = co_await m_prefetcher->download(m_networkManager, request, job.token, error);
+    if (job.token.isCancelled()) {
+        co_return QString();
+    }
+    if (imageData.isEmpty()) {
+        qDebug() << error;
+        co_return QString();
+    }
+    
+    QString filePath = info.filePath;
+    auto write = [filePath, imageData]() {
+        // 写入不和前台的磁盘读写争抢
+        Prefetcher::IdleIoPriority idle;
+        QString writeError;
+        writeWallpaperFile(filePath, imageData, writeError);
+        return writeError;
+    };
+    error = co_await Async::runInThread(std::move(write));
+    if (token.isCancelled()) {
+        co_return QString();
+    }
+    if (!error.isEmpty()) {
+        qDebug() << "预取失败:" << error;
+        co_return QString();
+    }
+    
+    QFile::remove(quarantinePath(info.filePath));
+    m_library->addOrUpdate(info);
+    Metrics::instance()->incrementCounter("bing_wallpaper_prefetched_total");
+    qDebug() << "已预取壁纸:" << info.filePath;
+    co_return info.date;
+}
+
+Async::Task<void> BingWallpaperSetter::updateLockScreen(QString imagePath) {
+    Async::CancellationToken token = m_lifetime;
+    QString variantDir = variantDirectory();
+    double busyness = m_library->entry(imagePath).busyness;
+    
+    auto generate = [imagePath, variantDir, busyness]() {
+        return LockScreenGenerator::generate(imagePath, variantDir, busyness);
+    };
+    QString lockPath = co_await Async::runInThread(std::move(generate));
+    // 生成期间用户可能已经切换了壁纸
+    if (token.isCancelled() || lockPath.isEmpty() || imagePath != m_currentWallpaperPath) {
+        co_return;
+    }
+    
+    QString fileUri = "file://" + lockPath;
+    QString desktop = detectDesktopEnvironment();
+    Async::ProcessResult result;
+    
+    if (desktop == "kde") {
+        // Plasma 6 使用 kwriteconfig6，Plasma 5 使用 kwriteconfig5
+        QString kwriteconfig = QStandardPaths::findExecutable("kwriteconfig6");
+        if (kwriteconfig.isEmpty()) {
+            kwriteconfig = "kwriteconfig5";
+        }
+        result = co_await Async::runProcess(kwriteconfig, QStringList() << "--file" << "kscreenlockerrc"
+                                            << "--group" << "Greeter" << "--group" << "Wallpaper"
+                                            << "--group" << "org.kde.image" << "--group" << "General"
+                                            << "--key" << "Image" << fileUri, 3000, token);
+        if (!result.succeeded()) {
+            qDebug() << "设置KDE锁屏壁纸失败";
+            co_return;
+        }
+    } else if (desktop == "gnome" || desktop == "unknown") {
+        result = co_await Async::runProcess("gsettings", QStringList() << "set" << "org.gnome.desktop.screensaver"
+                                            << "picture-uri" << fileUri, 3000, token);
+        if (!result.succeeded()) {
+            qDebug() << "设置GNOME锁屏壁纸失败";
+            co_return;
+        }
+    } else {
+        co_return;
+    }
+    
+    qDebug() << "锁屏壁纸设置成功:" << lockPath;
 }
 
 QString BingWallpaperSetter::getCurrentWallpaperPath() const {
@@ -9,6 +9,26 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
+#include <QNetworkRequest>
+#include <QSslConfiguration>
+#include <QHash>
+#include <QPointer>
+#include <QTimer>
+#include <QMap>
+#include <memory>
+#include "WallpaperLibrary.h"
+#include "ProgressivePreview.h"
+#include "WallpaperCacheClient.h"
+#include "EndpointStats.h"
+#include "HedgedRequest.h"
+#include "TransferMonitor.h"
+#include "DownloadPolicy.h"
+#include "IntegrityScanner.h"
+#include "ScreenCompositor.h"
+#include "Prefetcher.h"
+#include "WallpaperCommands.h"
+#include "Task.h"
+#include "Awaitables.h"
 
 class BingWallpaperSetter : public QObject {
     Q_OBJECT
@@ -17,42 +37,157 @@ public:
     explicit BingWallpaperSetter(QObject *parent = nullptr);
     ~BingWallpaperSetter();
     
-    void downloadAndSetWallpaper(int button);
+    /**
+     * @brief 获取并设置壁纸
+     *
+     * 每次调用作为一个独立的协程运行，多个日期可以同时下载。只有最新的请求会设置壁纸
+     * 并报告进度，被取代的请求下载完成后只保存到壁纸库。
+     * 计费网络或电池供电时按 DownloadPolicy 降低分辨率、使用壁纸库中的壁纸或推迟更新。
+     * @param button -1 前一天，1 后一天，其他值回到今天
+     * @param userInitiated 用户手动请求时不会被推迟
+     */
+    void downloadAndSetWallpaper(int button, bool userInitiated = true);
     QString getCurrentWallpaperPath() const;
     QString getWallpaperDirectory() const;
     void setWallpaperDirectory(const QString &directory);
     bool isCustomDirectory() const;
+    WallpaperLibrary *library() const;
+    /**
+     * @brief 异步设置本地图片为壁纸，成功时发出 wallpaperSet，失败时发出 wallpaperApplyFailed
+     */
+    void setWallpaperFromFile(const QString &imagePath);
+    void setProgressivePreviewEnabled(bool enabled);
+    
+    /**
+     * @brief 提前建立到最快的两个 Bing 服务器地址的 TLS 连接
+     *
+     * 在窗口显示或定时更新前调用，DNS、TCP 和 TLS 握手不再占用更新时的关键路径。
+     * 连接在空闲一段时间后会被 QNetworkAccessManager 关闭，所以不宜过早调用。
+     */
+    void prewarmConnections();
+    
+    /**
+     * @brief 检查壁纸库中所有文件的完整性
+     *
+     * 损坏的文件移到所在目录的 .quarantine 子目录，有下载地址的在网络不受限时重新下载，
+     * 没有下载地址的从壁纸库移除。启动后会自动执行一次，只检查上次之后有变化的文件。
+     * @param force 为 true 时重新检查所有文件
+     */
+    void verifyLibrary(bool force = false);
     
 signals:
     void downloadStarted();
     void downloadProgress(int percentage);
+    void downloadPreviewAvailable(const QImage &preview);
+    void downloadRateChanged(double bytesPerSecond, int etaSeconds);
+    void downloadRetrying(int attempt);
     void downloadFinished(bool success, const QString &message, int offset = 0);
     void wallpaperSet(const QString &path);
-    
-private slots:
-    void onApiReplyFinished();
-    void onImageDownloadFinished();
-    void onDownloadProgress(qint64 bytesReceived, qint64 bytesTotal);
+    void wallpaperApplyFailed(const QString &path);
+    void libraryVerified(int checked, int corrupt);
+    void wallpaperDirectoryChanged(const QString &directory);
     
 private:
+    // 一次 downloadAndSetWallpaper 请求，协程之间不共享可变状态
+    struct Job {
+        int id;
+        int offset;
+        QString market;
+        bool userInitiated;
+        Async::CancellationToken token;
+        bool supersedable = false;  // 由 downloadAndSetWallpaper 发起，被新的请求取代时取消
+        bool applying = false;      // 只在 m_jobs 中更新：已开始设置壁纸，不再取消
+    };
+    
     void setupWallpaperDirectory();
     void cleanupOldWallpapers(int keepDays = 7);
-    bool setWallpaperGnome(const QString &imagePath);
-    bool setWallpaperKde(const QString &imagePath);
-    bool setWallpaperUkui(const QString &imagePath);
+    Async::Task<bool> setWallpaperGnome(QString imagePath, QString spannedPath, Async::CancellationToken token);
+    Async::Task<bool> setWallpaperKde(QString imagePath, QMap<QString, QString> screenImages,
+                                      Async::CancellationToken token);
+    Async::Task<bool> setWallpaperUkui(QString imagePath, QString spannedPath, Async::CancellationToken token);
+    /**
+     * @brief 依次写入配置项，必需的配置项失败时返回 false
+     */
+    Async::Task<bool> applyGSettings(QString schema, QList<WallpaperCommands::GSetting> settings, int timeoutMs,
+                                     Async::CancellationToken token);
+    QString gnomeDarkPath(const QString &imagePath) const;
     QString detectDesktopEnvironment();
-    bool setWallpaper(const QString &imagePath);
+    /**
+     * @param screenImages 显示器名 -> 图片，未列出的显示器使用 imagePath
+     */
+    Async::Task<bool> setWallpaper(QString imagePath, QMap<QString, QString> screenImages,
+                                   Async::CancellationToken token);
+    Async::Task<QMap<QString, QString>> prepareScreenWallpapers(Job job);
+    Async::Task<QString> fetchScreenWallpaper(int offset, QString market, Async::CancellationToken token);
+    QList<ScreenCompositor::Tile> screenTiles(const QString &imagePath, const QMap<QString, QString> &screenImages) const;
+    Async::Task<QString> composeSpannedWallpaper(QString imagePath, QMap<QString, QString> screenImages,
+                                                 Async::CancellationToken token);
+    void onScreenLayoutChanged();
+    Async::Task<void> runPrefetch(Prefetcher::Pass pass);
+    Async::Task<QString> prefetchWallpaper(int offset, QString market, Async::CancellationToken token);
     void loadSettings();
     void saveSettings();
+    QStringList configuredEndpoints(QStringList endpoints) const;
+    void applyWallpaperDirectory(const QString &directory);
+    Async::Task<void> runJob(Job job);
+    Async::Task<bool> fetchWallpaperInfo(const Job &job, const QString &resolution, WallpaperInfo &info,
+                                         QString &imagePath, QString &error);
+    Async::Task<bool> fetchFromSharedCache(const Job &job, const WallpaperInfo &info, const QString &imagePath);
+    Async::Task<QByteArray> downloadImage(const Job &job, const QString &imagePath, QString &error);
+    static bool writeWallpaperFile(const QString &filePath, const QByteArray &data, QString &error);
+    Async::Task<bool> isIntactWallpaper(QString imagePath, Async::CancellationToken token);
+    bool quarantineWallpaper(const QString &imagePath);
+    QString quarantinePath(const QString &imagePath) const;
+    Async::Task<void> runLibraryVerification(bool force);
+    Async::Task<bool> redownloadWallpaper(WallpaperInfo info);
+    void finishJob(const Job &job, bool success, const QString &message);
+    bool isLatestJob(const Job &job) const;
+    void cancelSupersededJobs(int keepJobId);
+    bool isReducedRendition(const WallpaperInfo &info) const;
+    void onDeferralLifted();
+    Async::Task<void> applyFromFile(QString imagePath);
+    Async::Task<void> analyzeWallpaper(QString imagePath);
+    void onAnalysisFinished(const WallpaperInfo &result);
+    Async::Task<void> refreshGnomeAppearance(QString imagePath);
+    Async::Task<void> applyGnomeAppearance(QString imagePath, Async::CancellationToken token);
+    Async::Task<void> updateLockScreen(QString imagePath);
+    QString variantDirectory() const;
+    QNetworkRequest createRequest(const QUrl &url) const;
+    Async::HedgedAwaiter startHedgedRequest(const QString &path, const QString &requestKind,
+                                            const Async::CancellationToken &token);
+    void trackTimeToFirstByte(QNetworkReply *reply, const QString &requestKind);
+    void loadSessionTicket();
+    void saveSessionTicket(QNetworkReply *reply);
     
     QNetworkAccessManager *m_networkManager;
     QString m_wallpaperDir;
     QString m_defaultWallpaperDir;
     QString m_currentWallpaperPath;
+    QMap<QString, QString> m_currentScreenWallpapers;
+    QString m_spannedWallpaperPath;     // 当前使用的跨屏合成图，没有时为空
     QString m_bingApiUrl;
-    QNetworkReply *m_currentReply;
+    QSslConfiguration m_sslConfiguration;
+    QString m_market;
     bool m_isCustomDirectory;
     short m_currentOffset;
+    WallpaperLibrary *m_library;
+    EndpointStats *m_endpointStats;
+    DownloadPolicy *m_downloadPolicy;
+    IntegrityScanner *m_integrityScanner;
+    QTimer *m_screenLayoutTimer;
+    Prefetcher *m_prefetcher;
+    bool m_verifyingLibrary;
+    bool m_deferredUpdate;
+    int m_stallTimeoutMs;
+    bool m_progressivePreviewEnabled;
+    QPointer<ProgressivePreview> m_activePreview;
+    QHash<int, Job> m_jobs;
+    int m_nextJobId;
+    int m_latestJobId;
+    // 对象销毁时取消，所有协程在恢复后先检查它（或由它派生的任务令牌）再访问成员
+    Async::CancellationToken m_lifetime;
+    // 设置壁纸的外部命令不能交错执行
+    std::shared_ptr<Async::AsyncMutex> m_applyMutex;
 };
 
 #endif // BINGWALLPAPERSETTER_H
@@ -0,0 +1,230 @@
+#include "DownloadPolicy.h"
+#include "Metrics.h"
+#include "SettingsStore.h"
+#include <QDebug>
+
+#ifdef HAVE_QTDBUS
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QDBusVariant>
+#endif
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 3, 0)
+#include <QNetworkInformation>
+#endif
+
+namespace {
+
+const char *NM_SERVICE = "org.freedesktop.NetworkManager";
+const char *NM_PATH = "/org/freedesktop/NetworkManager";
+const char *NM_INTERFACE = "org.freedesktop.NetworkManager";
+const char *UPOWER_SERVICE = "org.freedesktop.UPower";
+const char *UPOWER_PATH = "/org/freedesktop/UPower";
+const char *UPOWER_INTERFACE = "org.freedesktop.UPower";
+// 汇总所有电池的虚拟设备
+const char *UPOWER_DISPLAY_DEVICE = "/org/freedesktop/UPower/devices/DisplayDevice";
+const char *UPOWER_DEVICE_INTERFACE = "org.freedesktop.UPower.Device";
+const char *PROPERTIES_INTERFACE = "org.freedesktop.DBus.Properties";
+
+// NMMetered 枚举：1 为确定计费，3 为根据连接类型推测计费（如手机热点）
+const uint NM_METERED_YES = 1;
+const uint NM_METERED_GUESS_YES = 3;
+
+}
+
+DownloadPolicy::DownloadPolicy(QObject *parent)
+    : QObject(parent)
+    , m_respectMetered(true)
+    , m_lowBatteryThreshold(20)
+    , m_useNetworkInformation(false)
+    , m_metered(false)
+    , m_onBattery(false)
+    , m_batteryPercentage(-1.0)
+{
+    loadSettings();
+    SettingsStore *settings = SettingsStore::instance();
+    settings->onChanged(SettingsKeys::RespectMeteredConnections, this, [this](bool) { onSettingsChanged(); });
+    settings->onChanged(SettingsKeys::LowBatteryThreshold, this, [this](int) { onSettingsChanged(); });
+    settings->onChanged(SettingsKeys::ReducedResolution, this, [this](const QString &) { onSettingsChanged(); });
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 3, 0)
+    // 用模拟的 NetworkManager 测试时直接读取 Metered 属性，不经过 QNetworkInformation 的后端
+    if (!qEnvironmentVariableIsSet("BING_WALLPAPER_NO_NETWORK_INFORMATION")
+        && QNetworkInformation::loadBackendByFeatures(QNetworkInformation::Feature::Metered)) {
+        QNetworkInformation *information = QNetworkInformation::instance();
+        m_useNetworkInformation = true;
+        m_metered = information->isMetered();
+        connect(information, &QNetworkInformation::isMeteredChanged, this, &DownloadPolicy::setMetered);
+        qDebug() << "使用 QNetworkInformation 判断计费网络:" << information->backendName();
+    }
+#endif
+
+    connectSystemBus();
+}
+
+void DownloadPolicy::loadSettings() {
+    SettingsStore *settings = SettingsStore::instance();
+    m_respectMetered = settings->value(SettingsKeys::RespectMeteredConnections);
+    m_lowBatteryThreshold = settings->value(SettingsKeys::LowBatteryThreshold);
+    m_reducedResolution = settings->value(SettingsKeys::ReducedResolution);
+}
+
+void DownloadPolicy::onSettingsChanged() {
+    bool wasDeferring = decide(false) == Defer;
+    loadSettings();
+    emit conditionsChanged();
+    if (wasDeferring && decide(false) != Defer) {
+        emit deferralLifted();
+    }
+}
+
+void DownloadPolicy::connectSystemBus() {
+#ifdef HAVE_QTDBUS
+    // 系统总线地址遵循 DBUS_SYSTEM_BUS_ADDRESS，测试时指向模拟服务
+    QDBusConnection bus = QDBusConnection::systemBus();
+    if (!bus.isConnected()) {
+        qDebug() << "无法连接系统总线，不检测计费网络和电池状态";
+        return;
+    }
+
+    if (!m_useNetworkInformation) {
+        bus.connect(NM_SERVICE, NM_PATH, PROPERTIES_INTERFACE, "PropertiesChanged",
+                    this, SLOT(onPropertiesChanged(QString,QVariantMap,QStringList)));
+        queryProperty(NM_SERVICE, NM_PATH, NM_INTERFACE, "Metered");
+    }
+
+    bus.connect(UPOWER_SERVICE, UPOWER_PATH, PROPERTIES_INTERFACE, "PropertiesChanged",
+                this, SLOT(onPropertiesChanged(QString,QVariantMap,QStringList)));
+    bus.connect(UPOWER_SERVICE, UPOWER_DISPLAY_DEVICE, PROPERTIES_INTERFACE, "PropertiesChanged",
+                this, SLOT(onPropertiesChanged(QString,QVariantMap,QStringList)));
+    queryProperty(UPOWER_SERVICE, UPOWER_PATH, UPOWER_INTERFACE, "OnBattery");
+    queryProperty(UPOWER_SERVICE, UPOWER_DISPLAY_DEVICE, UPOWER_DEVICE_INTERFACE, "Percentage");
+#else
+    qDebug() << "编译时未启用 QtDBus，不检测计费网络和电池状态";
+#endif
+}
+
+void DownloadPolicy::queryProperty(const QString &service, const QString &path, const QString &interface,
+                                   const QString &property) {
+#ifdef HAVE_QTDBUS
+    QDBusMessage message = QDBusMessage::createMethodCall(service, path, PROPERTIES_INTERFACE, "Get");
+    message << interface << property;
+
+    // 启动时不阻塞界面，结果到达后再更新
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(QDBusConnection::systemBus().asyncCall(message), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, interface, property](QDBusPendingCallWatcher *call) {
+        QDBusPendingReply<QDBusVariant> reply = *call;
+        call->deleteLater();
+        if (reply.isError()) {
+            qDebug() << "读取" << property << "失败:" << reply.error().message();
+            return;
+        }
+        updateProperty(interface, property, reply.value().variant());
+    });
+#else
+    Q_UNUSED(service)
+    Q_UNUSED(path)
+    Q_UNUSED(interface)
+    Q_UNUSED(property)
+#endif
+}
+
+void DownloadPolicy::onPropertiesChanged(const QString &interface, const QVariantMap &changed,
+                                         const QStringList &invalidated) {
+    Q_UNUSED(invalidated)
+    for (auto it = changed.cbegin(); it != changed.cend(); ++it) {
+        updateProperty(interface, it.key(), it.value());
+    }
+}
+
+void DownloadPolicy::updateProperty(const QString &interface, const QString &property, const QVariant &value) {
+    if (interface == NM_INTERFACE && property == "Metered") {
+        uint metered = value.toUInt();
+        setMetered(metered == NM_METERED_YES || metered == NM_METERED_GUESS_YES);
+        return;
+    }
+
+    bool wasDeferring = decide(false) == Defer;
+    if (interface == UPOWER_INTERFACE && property == "OnBattery") {
+        m_onBattery = value.toBool();
+    } else if (interface == UPOWER_DEVICE_INTERFACE && property == "Percentage") {
+        m_batteryPercentage = value.toDouble();
+    } else {
+        return;
+    }
+
+    Metrics::instance()->setGauge("bing_wallpaper_on_battery", m_onBattery ? 1 : 0);
+    emit conditionsChanged();
+    if (wasDeferring && decide(false) != Defer) {
+        emit deferralLifted();
+    }
+}
+
+void DownloadPolicy::setMetered(bool metered) {
+    if (metered == m_metered) {
+        return;
+    }
+    bool wasDeferring = decide(false) == Defer;
+    m_metered = metered;
+    qDebug() << (metered ? "当前为按流量计费的网络" : "当前网络不按流量计费");
+
+    Metrics::instance()->setGauge("bing_wallpaper_metered_connection", metered ? 1 : 0);
+    emit conditionsChanged();
+    if (wasDeferring && decide(false) != Defer) {
+        emit deferralLifted();
+    }
+}
+
+bool DownloadPolicy::isMetered() const {
+    return m_respectMetered && m_metered;
+}
+
+bool DownloadPolicy::isOnBattery() const {
+    return m_onBattery;
+}
+
+bool DownloadPolicy::isLowBattery() const {
+    // 电量未知时（如台式机没有电池）不算电量低
+    return m_onBattery && m_batteryPercentage >= 0.0 && m_batteryPercentage < m_lowBatteryThreshold;
+}
+
+DownloadPolicy::Decision DownloadPolicy::decide(bool userInitiated) const {
+    if (isMetered() || isLowBattery()) {
+        return userInitiated ? ReducedQuality : Defer;
+    }
+    if (m_onBattery) {
+        return ReducedQuality;
+    }
+    return FullQuality;
+}
+
+QString DownloadPolicy::decisionName(Decision decision) {
+    switch (decision) {
+    case FullQuality:
+        return "full";
+    case ReducedQuality:
+        return "reduced";
+    case Defer:
+        return "defer";
+    }
+    return QString();
+}
+
+QString DownloadPolicy::reducedResolution() const {
+    return m_reducedResolution;
+}
+
+QString DownloadPolicy::constraintDescription() const {
+    if (isMetered()) {
+        return "按流量计费的网络";
+    }
+    if (isLowBattery()) {
+        return QString("电池电量低（%1%）").arg(qRound(m_batteryPercentage));
+    }
+    if (m_onBattery) {
+        return "使用电池供电";
+    }
+    return QString();
+}
@@ -0,0 +1,81 @@
+#ifndef DOWNLOADPOLICY_H
+#define DOWNLOADPOLICY_H
+
+#include <QObject>
+#include <QString>
+#include <QVariant>
+#include <QVariantMap>
+#include <QStringList>
+
+/**
+ * @brief 根据网络计费和供电状态决定如何下载壁纸
+ *
+ * 通过系统总线读取 NetworkManager 的 Metered 属性和 UPower 的 OnBattery、电量，
+ * Qt 6.3 及以上优先用 QNetworkInformation 判断计费网络。所有查询都是异步的，
+ * 状态未知时按不受限处理。相关配置在配置文件中修改后立即生效。
+ * 测试时可以用 DBUS_SYSTEM_BUS_ADDRESS 指向运行模拟服务（如 python-dbusmock）的总线，
+ * 并设置 BING_WALLPAPER_NO_NETWORK_INFORMATION 让计费状态只来自模拟的 NetworkManager，
+ * 见 scripts/test_download_policy.py。
+ */
+class DownloadPolicy : public QObject {
+    Q_OBJECT
+
+public:
+    enum Decision {
+        FullQuality,        // 正常下载 4K
+        ReducedQuality,     // 下载较小的分辨率
+        Defer               // 推迟到条件允许时再更新
+    };
+
+    explicit DownloadPolicy(QObject *parent = nullptr);
+
+    /**
+     * @param userInitiated 用户手动请求时不推迟，最多降低分辨率
+     */
+    Decision decide(bool userInitiated) const;
+
+    /**
+     * @brief 降级时使用的分辨率，如 1920x1080
+     */
+    QString reducedResolution() const;
+
+    /**
+     * @brief 当前受限原因，不受限时为空
+     */
+    QString constraintDescription() const;
+
+    bool isMetered() const;
+    bool isOnBattery() const;
+
+    static QString decisionName(Decision decision);
+
+signals:
+    void conditionsChanged();
+    /**
+     * @brief 从需要推迟变为可以自动更新
+     */
+    void deferralLifted();
+
+private slots:
+    void onPropertiesChanged(const QString &interface, const QVariantMap &changed, const QStringList &invalidated);
+
+private:
+    void loadSettings();
+    void onSettingsChanged();
+    void connectSystemBus();
+    void queryProperty(const QString &service, const QString &path, const QString &interface,
+                       const QString &property);
+    void updateProperty(const QString &interface, const QString &property, const QVariant &value);
+    void setMetered(bool metered);
+    bool isLowBattery() const;
+
+    bool m_respectMetered;
+    int m_lowBatteryThreshold;
+    QString m_reducedResolution;
+    bool m_useNetworkInformation;
+    bool m_metered;
+    bool m_onBattery;
+    double m_batteryPercentage;
+};
+
+#endif // DOWNLOADPOLICY_H
@@ -0,0 +1,165 @@
+#include "EndpointStats.h"
+#include "Metrics.h"
+#include <QStandardPaths>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QUrl>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QDebug>
+#include <QCoreApplication>
+#include <algorithm>
+
+namespace {
+
+const int MAX_SAMPLES = 50;             // 只看最近的表现，网络环境变化后能较快适应
+const int MIN_SAMPLES = 5;              // 样本太少时百分位没有意义
+const int DEFAULT_HEDGE_DELAY_MS = 1000;
+const int MIN_HEDGE_DELAY_MS = 200;
+const int MAX_HEDGE_DELAY_MS = 4000;
+const int FAILURE_PENALTY_MS = 2 * MAX_HEDGE_DELAY_MS;
+const int SAVE_DELAY_MS = 5000;
+
+}
+
+EndpointStats::EndpointStats(const QStringList &endpoints, QObject *parent)
+    : QObject(parent)
+    , m_endpoints(endpoints)
+{
+    m_saveTimer.setSingleShot(true);
+    m_saveTimer.setInterval(SAVE_DELAY_MS);
+    connect(&m_saveTimer, &QTimer::timeout, this, &EndpointStats::save);
+    if (QCoreApplication::instance()) {
+        connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, &EndpointStats::flush);
+    }
+
+    load();
+}
+
+EndpointStats::~EndpointStats() {
+    flush();
+}
+
+QStringList EndpointStats::endpoints() const {
+    return m_endpoints;
+}
+
+void EndpointStats::setEndpoints(const QStringList &endpoints) {
+    if (endpoints == m_endpoints) {
+        return;
+    }
+    // 所有地址的样本都在内存中，换回之前用过的地址时历史数据仍然有效
+    m_endpoints = endpoints;
+}
+
+QString EndpointStats::statsFilePath() const {
+    QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dataDir);
+    return dataDir + "/endpoints.json";
+}
+
+void EndpointStats::load() {
+    QFile file(statsFilePath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QJsonObject obj = QJsonDocument::fromJson(file.readAll()).object();
+    for (auto it = obj.constBegin(); it != obj.constEnd(); ++it) {
+        QVector<int> &samples = m_samples[it.key()];
+        const QJsonArray values = it.value().toArray();
+        for (const QJsonValue &value : values) {
+            samples.append(value.toInt());
+        }
+        if (samples.size() > MAX_SAMPLES) {
+            samples.remove(0, samples.size() - MAX_SAMPLES);
+        }
+    }
+}
+
+void EndpointStats::save() const {
+    QJsonObject obj;
+    for (auto it = m_samples.constBegin(); it != m_samples.constEnd(); ++it) {
+        QJsonArray samples;
+        for (int sample : it.value()) {
+            samples.append(sample);
+        }
+        obj[it.key()] = samples;
+    }
+
+    QSaveFile file(statsFilePath());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "保存延迟统计失败:" << file.fileName();
+        return;
+    }
+    file.write(QJsonDocument(obj).toJson(QJsonDocument::Compact));
+    file.commit();
+}
+
+void EndpointStats::flush() {
+    if (!m_saveTimer.isActive()) {
+        return;
+    }
+    m_saveTimer.stop();
+    save();
+}
+
+int EndpointStats::percentile(const QString &endpoint, double fraction) const {
+    QVector<int> samples = m_samples.value(endpoint);
+    if (samples.size() < MIN_SAMPLES) {
+        return -1;
+    }
+    int index = qMin(int(samples.size()) - 1, int(samples.size() * fraction));
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+QStringList EndpointStats::orderedEndpoints() const {
+    QStringList ordered = m_endpoints;
+    QHash<QString, int> medians;
+    for (const QString &endpoint : m_endpoints) {
+        medians[endpoint] = percentile(endpoint, 0.5);
+    }
+
+    std::stable_sort(ordered.begin(), ordered.end(), [&medians](const QString &a, const QString &b) {
+        int ma = medians.value(a);
+        int mb = medians.value(b);
+        if (ma < 0 || mb < 0) {
+            return ma >= 0 && mb < 0;
+        }
+        return ma < mb;
+    });
+    return ordered;
+}
+
+int EndpointStats::hedgeDelayMs(const QString &endpoint) const {
+    int p95 = percentile(endpoint, 0.95);
+    if (p95 < 0) {
+        return DEFAULT_HEDGE_DELAY_MS;
+    }
+    return qBound(MIN_HEDGE_DELAY_MS, p95, MAX_HEDGE_DELAY_MS);
+}
+
+void EndpointStats::recordLatency(const QString &endpoint, qint64 latencyMs) {
+    QVector<int> &samples = m_samples[endpoint];
+    samples.append(int(qMin<qint64>(latencyMs, FAILURE_PENALTY_MS)));
+    if (samples.size() > MAX_SAMPLES) {
+        samples.remove(0, samples.size() - MAX_SAMPLES);
+    }
+    if (!m_saveTimer.isActive()) {
+        m_saveTimer.start();
+    }
+
+    int p95 = percentile(endpoint, 0.95);
+    if (p95 >= 0) {
+        Metrics::instance()->setGauge(QString("bing_wallpaper_endpoint_p95_ms{host=\"%1\"}")
+                                          .arg(QUrl(endpoint).host()), p95);
+    }
+}
+
+void EndpointStats::recordFailure(const QString &endpoint) {
+    // 失败按最大延迟计入，让该地址排到后面
+    recordLatency(endpoint, FAILURE_PENALTY_MS);
+}
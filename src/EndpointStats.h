@@ -0,0 +1,60 @@
+#ifndef ENDPOINTSTATS_H
+#define ENDPOINTSTATS_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QVector>
+#include <QTimer>
+
+/**
+ * @brief Bing 各个服务器地址的响应延迟统计
+ *
+ * 为每个地址保留最近若干次的首字节时间，保存在应用数据目录下的 endpoints.json，
+ * 跨启动保留。据此决定先访问哪个地址，以及等待多久后向下一个地址发出对冲请求。
+ * 新的样本合并几秒后再写回，不在请求路径上同步写文件。
+ */
+class EndpointStats : public QObject {
+    Q_OBJECT
+
+public:
+    explicit EndpointStats(const QStringList &endpoints, QObject *parent = nullptr);
+    ~EndpointStats();
+
+    QStringList endpoints() const;
+    /**
+     * @brief 更换服务器地址列表，已有的延迟统计保留
+     */
+    void setEndpoints(const QStringList &endpoints);
+
+    /**
+     * @brief 按中位延迟从快到慢排列，数据不足的地址按配置顺序排在后面
+     */
+    QStringList orderedEndpoints() const;
+
+    /**
+     * @brief 对冲延迟：该地址的 p95 首字节时间，数据不足时使用默认值
+     */
+    int hedgeDelayMs(const QString &endpoint) const;
+
+    void recordLatency(const QString &endpoint, qint64 latencyMs);
+    void recordFailure(const QString &endpoint);
+
+    /**
+     * @brief 立即写回尚未保存的样本
+     */
+    void flush();
+
+private:
+    QString statsFilePath() const;
+    void load();
+    void save() const;
+    int percentile(const QString &endpoint, double fraction) const;
+
+    QStringList m_endpoints;
+    QHash<QString, QVector<int>> m_samples;   // 按时间顺序，最旧的在前；包括不在当前列表中的地址
+    QTimer m_saveTimer;
+};
+
+#endif // ENDPOINTSTATS_H
@@ -0,0 +1,141 @@
+#include "HedgedRequest.h"
+#include "EndpointStats.h"
+#include "Metrics.h"
+#include <QUrl>
+#include <QDebug>
+#include <utility>
+
+HedgedRequest::HedgedRequest(QNetworkAccessManager *manager, EndpointStats *stats, const QString &path,
+                             RequestFactory factory, QObject *parent)
+    : QObject(parent)
+    , m_manager(manager)
+    , m_stats(stats)
+    , m_path(path)
+    , m_factory(std::move(factory))
+    , m_nextEndpoint(0)
+    , m_done(false)
+{
+    m_hedgeTimer.setSingleShot(true);
+    connect(&m_hedgeTimer, &QTimer::timeout, this, [this]() {
+        qDebug() << "请求响应缓慢，对冲到下一个地址";
+        Metrics::instance()->incrementCounter("bing_wallpaper_hedged_requests_total");
+        startNextAttempt();
+    });
+}
+
+void HedgedRequest::start() {
+    m_endpoints = m_stats->orderedEndpoints();
+    m_elapsed.start();
+    startNextAttempt();
+}
+
+void HedgedRequest::startNextAttempt() {
+    if (m_done || m_nextEndpoint >= m_endpoints.size()) {
+        return;
+    }
+
+    QString endpoint = m_endpoints[m_nextEndpoint++];
+    QNetworkReply *reply = m_manager->get(m_factory(QUrl(endpoint + m_path)));
+    m_attempts.append({reply, endpoint, m_elapsed.elapsed()});
+
+    connect(reply, &QNetworkReply::metaDataChanged, this, [this, reply]() {
+        onMetaDataChanged(reply);
+    });
+    connect(reply, &QNetworkReply::finished, this, [this, reply]() {
+        onAttemptFinished(reply);
+    });
+    emit attemptStarted(reply);
+
+    if (m_nextEndpoint < m_endpoints.size()) {
+        m_hedgeTimer.start(m_stats->hedgeDelayMs(endpoint));
+    }
+}
+
+int HedgedRequest::attemptIndex(QNetworkReply *reply) const {
+    for (int i = 0; i < m_attempts.size(); ++i) {
+        if (m_attempts[i].reply == reply) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void HedgedRequest::onMetaDataChanged(QNetworkReply *reply) {
+    int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (!m_done && status >= 200 && status < 300) {
+        declareWinner(reply);
+    }
+}
+
+void HedgedRequest::onAttemptFinished(QNetworkReply *reply) {
+    if (m_done) {
+        return;
+    }
+    // 没有出错但也没有 2xx 响应头（例如未跟随的重定向），同样算作响应
+    if (reply->error() == QNetworkReply::NoError) {
+        declareWinner(reply);
+        return;
+    }
+
+    int index = attemptIndex(reply);
+    Attempt attempt = m_attempts.takeAt(index);
+    m_stats->recordFailure(attempt.endpoint);
+    m_lastError = reply->errorString();
+    qDebug() << "请求失败:" << attempt.endpoint << m_lastError;
+    reply->deleteLater();
+
+    // 出错时不必等待对冲延迟，立即换下一个地址
+    if (m_nextEndpoint < m_endpoints.size()) {
+        m_hedgeTimer.stop();
+        startNextAttempt();
+    } else if (m_attempts.isEmpty()) {
+        m_done = true;
+        emit failed(m_lastError);
+        deleteLater();
+    }
+}
+
+void HedgedRequest::declareWinner(QNetworkReply *reply) {
+    m_done = true;
+    m_hedgeTimer.stop();
+
+    qint64 now = m_elapsed.elapsed();
+    int winnerIndex = attemptIndex(reply);
+    const Attempt &winner = m_attempts[winnerIndex];
+    m_stats->recordLatency(winner.endpoint, now - winner.startedAt);
+
+    for (const Attempt &attempt : std::as_const(m_attempts)) {
+        if (attempt.reply == reply) {
+            continue;
+        }
+        // 比胜出者先发出的请求至少有这么慢，作为下限计入统计
+        if (attempt.startedAt < winner.startedAt) {
+            m_stats->recordLatency(attempt.endpoint, now - attempt.startedAt);
+        }
+        disconnect(attempt.reply, nullptr, this, nullptr);
+        attempt.reply->abort();
+        attempt.reply->deleteLater();
+    }
+
+    if (winner.endpoint != m_endpoints.first()) {
+        Metrics::instance()->incrementCounter("bing_wallpaper_hedge_wins_total");
+    }
+
+    QString endpoint = winner.endpoint;
+    m_attempts.clear();
+    disconnect(reply, nullptr, this, nullptr);
+    emit replyReady(reply, endpoint);
+    deleteLater();
+}
+
+void HedgedRequest::abort() {
+    m_done = true;
+    m_hedgeTimer.stop();
+    for (const Attempt &attempt : std::as_const(m_attempts)) {
+        disconnect(attempt.reply, nullptr, this, nullptr);
+        attempt.reply->abort();
+        attempt.reply->deleteLater();
+    }
+    m_attempts.clear();
+    deleteLater();
+}
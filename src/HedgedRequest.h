@@ -0,0 +1,74 @@
+#ifndef HEDGEDREQUEST_H
+#define HEDGEDREQUEST_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QNetworkAccessManager>
+#include <QNetworkRequest>
+#include <QNetworkReply>
+#include <functional>
+
+class EndpointStats;
+
+/**
+ * @brief 向多个服务器地址发出对冲请求，先响应者胜出
+ *
+ * 先请求最快的地址；超过该地址的 p95 首字节时间仍无响应时，再向下一个地址
+ * 发出同样的请求，请求出错时立即换下一个地址。第一个返回 2xx 响应头的请求胜出，
+ * 其余请求立即取消，胜出的 QNetworkReply 交给调用方继续读取响应体。
+ * 完成或失败后对象自行删除。
+ */
+class HedgedRequest : public QObject {
+    Q_OBJECT
+
+public:
+    typedef std::function<QNetworkRequest(const QUrl &)> RequestFactory;
+
+    /**
+     * @param manager 发出请求使用的网络管理器
+     * @param stats 延迟统计，决定访问顺序和对冲时机，并记录本次结果
+     * @param path 请求路径（含查询参数），拼接在各个服务器地址后面
+     * @param factory 根据完整地址创建请求
+     */
+    HedgedRequest(QNetworkAccessManager *manager, EndpointStats *stats, const QString &path,
+                  RequestFactory factory, QObject *parent = nullptr);
+
+    void start();
+    void abort();
+
+signals:
+    void attemptStarted(QNetworkReply *reply);
+    void replyReady(QNetworkReply *reply, const QString &endpoint);
+    void failed(const QString &errorString);
+
+private:
+    struct Attempt {
+        QNetworkReply *reply;
+        QString endpoint;
+        qint64 startedAt;
+    };
+
+    void startNextAttempt();
+    void onMetaDataChanged(QNetworkReply *reply);
+    void onAttemptFinished(QNetworkReply *reply);
+    void declareWinner(QNetworkReply *reply);
+    int attemptIndex(QNetworkReply *reply) const;
+
+    QNetworkAccessManager *m_manager;
+    EndpointStats *m_stats;
+    QString m_path;
+    RequestFactory m_factory;
+    QStringList m_endpoints;
+    int m_nextEndpoint;
+    QList<Attempt> m_attempts;
+    QTimer m_hedgeTimer;
+    QElapsedTimer m_elapsed;
+    QString m_lastError;
+    bool m_done;
+};
+
+#endif // HEDGEDREQUEST_H
@@ -0,0 +1,64 @@
+#include "ImageAnalyzer.h"
+#include "ImageKernels.h"
+#include "VariantImage.h"
+#include <QImage>
+#include <QFileInfo>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QDebug>
+
+namespace {
+
+// 高于该亮度的图片在暗色模式下过于刺眼，需要压暗
+const double DARK_MODE_MAX_LUMINANCE = 0.45;
+const double DARK_MODE_TARGET_LUMINANCE = 0.30;
+
+}
+
+bool ImageAnalyzer::analyzeFile(const QString &imagePath, const QString &variantDir, WallpaperInfo &info) {
+    QImage image(imagePath);
+    if (image.isNull()) {
+        qDebug() << "分析壁纸失败，无法解码:" << imagePath;
+        return false;
+    }
+    if (image.format() != QImage::Format_RGB32 && image.format() != QImage::Format_ARGB32) {
+        image = image.convertToFormat(QImage::Format_RGB32);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    const uint32_t *pixels = reinterpret_cast<const uint32_t *>(image.constBits());
+    ImageKernels::Analysis analysis = ImageKernels::analyze(pixels, image.width(), image.height(),
+                                                            image.bytesPerLine() / 4);
+
+    info.luminance = analysis.luminance;
+    info.busyness = analysis.busyness;
+    info.palette.clear();
+    for (int i = 0; i < analysis.paletteSize; ++i) {
+        info.palette.append(QString("#%1").arg(analysis.palette[i], 6, 16, QChar('0')));
+    }
+
+    qDebug() << "壁纸分析完成:" << timer.elapsed() << "ms" << ImageKernels::implementationName()
+             << "亮度" << info.luminance << "繁杂度" << info.busyness << info.palette;
+
+    // 本身够暗的图片直接用于暗色模式
+    if (analysis.luminance <= DARK_MODE_MAX_LUMINANCE) {
+        info.darkVariantPath = imagePath;
+        return true;
+    }
+
+    QString darkPath = variantDir + "/" + QFileInfo(imagePath).completeBaseName() + "_dark.jpg";
+    if (!QFile::exists(darkPath)) {
+        int factor = qBound(115, int(256 * DARK_MODE_TARGET_LUMINANCE / analysis.luminance), 256);
+        ImageKernels::scaleBrightness(reinterpret_cast<uint32_t *>(image.bits()),
+                                      size_t(image.bytesPerLine() / 4) * image.height(), factor);
+        if (!VariantImage::save(image, darkPath, 92)) {
+            qDebug() << "保存暗色壁纸失败:" << darkPath;
+            info.darkVariantPath = imagePath;
+            return true;
+        }
+    }
+    info.darkVariantPath = darkPath;
+    return true;
+}
@@ -0,0 +1,25 @@
+#ifndef IMAGEANALYZER_H
+#define IMAGEANALYZER_H
+
+#include <QString>
+#include "WallpaperLibrary.h"
+
+/**
+ * @brief 下载完成后对壁纸做一次性分析
+ *
+ * 计算平均亮度、主色调和画面繁杂度，亮度偏高时额外生成一张压暗的图片
+ * 给 GNOME 暗色模式（picture-uri-dark）使用。耗时操作，应在工作线程中调用。
+ */
+class ImageAnalyzer {
+public:
+    /**
+     * @brief 分析图片并把结果写入 info 的分析字段
+     * @param imagePath 壁纸路径
+     * @param variantDir 存放衍生图片（暗色版本等）的目录
+     * @param info 输出
+     * @return 图片无法解码时返回 false
+     */
+    static bool analyzeFile(const QString &imagePath, const QString &variantDir, WallpaperInfo &info);
+};
+
+#endif // IMAGEANALYZER_H
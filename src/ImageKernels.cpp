@@ -0,0 +1,841 @@
+#include "ImageKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define IMAGEKERNELS_X86 1
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define IMAGEKERNELS_NEON 1
+#endif
+
+namespace ImageKernels {
+
+namespace {
+
+bool g_forceScalar = false;
+
+// Rec.709 亮度权重，放大 256 倍后取整，三者之和为 256
+const int LUMA_R = 54;
+const int LUMA_G = 183;
+const int LUMA_B = 19;
+
+inline uint8_t lumaOf(uint32_t px) {
+    uint32_t r = (px >> 16) & 0xff;
+    uint32_t g = (px >> 8) & 0xff;
+    uint32_t b = px & 0xff;
+    return static_cast<uint8_t>((LUMA_R * r + LUMA_G * g + LUMA_B * b + 128) >> 8);
+}
+
+// ---------------------------------------------------------------- 标量实现
+
+void downsample4xScalar(const uint32_t *src, int width, int height, int stride, uint32_t *dst, int xBegin) {
+    const int outW = width / 4;
+    const int outH = height / 4;
+    for (int oy = 0; oy < outH; ++oy) {
+        const uint32_t *rows[4];
+        for (int r = 0; r < 4; ++r) {
+            rows[r] = src + static_cast<size_t>(oy * 4 + r) * stride;
+        }
+        for (int ox = xBegin; ox < outW; ++ox) {
+            uint32_t sum[4] = {0, 0, 0, 0};
+            for (int r = 0; r < 4; ++r) {
+                for (int i = 0; i < 4; ++i) {
+                    uint32_t px = rows[r][ox * 4 + i];
+                    sum[0] += px & 0xff;
+                    sum[1] += (px >> 8) & 0xff;
+                    sum[2] += (px >> 16) & 0xff;
+                    sum[3] += px >> 24;
+                }
+            }
+            dst[static_cast<size_t>(oy) * outW + ox] = ((sum[0] + 8) >> 4)
+                                                     | (((sum[1] + 8) >> 4) << 8)
+                                                     | (((sum[2] + 8) >> 4) << 16)
+                                                     | (((sum[3] + 8) >> 4) << 24);
+        }
+    }
+}
+
+uint64_t lumaPlaneScalar(const uint32_t *src, size_t begin, size_t count, uint8_t *luma) {
+    uint64_t sum = 0;
+    for (size_t i = begin; i < count; ++i) {
+        luma[i] = lumaOf(src[i]);
+        sum += luma[i];
+    }
+    return sum;
+}
+
+uint64_t gradientRowScalar(const uint8_t *row, const uint8_t *next, int width, int hBegin, int vBegin) {
+    uint64_t sum = 0;
+    for (int x = hBegin; x + 1 < width; ++x) {
+        sum += static_cast<uint64_t>(std::abs(row[x + 1] - row[x]));
+    }
+    if (next) {
+        for (int x = vBegin; x < width; ++x) {
+            sum += static_cast<uint64_t>(std::abs(next[x] - row[x]));
+        }
+    }
+    return sum;
+}
+
+void scaleBrightnessScalar(uint32_t *pixels, size_t begin, size_t count, int factor256) {
+    for (size_t i = begin; i < count; ++i) {
+        uint32_t px = pixels[i];
+        uint32_t b = ((px & 0xff) * factor256) >> 8;
+        uint32_t g = (((px >> 8) & 0xff) * factor256) >> 8;
+        uint32_t r = (((px >> 16) & 0xff) * factor256) >> 8;
+        pixels[i] = (px & 0xff000000u) | (r << 16) | (g << 8) | b;
+    }
+}
+
+// 盒式模糊的除法用定点倒数代替：out = (sum * inv + 2^15) >> 16
+inline uint32_t boxReciprocal(int radius) {
+    const uint32_t window = static_cast<uint32_t>(2 * radius + 1);
+    return (65536u + window / 2) / window;
+}
+
+inline uint32_t boxAverage(uint32_t sum, uint32_t inv) {
+    return std::min<uint32_t>(255u, (sum * inv + 32768u) >> 16);
+}
+
+void boxBlurRowsScalar(uint32_t *pixels, int width, int height, int radius, uint32_t inv, uint32_t *rowCopy) {
+    for (int y = 0; y < height; ++y) {
+        uint32_t *row = pixels + static_cast<size_t>(y) * width;
+        std::memcpy(rowCopy, row, static_cast<size_t>(width) * sizeof(uint32_t));
+
+        uint32_t sum[4];
+        for (int c = 0; c < 4; ++c) {
+            sum[c] = static_cast<uint32_t>(radius + 1) * ((rowCopy[0] >> (8 * c)) & 0xff);
+            for (int i = 1; i <= radius; ++i) {
+                sum[c] += (rowCopy[std::min(i, width - 1)] >> (8 * c)) & 0xff;
+            }
+        }
+
+        for (int x = 0; x < width; ++x) {
+            row[x] = boxAverage(sum[0], inv) | (boxAverage(sum[1], inv) << 8)
+                   | (boxAverage(sum[2], inv) << 16) | (boxAverage(sum[3], inv) << 24);
+            const uint32_t in = rowCopy[std::min(x + radius + 1, width - 1)];
+            const uint32_t out = rowCopy[std::max(x - radius, 0)];
+            for (int c = 0; c < 4; ++c) {
+                sum[c] += ((in >> (8 * c)) & 0xff) - ((out >> (8 * c)) & 0xff);
+            }
+        }
+    }
+}
+
+// 纵向一次处理 16 列（一条缓存行），逐行向下滑动窗口
+const int BLUR_STRIP = 16;
+
+void boxBlurColumnsScalar(const uint32_t *src, uint32_t *dst, int width, int height, int radius, uint32_t inv,
+                          int xBegin, int xEnd) {
+    for (int x0 = xBegin; x0 < xEnd; x0 += BLUR_STRIP) {
+        const int n = std::min(BLUR_STRIP, xEnd - x0);
+        uint32_t sum[BLUR_STRIP][4];
+
+        for (int j = 0; j < n; ++j) {
+            for (int c = 0; c < 4; ++c) {
+                sum[j][c] = static_cast<uint32_t>(radius + 1) * ((src[x0 + j] >> (8 * c)) & 0xff);
+                for (int i = 1; i <= radius; ++i) {
+                    sum[j][c] += (src[static_cast<size_t>(std::min(i, height - 1)) * width + x0 + j] >> (8 * c)) & 0xff;
+                }
+            }
+        }
+
+        for (int y = 0; y < height; ++y) {
+            uint32_t *out = dst + static_cast<size_t>(y) * width + x0;
+            const uint32_t *inRow = src + static_cast<size_t>(std::min(y + radius + 1, height - 1)) * width + x0;
+            const uint32_t *outRow = src + static_cast<size_t>(std::max(y - radius, 0)) * width + x0;
+            for (int j = 0; j < n; ++j) {
+                out[j] = boxAverage(sum[j][0], inv) | (boxAverage(sum[j][1], inv) << 8)
+                       | (boxAverage(sum[j][2], inv) << 16) | (boxAverage(sum[j][3], inv) << 24);
+                for (int c = 0; c < 4; ++c) {
+                    sum[j][c] += ((inRow[j] >> (8 * c)) & 0xff) - ((outRow[j] >> (8 * c)) & 0xff);
+                }
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------- AVX2 实现
+
+#ifdef IMAGEKERNELS_X86
+
+bool cpuHasAvx2() {
+    static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+    return hasAvx2;
+}
+
+__attribute__((target("avx2")))
+void downsample4xAvx2(const uint32_t *src, int width, int height, int stride, uint32_t *dst) {
+    const int outW = width / 4;
+    const int outH = height / 4;
+    const int vecOutW = outW & ~1;   // 每次处理 8 个源像素，得到 2 个输出
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i rounding = _mm256_set1_epi16(8);
+
+    for (int oy = 0; oy < outH; ++oy) {
+        const uint32_t *r0 = src + static_cast<size_t>(oy * 4) * stride;
+        const uint32_t *r1 = r0 + stride;
+        const uint32_t *r2 = r1 + stride;
+        const uint32_t *r3 = r2 + stride;
+        uint32_t *out = dst + static_cast<size_t>(oy) * outW;
+
+        for (int ox = 0; ox < vecOutW; ox += 2) {
+            const int x = ox * 4;
+            __m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(r0 + x));
+            __m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(r1 + x));
+            __m256i a2 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(r2 + x));
+            __m256i a3 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(r3 + x));
+
+            // 每个 128 位通道内有 4 个像素，展开为 16 位后纵向累加 4 行
+            __m256i lo = _mm256_add_epi16(_mm256_add_epi16(_mm256_unpacklo_epi8(a0, zero), _mm256_unpacklo_epi8(a1, zero)),
+                                          _mm256_add_epi16(_mm256_unpacklo_epi8(a2, zero), _mm256_unpacklo_epi8(a3, zero)));
+            __m256i hi = _mm256_add_epi16(_mm256_add_epi16(_mm256_unpackhi_epi8(a0, zero), _mm256_unpackhi_epi8(a1, zero)),
+                                          _mm256_add_epi16(_mm256_unpackhi_epi8(a2, zero), _mm256_unpackhi_epi8(a3, zero)));
+
+            // lo 含像素 0、1，hi 含像素 2、3；相加后再把高低 64 位相加得到 4 个像素之和
+            __m256i s = _mm256_add_epi16(lo, hi);
+            s = _mm256_add_epi16(s, _mm256_srli_si256(s, 8));
+            s = _mm256_srli_epi16(_mm256_add_epi16(s, rounding), 4);
+            __m256i packed = _mm256_packus_epi16(s, s);
+
+            out[ox] = static_cast<uint32_t>(_mm256_cvtsi256_si32(packed));
+            out[ox + 1] = static_cast<uint32_t>(_mm256_extract_epi32(packed, 4));
+        }
+
+        if (vecOutW < outW) {
+            // 奇数宽度的最后一列交给标量实现
+            downsample4xScalar(r0, width, 4, stride, out, vecOutW);
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+uint64_t lumaPlaneAvx2(const uint32_t *src, size_t count, uint8_t *luma) {
+    const __m256i mask = _mm256_set1_epi32(0xff);
+    const __m256i wr = _mm256_set1_epi32(LUMA_R);
+    const __m256i wg = _mm256_set1_epi32(LUMA_G);
+    const __m256i wb = _mm256_set1_epi32(LUMA_B);
+    const __m256i rounding = _mm256_set1_epi32(128);
+
+    uint64_t total = 0;
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    int pending = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        __m256i b = _mm256_and_si256(px, mask);
+        __m256i g = _mm256_and_si256(_mm256_srli_epi32(px, 8), mask);
+        __m256i r = _mm256_and_si256(_mm256_srli_epi32(px, 16), mask);
+        __m256i y = _mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi32(r, wr), _mm256_mullo_epi32(g, wg)),
+                                     _mm256_add_epi32(_mm256_mullo_epi32(b, wb), rounding));
+        y = _mm256_srli_epi32(y, 8);
+        acc = _mm256_add_epi32(acc, y);
+
+        // 32 位 -> 8 位，两个 128 位通道各有 4 个结果
+        __m256i p16 = _mm256_packus_epi32(y, y);
+        __m256i p8 = _mm256_packus_epi16(p16, p16);
+        uint32_t lowLane = static_cast<uint32_t>(_mm256_cvtsi256_si32(p8));
+        uint32_t highLane = static_cast<uint32_t>(_mm256_extract_epi32(p8, 4));
+        std::memcpy(luma + i, &lowLane, 4);
+        std::memcpy(luma + i + 4, &highLane, 4);
+
+        // 每个 32 位累加器最多累加 255 * 65536，远低于溢出上限
+        if (++pending == 65536) {
+            alignas(32) uint32_t lanes[8];
+            _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), acc);
+            for (uint32_t lane : lanes) {
+                total += lane;
+            }
+            acc = _mm256_setzero_si256();
+            pending = 0;
+        }
+    }
+
+    alignas(32) uint32_t lanes[8];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), acc);
+    for (uint32_t lane : lanes) {
+        total += lane;
+    }
+
+    return total + lumaPlaneScalar(src, i, count, luma);
+}
+
+__attribute__((target("avx2")))
+uint64_t gradientSumAvx2(const uint8_t *luma, int width, int height) {
+    __m256i acc = _mm256_setzero_si256();
+    uint64_t tail = 0;
+
+    for (int y = 0; y < height; ++y) {
+        const uint8_t *row = luma + static_cast<size_t>(y) * width;
+        const uint8_t *next = (y + 1 < height) ? row + width : nullptr;
+
+        // _mm256_sad_epu8 一条指令求出 32 对字节差的绝对值之和
+        int hx = 0;
+        for (; hx + 33 <= width; hx += 32) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + hx));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + hx + 1));
+            acc = _mm256_add_epi64(acc, _mm256_sad_epu8(a, b));
+        }
+
+        int vx = 0;
+        if (next) {
+            for (; vx + 32 <= width; vx += 32) {
+                __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + vx));
+                __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(next + vx));
+                acc = _mm256_add_epi64(acc, _mm256_sad_epu8(a, b));
+            }
+        }
+
+        tail += gradientRowScalar(row, next, width, hx, vx);
+    }
+
+    alignas(32) uint64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + tail;
+}
+
+__attribute__((target("avx2")))
+void scaleBrightnessAvx2(uint32_t *pixels, size_t count, int factor256) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i factor = _mm256_set1_epi16(static_cast<short>(factor256));
+    const __m256i alphaMask = _mm256_set1_epi32(static_cast<int>(0xff000000u));
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pixels + i));
+        __m256i lo = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(px, zero), factor), 8);
+        __m256i hi = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(px, zero), factor), 8);
+        __m256i scaled = _mm256_packus_epi16(lo, hi);
+        scaled = _mm256_or_si256(_mm256_andnot_si256(alphaMask, scaled), _mm256_and_si256(alphaMask, px));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(pixels + i), scaled);
+    }
+
+    scaleBrightnessScalar(pixels, i, count, factor256);
+}
+
+// lambda 不继承 target 属性，展开用的小函数单独声明
+__attribute__((target("avx2")))
+inline __m128i widen(uint32_t px) {
+    return _mm_cvtepu8_epi32(_mm_cvtsi32_si128(static_cast<int>(px)));
+}
+
+__attribute__((target("avx2")))
+inline __m256i load2(const uint32_t *p) {
+    return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p)));
+}
+
+__attribute__((target("avx2")))
+void boxBlurRowsAvx2(uint32_t *pixels, int width, int height, int radius, uint32_t inv, uint32_t *rowCopy) {
+    // 横向是串行的滑动求和，用 128 位寄存器同时处理一个像素的 4 个通道
+    const __m128i invVec = _mm_set1_epi32(static_cast<int>(inv));
+    const __m128i rounding = _mm_set1_epi32(32768);
+
+    for (int y = 0; y < height; ++y) {
+        uint32_t *row = pixels + static_cast<size_t>(y) * width;
+        std::memcpy(rowCopy, row, static_cast<size_t>(width) * sizeof(uint32_t));
+
+        __m128i sum = _mm_mullo_epi32(widen(rowCopy[0]), _mm_set1_epi32(radius + 1));
+        for (int i = 1; i <= radius; ++i) {
+            sum = _mm_add_epi32(sum, widen(rowCopy[std::min(i, width - 1)]));
+        }
+
+        for (int x = 0; x < width; ++x) {
+            __m128i avg = _mm_srli_epi32(_mm_add_epi32(_mm_mullo_epi32(sum, invVec), rounding), 16);
+            avg = _mm_packus_epi32(avg, avg);
+            row[x] = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_packus_epi16(avg, avg)));
+            sum = _mm_add_epi32(sum, widen(rowCopy[std::min(x + radius + 1, width - 1)]));
+            sum = _mm_sub_epi32(sum, widen(rowCopy[std::max(x - radius, 0)]));
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+void boxBlurColumnsAvx2(const uint32_t *src, uint32_t *dst, int width, int height, int radius, uint32_t inv) {
+    // 16 列 = 8 个寄存器，每个寄存器存 2 个像素 x 4 通道的 32 位累加和
+    const __m256i invVec = _mm256_set1_epi32(static_cast<int>(inv));
+    const __m256i rounding = _mm256_set1_epi32(32768);
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    const int vecEnd = width - width % BLUR_STRIP;
+
+    for (int x0 = 0; x0 < vecEnd; x0 += BLUR_STRIP) {
+        __m256i sum[8];
+        const __m256i edgeWeight = _mm256_set1_epi32(radius + 1);
+        for (int k = 0; k < 8; ++k) {
+            sum[k] = _mm256_mullo_epi32(load2(src + x0 + 2 * k), edgeWeight);
+        }
+        for (int i = 1; i <= radius; ++i) {
+            const uint32_t *row = src + static_cast<size_t>(std::min(i, height - 1)) * width + x0;
+            for (int k = 0; k < 8; ++k) {
+                sum[k] = _mm256_add_epi32(sum[k], load2(row + 2 * k));
+            }
+        }
+
+        for (int y = 0; y < height; ++y) {
+            uint32_t *out = dst + static_cast<size_t>(y) * width + x0;
+            for (int g = 0; g < 2; ++g) {
+                __m256i avg[4];
+                for (int k = 0; k < 4; ++k) {
+                    avg[k] = _mm256_srli_epi32(_mm256_add_epi32(_mm256_mullo_epi32(sum[4 * g + k], invVec), rounding), 16);
+                }
+                // 打包后像素顺序为 0,2,4,6 | 1,3,5,7，再按 32 位重排
+                __m256i packed = _mm256_packus_epi16(_mm256_packus_epi32(avg[0], avg[1]),
+                                                     _mm256_packus_epi32(avg[2], avg[3]));
+                packed = _mm256_permutevar8x32_epi32(packed, order);
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 8 * g), packed);
+            }
+
+            const uint32_t *inRow = src + static_cast<size_t>(std::min(y + radius + 1, height - 1)) * width + x0;
+            const uint32_t *outRow = src + static_cast<size_t>(std::max(y - radius, 0)) * width + x0;
+            for (int k = 0; k < 8; ++k) {
+                sum[k] = _mm256_sub_epi32(_mm256_add_epi32(sum[k], load2(inRow + 2 * k)), load2(outRow + 2 * k));
+            }
+        }
+    }
+
+    boxBlurColumnsScalar(src, dst, width, height, radius, inv, vecEnd, width);
+}
+
+#endif // IMAGEKERNELS_X86
+
+// ---------------------------------------------------------------- NEON 实现
+
+#ifdef IMAGEKERNELS_NEON
+
+void downsample4xNeon(const uint32_t *src, int width, int height, int stride, uint32_t *dst) {
+    const int outW = width / 4;
+    const int outH = height / 4;
+    const int vecOutW = outW & ~1;
+
+    for (int oy = 0; oy < outH; ++oy) {
+        const uint8_t *rows[4];
+        for (int r = 0; r < 4; ++r) {
+            rows[r] = reinterpret_cast<const uint8_t *>(src + static_cast<size_t>(oy * 4 + r) * stride);
+        }
+        uint32_t *out = dst + static_cast<size_t>(oy) * outW;
+
+        for (int ox = 0; ox < vecOutW; ox += 2) {
+            const int offset = ox * 16;   // 8 个像素 * 4 字节
+            uint16x4_t sums[4] = {vdup_n_u16(0), vdup_n_u16(0), vdup_n_u16(0), vdup_n_u16(0)};
+
+            // vld4 按通道解交织，vpaddl 把相邻两个像素相加
+            for (int r = 0; r < 4; ++r) {
+                uint8x8x4_t px = vld4_u8(rows[r] + offset);
+                for (int c = 0; c < 4; ++c) {
+                    sums[c] = vadd_u16(sums[c], vpaddl_u8(px.val[c]));
+                }
+            }
+
+            uint32_t first = 0;
+            uint32_t second = 0;
+            for (int c = 0; c < 4; ++c) {
+                uint16x4_t quad = vrshr_n_u16(vpadd_u16(sums[c], sums[c]), 4);
+                first |= static_cast<uint32_t>(vget_lane_u16(quad, 0)) << (8 * c);
+                second |= static_cast<uint32_t>(vget_lane_u16(quad, 1)) << (8 * c);
+            }
+            out[ox] = first;
+            out[ox + 1] = second;
+        }
+
+        if (vecOutW < outW) {
+            downsample4xScalar(reinterpret_cast<const uint32_t *>(rows[0]), width, 4, stride, out, vecOutW);
+        }
+    }
+}
+
+uint64_t lumaPlaneNeon(const uint32_t *src, size_t count, uint8_t *luma) {
+    uint64_t total = 0;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        uint8x8x4_t px = vld4_u8(reinterpret_cast<const uint8_t *>(src + i));
+        uint16x8_t y = vmull_u8(px.val[2], vdup_n_u8(LUMA_R));
+        y = vmlal_u8(y, px.val[1], vdup_n_u8(LUMA_G));
+        y = vmlal_u8(y, px.val[0], vdup_n_u8(LUMA_B));
+        uint8x8_t result = vrshrn_n_u16(y, 8);
+        vst1_u8(luma + i, result);
+        total += vaddlv_u8(result);
+    }
+    return total + lumaPlaneScalar(src, i, count, luma);
+}
+
+uint64_t gradientSumNeon(const uint8_t *luma, int width, int height) {
+    uint64_t total = 0;
+
+    for (int y = 0; y < height; ++y) {
+        const uint8_t *row = luma + static_cast<size_t>(y) * width;
+        const uint8_t *next = (y + 1 < height) ? row + width : nullptr;
+        uint32x4_t acc = vdupq_n_u32(0);
+
+        int hx = 0;
+        for (; hx + 17 <= width; hx += 16) {
+            uint8x16_t diff = vabdq_u8(vld1q_u8(row + hx), vld1q_u8(row + hx + 1));
+            acc = vpadalq_u16(acc, vpaddlq_u8(diff));
+        }
+
+        int vx = 0;
+        if (next) {
+            for (; vx + 16 <= width; vx += 16) {
+                uint8x16_t diff = vabdq_u8(vld1q_u8(row + vx), vld1q_u8(next + vx));
+                acc = vpadalq_u16(acc, vpaddlq_u8(diff));
+            }
+        }
+
+        total += vaddlvq_u32(acc) + gradientRowScalar(row, next, width, hx, vx);
+    }
+
+    return total;
+}
+
+void scaleBrightnessNeon(uint32_t *pixels, size_t count, int factor256) {
+    const uint16_t factor = static_cast<uint16_t>(factor256);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        uint8_t *bytes = reinterpret_cast<uint8_t *>(pixels + i);
+        uint8x8x4_t px = vld4_u8(bytes);
+        for (int c = 0; c < 3; ++c) {
+            px.val[c] = vshrn_n_u16(vmulq_n_u16(vmovl_u8(px.val[c]), factor), 8);
+        }
+        vst4_u8(bytes, px);
+    }
+    scaleBrightnessScalar(pixels, i, count, factor256);
+}
+
+void boxBlurColumnsNeon(const uint32_t *src, uint32_t *dst, int width, int height, int radius, uint32_t inv) {
+    // 16 列 = 16 个寄存器，每个寄存器存 1 个像素 x 4 通道
+    const int vecEnd = width - width % BLUR_STRIP;
+
+    auto load4 = [](const uint32_t *p, uint32x4_t *out) {
+        uint8x16_t bytes = vld1q_u8(reinterpret_cast<const uint8_t *>(p));
+        uint16x8_t lo = vmovl_u8(vget_low_u8(bytes));
+        uint16x8_t hi = vmovl_u8(vget_high_u8(bytes));
+        out[0] = vmovl_u16(vget_low_u16(lo));
+        out[1] = vmovl_u16(vget_high_u16(lo));
+        out[2] = vmovl_u16(vget_low_u16(hi));
+        out[3] = vmovl_u16(vget_high_u16(hi));
+    };
+
+    for (int x0 = 0; x0 < vecEnd; x0 += BLUR_STRIP) {
+        uint32x4_t sum[16];
+        uint32x4_t px[16];
+        for (int k = 0; k < 4; ++k) {
+            load4(src + x0 + 4 * k, px + 4 * k);
+        }
+        for (int k = 0; k < 16; ++k) {
+            sum[k] = vmulq_n_u32(px[k], static_cast<uint32_t>(radius + 1));
+        }
+        for (int i = 1; i <= radius; ++i) {
+            const uint32_t *row = src + static_cast<size_t>(std::min(i, height - 1)) * width + x0;
+            for (int k = 0; k < 4; ++k) {
+                load4(row + 4 * k, px + 4 * k);
+            }
+            for (int k = 0; k < 16; ++k) {
+                sum[k] = vaddq_u32(sum[k], px[k]);
+            }
+        }
+
+        for (int y = 0; y < height; ++y) {
+            uint8_t *out = reinterpret_cast<uint8_t *>(dst + static_cast<size_t>(y) * width + x0);
+            for (int k = 0; k < 16; k += 4) {
+                uint16x4_t a[4];
+                for (int j = 0; j < 4; ++j) {
+                    uint32x4_t avg = vshrq_n_u32(vmlaq_n_u32(vdupq_n_u32(32768), sum[k + j], inv), 16);
+                    a[j] = vmovn_u32(avg);
+                }
+                uint8x16_t packed = vcombine_u8(vqmovn_u16(vcombine_u16(a[0], a[1])),
+                                                vqmovn_u16(vcombine_u16(a[2], a[3])));
+                vst1q_u8(out + 4 * k, packed);
+            }
+
+            const uint32_t *inRow = src + static_cast<size_t>(std::min(y + radius + 1, height - 1)) * width + x0;
+            const uint32_t *outRow = src + static_cast<size_t>(std::max(y - radius, 0)) * width + x0;
+            uint32x4_t in[16];
+            for (int k = 0; k < 4; ++k) {
+                load4(inRow + 4 * k, in + 4 * k);
+                load4(outRow + 4 * k, px + 4 * k);
+            }
+            for (int k = 0; k < 16; ++k) {
+                sum[k] = vsubq_u32(vaddq_u32(sum[k], in[k]), px[k]);
+            }
+        }
+    }
+
+    boxBlurColumnsScalar(src, dst, width, height, radius, inv, vecEnd, width);
+}
+
+#endif // IMAGEKERNELS_NEON
+
+} // namespace
+
+// ---------------------------------------------------------------- 分派
+
+void setForceScalar(bool forceScalar) {
+    g_forceScalar = forceScalar;
+}
+
+const char *implementationName() {
+    if (g_forceScalar) {
+        return "scalar";
+    }
+#ifdef IMAGEKERNELS_X86
+    if (cpuHasAvx2()) {
+        return "avx2";
+    }
+#endif
+#ifdef IMAGEKERNELS_NEON
+    return "neon";
+#endif
+    return "scalar";
+}
+
+void downsample4x(const uint32_t *src, int width, int height, int stride, uint32_t *dst) {
+#ifdef IMAGEKERNELS_X86
+    if (!g_forceScalar && cpuHasAvx2()) {
+        downsample4xAvx2(src, width, height, stride, dst);
+        return;
+    }
+#endif
+#ifdef IMAGEKERNELS_NEON
+    if (!g_forceScalar) {
+        downsample4xNeon(src, width, height, stride, dst);
+        return;
+    }
+#endif
+    downsample4xScalar(src, width, height, stride, dst, 0);
+}
+
+uint64_t lumaPlane(const uint32_t *src, size_t count, uint8_t *luma) {
+#ifdef IMAGEKERNELS_X86
+    if (!g_forceScalar && cpuHasAvx2()) {
+        return lumaPlaneAvx2(src, count, luma);
+    }
+#endif
+#ifdef IMAGEKERNELS_NEON
+    if (!g_forceScalar) {
+        return lumaPlaneNeon(src, count, luma);
+    }
+#endif
+    return lumaPlaneScalar(src, 0, count, luma);
+}
+
+uint64_t gradientSum(const uint8_t *luma, int width, int height) {
+#ifdef IMAGEKERNELS_X86
+    if (!g_forceScalar && cpuHasAvx2()) {
+        return gradientSumAvx2(luma, width, height);
+    }
+#endif
+#ifdef IMAGEKERNELS_NEON
+    if (!g_forceScalar) {
+        return gradientSumNeon(luma, width, height);
+    }
+#endif
+    uint64_t sum = 0;
+    for (int y = 0; y < height; ++y) {
+        const uint8_t *row = luma + static_cast<size_t>(y) * width;
+        sum += gradientRowScalar(row, (y + 1 < height) ? row + width : nullptr, width, 0, 0);
+    }
+    return sum;
+}
+
+void scaleBrightness(uint32_t *pixels, size_t count, int factor256) {
+    factor256 = std::max(0, std::min(256, factor256));
+#ifdef IMAGEKERNELS_X86
+    if (!g_forceScalar && cpuHasAvx2()) {
+        scaleBrightnessAvx2(pixels, count, factor256);
+        return;
+    }
+#endif
+#ifdef IMAGEKERNELS_NEON
+    if (!g_forceScalar) {
+        scaleBrightnessNeon(pixels, count, factor256);
+        return;
+    }
+#endif
+    scaleBrightnessScalar(pixels, 0, count, factor256);
+}
+
+void boxBlur(uint32_t *pixels, int width, int height, int radius, int passes) {
+    radius = std::min(radius, std::min(width, height) - 1);
+    if (radius <= 0 || passes <= 0) {
+        return;
+    }
+
+    const uint32_t inv = boxReciprocal(radius);
+    std::vector<uint32_t> scratch(static_cast<size_t>(width) * height);
+    std::vector<uint32_t> rowCopy(static_cast<size_t>(width));
+    uint32_t *current = pixels;
+    uint32_t *other = scratch.data();
+
+    for (int pass = 0; pass < passes; ++pass) {
+        // 横向原地处理，纵向写入另一块缓冲区，两块缓冲区交替使用
+#ifdef IMAGEKERNELS_X86
+        if (!g_forceScalar && cpuHasAvx2()) {
+            boxBlurRowsAvx2(current, width, height, radius, inv, rowCopy.data());
+            boxBlurColumnsAvx2(current, other, width, height, radius, inv);
+            std::swap(current, other);
+            continue;
+        }
+#endif
+#ifdef IMAGEKERNELS_NEON
+        if (!g_forceScalar) {
+            boxBlurRowsScalar(current, width, height, radius, inv, rowCopy.data());
+            boxBlurColumnsNeon(current, other, width, height, radius, inv);
+            std::swap(current, other);
+            continue;
+        }
+#endif
+        boxBlurRowsScalar(current, width, height, radius, inv, rowCopy.data());
+        boxBlurColumnsScalar(current, other, width, height, radius, inv, 0, width);
+        std::swap(current, other);
+    }
+
+    if (current != pixels) {
+        std::memcpy(pixels, current, static_cast<size_t>(width) * height * sizeof(uint32_t));
+    }
+}
+
+void dominantColors(const uint32_t *pixels, size_t count, int k, Analysis &result) {
+    result.paletteSize = 0;
+    k = std::max(1, std::min(k, MAX_PALETTE_SIZE));
+    if (count == 0) {
+        return;
+    }
+
+    // 均匀抽样约 8k 个点，按分量分开存放（SoA），距离计算可被编译器向量化
+    const size_t step = std::max<size_t>(1, count / 8192);
+    const size_t n = (count + step - 1) / step;
+    std::vector<float> pr(n), pg(n), pb(n);
+    for (size_t i = 0, j = 0; i < count && j < n; i += step, ++j) {
+        pr[j] = static_cast<float>((pixels[i] >> 16) & 0xff);
+        pg[j] = static_cast<float>((pixels[i] >> 8) & 0xff);
+        pb[j] = static_cast<float>(pixels[i] & 0xff);
+    }
+
+    // 最远点初始化：结果确定，不依赖随机数
+    std::vector<float> cr, cg, cb;
+    cr.push_back(pr[0]);
+    cg.push_back(pg[0]);
+    cb.push_back(pb[0]);
+    std::vector<float> minDist(n, 1e30f);
+    while (static_cast<int>(cr.size()) < k) {
+        const float r = cr.back(), g = cg.back(), b = cb.back();
+        size_t farthest = 0;
+        for (size_t i = 0; i < n; ++i) {
+            float dr = pr[i] - r, dg = pg[i] - g, db = pb[i] - b;
+            minDist[i] = std::min(minDist[i], dr * dr + dg * dg + db * db);
+            if (minDist[i] > minDist[farthest]) {
+                farthest = i;
+            }
+        }
+        if (minDist[farthest] <= 0.0f) {
+            break;   // 颜色种类少于 k
+        }
+        cr.push_back(pr[farthest]);
+        cg.push_back(pg[farthest]);
+        cb.push_back(pb[farthest]);
+    }
+
+    const int clusters = static_cast<int>(cr.size());
+    std::vector<int> assignment(n, 0);
+    std::vector<float> best(n);
+    std::vector<double> sr(clusters), sg(clusters), sb(clusters);
+    std::vector<size_t> members(clusters);
+
+    for (int iteration = 0; iteration < 10; ++iteration) {
+        std::fill(best.begin(), best.end(), 1e30f);
+        for (int c = 0; c < clusters; ++c) {
+            const float r = cr[c], g = cg[c], b = cb[c];
+            for (size_t i = 0; i < n; ++i) {
+                float dr = pr[i] - r, dg = pg[i] - g, db = pb[i] - b;
+                float d = dr * dr + dg * dg + db * db;
+                if (d < best[i]) {
+                    best[i] = d;
+                    assignment[i] = c;
+                }
+            }
+        }
+
+        std::fill(sr.begin(), sr.end(), 0.0);
+        std::fill(sg.begin(), sg.end(), 0.0);
+        std::fill(sb.begin(), sb.end(), 0.0);
+        std::fill(members.begin(), members.end(), 0);
+        for (size_t i = 0; i < n; ++i) {
+            int c = assignment[i];
+            sr[c] += pr[i];
+            sg[c] += pg[i];
+            sb[c] += pb[i];
+            ++members[c];
+        }
+
+        bool moved = false;
+        for (int c = 0; c < clusters; ++c) {
+            if (members[c] == 0) {
+                continue;
+            }
+            float r = static_cast<float>(sr[c] / members[c]);
+            float g = static_cast<float>(sg[c] / members[c]);
+            float b = static_cast<float>(sb[c] / members[c]);
+            moved = moved || std::abs(r - cr[c]) + std::abs(g - cg[c]) + std::abs(b - cb[c]) > 0.5f;
+            cr[c] = r;
+            cg[c] = g;
+            cb[c] = b;
+        }
+        if (!moved) {
+            break;
+        }
+    }
+
+    std::vector<int> order(clusters);
+    for (int c = 0; c < clusters; ++c) {
+        order[c] = c;
+    }
+    std::sort(order.begin(), order.end(), [&members](int a, int b) {
+        return members[a] > members[b];
+    });
+
+    for (int c : order) {
+        if (members[c] == 0) {
+            continue;
+        }
+        uint32_t r = static_cast<uint32_t>(cr[c] + 0.5f);
+        uint32_t g = static_cast<uint32_t>(cg[c] + 0.5f);
+        uint32_t b = static_cast<uint32_t>(cb[c] + 0.5f);
+        result.palette[result.paletteSize] = (r << 16) | (g << 8) | b;
+        result.paletteWeights[result.paletteSize] = static_cast<float>(members[c]) / static_cast<float>(n);
+        ++result.paletteSize;
+    }
+}
+
+Analysis analyze(const uint32_t *pixels, int width, int height, int stride) {
+    Analysis result;
+    const int smallW = width / 4;
+    const int smallH = height / 4;
+    if (smallW < 2 || smallH < 2) {
+        return result;
+    }
+
+    // 先 4x4 降采样一次，后续所有统计都在 1/16 大小的缓冲区上完成
+    const size_t smallCount = static_cast<size_t>(smallW) * smallH;
+    std::vector<uint32_t> small(smallCount);
+    std::vector<uint8_t> luma(smallCount);
+    downsample4x(pixels, width, height, stride, small.data());
+
+    uint64_t lumaTotal = lumaPlane(small.data(), smallCount, luma.data());
+    result.luminance = static_cast<double>(lumaTotal) / (255.0 * smallCount);
+
+    // 平均梯度约 32 时画面已经非常杂乱，归一化到 0~1
+    uint64_t gradient = gradientSum(luma.data(), smallW, smallH);
+    double meanGradient = static_cast<double>(gradient) / (2.0 * smallCount);
+    result.busyness = std::min(1.0, meanGradient / 32.0);
+
+    dominantColors(small.data(), smallCount, 5, result);
+    return result;
+}
+
+} // namespace ImageKernels
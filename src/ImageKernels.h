@@ -0,0 +1,83 @@
+#ifndef IMAGEKERNELS_H
+#define IMAGEKERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief 图像分析用的底层计算核
+ *
+ * 输入像素为 32 位 0xAARRGGBB（即 QImage::Format_RGB32/ARGB32 在小端机器上的内存布局），
+ * 不依赖 Qt，便于单独做基准测试。
+ * x86 上运行时检测 AVX2，ARM64 上使用 NEON，其余平台走标量实现，三者结果一致。
+ */
+namespace ImageKernels {
+
+const int MAX_PALETTE_SIZE = 8;
+
+struct Analysis {
+    double luminance = 0.0;                 // 平均亮度，0~1
+    double busyness = 0.0;                  // 边缘密度，0~1，越大画面越“杂”
+    int paletteSize = 0;
+    uint32_t palette[MAX_PALETTE_SIZE] = {}; // 主色调 0xRRGGBB，按占比从高到低
+    float paletteWeights[MAX_PALETTE_SIZE] = {};
+};
+
+/**
+ * @brief 4x4 盒式降采样
+ * @param src 源像素
+ * @param width 源宽度
+ * @param height 源高度
+ * @param stride 源每行像素数
+ * @param dst 输出，尺寸为 (width/4) x (height/4)，行间紧密排列
+ */
+void downsample4x(const uint32_t *src, int width, int height, int stride, uint32_t *dst);
+
+/**
+ * @brief 计算亮度平面（Rec.709 权重）并返回亮度总和
+ */
+uint64_t lumaPlane(const uint32_t *src, size_t count, uint8_t *luma);
+
+/**
+ * @brief 水平与垂直方向相邻像素亮度差的绝对值之和
+ */
+uint64_t gradientSum(const uint8_t *luma, int width, int height);
+
+/**
+ * @brief 在降采样后的像素上做 k-means 聚类得到主色调
+ */
+void dominantColors(const uint32_t *pixels, size_t count, int k, Analysis &result);
+
+/**
+ * @brief 按 factor/256 缩放 RGB 分量（用于生成暗色版本）
+ */
+void scaleBrightness(uint32_t *pixels, size_t count, int factor256);
+
+/**
+ * @brief 多次可分离盒式模糊（3 次近似高斯模糊），边缘像素向外复制
+ * @param pixels 像素，行间紧密排列，原地修改
+ * @param width 宽度
+ * @param height 高度
+ * @param radius 模糊半径，窗口大小为 2*radius+1
+ * @param passes 重复次数
+ */
+void boxBlur(uint32_t *pixels, int width, int height, int radius, int passes);
+
+/**
+ * @brief 完整分析一帧图像
+ */
+Analysis analyze(const uint32_t *pixels, int width, int height, int stride);
+
+/**
+ * @brief 当前使用的实现："avx2"、"neon" 或 "scalar"
+ */
+const char *implementationName();
+
+/**
+ * @brief 强制使用标量实现（基准测试对比用）
+ */
+void setForceScalar(bool forceScalar);
+
+} // namespace ImageKernels
+
+#endif // IMAGEKERNELS_H
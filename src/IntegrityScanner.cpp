@@ -0,0 +1,212 @@
+#include "IntegrityScanner.h"
+#include "Awaitables.h"
+#include "Metrics.h"
+#include <QStandardPaths>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace {
+
+// 文件太少时不值得分发到多个线程
+const int MIN_FILES_PER_THREAD = 16;
+
+}
+
+IntegrityScanner::IntegrityScanner(QObject *parent)
+    : QObject(parent)
+    , m_scanning(false)
+{
+    load();
+}
+
+JpegVerifier::Status IntegrityScanner::verifyFile(const QString &path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "无法读取壁纸文件:" << path;
+        return JpegVerifier::Status::NotJpeg;
+    }
+    if (file.size() == 0) {
+        return JpegVerifier::Status::NotJpeg;
+    }
+
+    // 内存映射只读取实际访问到的页，扫描数据部分由 SIMD 顺序扫过
+    uchar *data = file.map(0, file.size());
+    if (!data) {
+        QByteArray contents = file.readAll();
+        return JpegVerifier::verify(reinterpret_cast<const uint8_t *>(contents.constData()),
+                                    static_cast<size_t>(contents.size()));
+    }
+    JpegVerifier::Status status = JpegVerifier::verify(data, static_cast<size_t>(file.size()));
+    file.unmap(data);
+    return status;
+}
+
+bool IntegrityScanner::isScanning() const {
+    return m_scanning;
+}
+
+IntegrityScanner::Outcome IntegrityScanner::verifyAll(const QStringList &paths, const QHash<QString, Stamp> &known,
+                                                      const Async::CancellationToken &token) {
+    QElapsedTimer timer;
+    timer.start();
+
+    struct Shared {
+        std::atomic<int> next{0};
+        QMutex mutex;
+        Outcome outcome;
+        QSemaphore finished;
+    };
+    auto shared = std::make_shared<Shared>();
+
+    // 各线程从同一个计数器领取文件，慢盘上的大文件不会拖住整批
+    auto work = [shared, paths, known, token]() {
+        Outcome local;
+        for (int i = shared->next.fetch_add(1); i < paths.size() && !token.isCancelled();
+             i = shared->next.fetch_add(1)) {
+            const QString &path = paths.at(i);
+            QFileInfo info(path);
+            if (!info.exists()) {
+                continue;
+            }
+
+            Stamp stamp;
+            stamp.size = info.size();
+            stamp.modified = info.lastModified().toMSecsSinceEpoch();
+            auto it = known.constFind(path);
+            if (it != known.constEnd() && it->size == stamp.size && it->modified == stamp.modified) {
+                ++local.report.skipped;
+                local.verified.insert(path, stamp);
+                continue;
+            }
+
+            ++local.report.scanned;
+            JpegVerifier::Status status = verifyFile(path);
+            if (status == JpegVerifier::Status::Ok) {
+                local.verified.insert(path, stamp);
+            } else {
+                qDebug() << "壁纸文件损坏:" << path << JpegVerifier::statusName(status);
+                local.report.corruptFiles.append(path);
+                ++local.reasons[JpegVerifier::statusName(status)];
+            }
+        }
+
+        QMutexLocker locker(&shared->mutex);
+        shared->outcome.report.scanned += local.report.scanned;
+        shared->outcome.report.skipped += local.report.skipped;
+        shared->outcome.report.corruptFiles.append(local.report.corruptFiles);
+        shared->outcome.verified.insert(local.verified);
+        for (auto it = local.reasons.constBegin(); it != local.reasons.constEnd(); ++it) {
+            shared->outcome.reasons[it.key()] += it.value();
+        }
+    };
+
+    QThreadPool *pool = QThreadPool::globalInstance();
+    int helpers = qBound(0, pool->maxThreadCount() - 1, int(paths.size()) / MIN_FILES_PER_THREAD);
+    for (int i = 0; i < helpers; ++i) {
+        pool->start([work, shared]() {
+            work();
+            shared->finished.release();
+        });
+    }
+    work();
+
+    // 当前线程也属于线程池，等待期间让出名额，避免辅助任务排不上队
+    pool->releaseThread();
+    shared->finished.acquire(helpers);
+    pool->reserveThread();
+
+    Outcome outcome = std::move(shared->outcome);
+    outcome.report.elapsedMs = timer.elapsed();
+    return outcome;
+}
+
+Async::Task<IntegrityScanner::Report> IntegrityScanner::scan(QStringList paths, bool force,
+                                                             Async::CancellationToken token) {
+    if (m_scanning) {
+        qDebug() << "完整性检查正在进行，忽略本次请求";
+        co_return Report();
+    }
+    m_scanning = true;
+
+    QHash<QString, Stamp> known = force ? QHash<QString, Stamp>() : m_stamps;
+    auto verify = [paths, known, token]() {
+        return verifyAll(paths, known, token);
+    };
+    Outcome outcome = co_await Async::runInThread(std::move(verify));
+    if (token.isCancelled()) {
+        co_return outcome.report;
+    }
+    m_scanning = false;
+
+    for (const QString &path : std::as_const(paths)) {
+        m_stamps.remove(path);
+    }
+    m_stamps.insert(outcome.verified);
+    save();
+
+    const Report &report = outcome.report;
+    qDebug() << "完整性检查完成: 校验" << report.scanned << "个, 跳过" << report.skipped << "个, 损坏"
+             << report.corruptFiles.size() << "个, 用时" << report.elapsedMs << "ms"
+             << "(" << JpegVerifier::implementationName() << ")";
+    // Metrics 不是线程安全的，统计在主线程汇总
+    for (auto it = outcome.reasons.constBegin(); it != outcome.reasons.constEnd(); ++it) {
+        Metrics::instance()->incrementCounter(QString("bing_wallpaper_corrupt_files_total{reason=\"%1\"}")
+                                              .arg(it.key()), it.value());
+    }
+    Metrics::instance()->observe("bing_wallpaper_integrity_scan_ms", report.elapsedMs,
+                                 {50, 100, 250, 500, 1000, 2500, 5000, 10000});
+    Metrics::instance()->setGauge("bing_wallpaper_integrity_last_scanned_files", report.scanned);
+    co_return report;
+}
+
+QString IntegrityScanner::stampsFilePath() const {
+    QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dataDir);
+    return dataDir + "/verified.json";
+}
+
+void IntegrityScanner::load() {
+    QFile file(stampsFilePath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QJsonObject obj = QJsonDocument::fromJson(file.readAll()).object();
+    for (auto it = obj.constBegin(); it != obj.constEnd(); ++it) {
+        QJsonArray values = it.value().toArray();
+        Stamp stamp;
+        stamp.size = values.at(0).toVariant().toLongLong();
+        stamp.modified = values.at(1).toVariant().toLongLong();
+        m_stamps.insert(it.key(), stamp);
+    }
+}
+
+void IntegrityScanner::save() const {
+    QJsonObject obj;
+    for (auto it = m_stamps.constBegin(); it != m_stamps.constEnd(); ++it) {
+        obj[it.key()] = QJsonArray{QJsonValue(it->size), QJsonValue(it->modified)};
+    }
+
+    QSaveFile file(stampsFilePath());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "保存校验记录失败:" << file.fileName();
+        return;
+    }
+    file.write(QJsonDocument(obj).toJson(QJsonDocument::Compact));
+    file.commit();
+}
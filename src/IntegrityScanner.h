@@ -0,0 +1,68 @@
+#ifndef INTEGRITYSCANNER_H
+#define INTEGRITYSCANNER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QMap>
+#include "JpegVerifier.h"
+#include "Task.h"
+
+/**
+ * @brief 并行校验壁纸库中的 JPEG 文件是否完整
+ *
+ * 文件通过内存映射读取，由 JpegVerifier 检查结构，不做完整解码。
+ * 校验通过的文件记录大小和修改时间（保存在应用数据目录的 verified.json），
+ * 之后未变化的文件直接跳过，启动时的例行检查只需读取新文件。
+ */
+class IntegrityScanner : public QObject {
+    Q_OBJECT
+
+public:
+    struct Report {
+        QStringList corruptFiles;
+        int scanned = 0;        // 实际读取校验的文件数
+        int skipped = 0;        // 上次校验后未变化而跳过的文件数
+        qint64 elapsedMs = 0;
+    };
+
+    explicit IntegrityScanner(QObject *parent = nullptr);
+
+    /**
+     * @brief 校验单个文件，可以在任意线程调用
+     */
+    static JpegVerifier::Status verifyFile(const QString &path);
+
+    /**
+     * @brief 在线程池中校验一批文件，不存在的文件不算损坏
+     * @param force 为 true 时忽略之前的校验记录，全部重新读取
+     * @param token 取消后尽快结束，返回已完成部分的结果
+     */
+    Async::Task<Report> scan(QStringList paths, bool force, Async::CancellationToken token);
+
+    bool isScanning() const;
+
+private:
+    struct Stamp {
+        qint64 size = -1;
+        qint64 modified = -1;
+    };
+
+    struct Outcome {
+        Report report;
+        QHash<QString, Stamp> verified;
+        QMap<QString, int> reasons;     // 损坏原因 -> 文件数
+    };
+
+    static Outcome verifyAll(const QStringList &paths, const QHash<QString, Stamp> &known,
+                             const Async::CancellationToken &token);
+    void load();
+    void save() const;
+    QString stampsFilePath() const;
+
+    QHash<QString, Stamp> m_stamps;
+    bool m_scanning;
+};
+
+#endif // INTEGRITYSCANNER_H
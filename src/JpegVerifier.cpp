@@ -0,0 +1,247 @@
+#include "JpegVerifier.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define JPEGVERIFIER_X86 1
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define JPEGVERIFIER_NEON 1
+#endif
+
+namespace JpegVerifier {
+
+namespace {
+
+bool g_forceScalar = false;
+
+const uint8_t MARKER_PREFIX = 0xFF;
+const uint8_t SOI = 0xD8;
+const uint8_t EOI = 0xD9;
+const uint8_t SOS = 0xDA;
+const uint8_t TEM = 0x01;
+const uint8_t RST0 = 0xD0;
+const uint8_t RST7 = 0xD7;
+
+inline bool isRestartMarker(uint8_t marker) {
+    return marker >= RST0 && marker <= RST7;
+}
+
+// SOF0~SOF15，其中 C4(DHT)、C8(JPG)、CC(DAC) 不是图像帧
+inline bool isFrameMarker(uint8_t marker) {
+    return marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+}
+
+// ---------------------------------------------------------------- 标量实现
+
+size_t findPrefixScalar(const uint8_t *data, size_t pos, size_t size) {
+    while (pos < size && data[pos] != MARKER_PREFIX) {
+        ++pos;
+    }
+    return pos;
+}
+
+#ifdef JPEGVERIFIER_X86
+
+bool cpuHasAvx2() {
+    static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+    return hasAvx2;
+}
+
+__attribute__((target("avx2")))
+size_t findPrefixAvx2(const uint8_t *data, size_t pos, size_t size) {
+    const __m256i prefix = _mm256_set1_epi8(static_cast<char>(MARKER_PREFIX));
+    // 扫描数据中 0xFF 很少，一次比较 64 字节，命中后再定位
+    for (; pos + 64 <= size; pos += 64) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + pos));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + pos + 32));
+        __m256i hits = _mm256_or_si256(_mm256_cmpeq_epi8(a, prefix), _mm256_cmpeq_epi8(b, prefix));
+        if (_mm256_testz_si256(hits, hits)) {
+            continue;
+        }
+        uint32_t low = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, prefix)));
+        if (low) {
+            return pos + __builtin_ctz(low);
+        }
+        uint32_t high = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(b, prefix)));
+        return pos + 32 + __builtin_ctz(high);
+    }
+    return findPrefixScalar(data, pos, size);
+}
+
+#ifdef __SSE2__
+size_t findPrefixSse2(const uint8_t *data, size_t pos, size_t size) {
+    const __m128i prefix = _mm_set1_epi8(static_cast<char>(MARKER_PREFIX));
+    for (; pos + 16 <= size; pos += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, prefix)));
+        if (mask) {
+            return pos + __builtin_ctz(mask);
+        }
+    }
+    return findPrefixScalar(data, pos, size);
+}
+#endif
+
+#endif // JPEGVERIFIER_X86
+
+#ifdef JPEGVERIFIER_NEON
+
+size_t findPrefixNeon(const uint8_t *data, size_t pos, size_t size) {
+    const uint8x16_t prefix = vdupq_n_u8(MARKER_PREFIX);
+    for (; pos + 16 <= size; pos += 16) {
+        uint8x16_t hits = vceqq_u8(vld1q_u8(data + pos), prefix);
+        if (vmaxvq_u8(hits) == 0) {
+            continue;
+        }
+        return findPrefixScalar(data, pos, pos + 16);
+    }
+    return findPrefixScalar(data, pos, size);
+}
+
+#endif // JPEGVERIFIER_NEON
+
+// ---------------------------------------------------------------- 分发
+
+size_t findPrefix(const uint8_t *data, size_t pos, size_t size) {
+#ifdef JPEGVERIFIER_X86
+    if (!g_forceScalar && cpuHasAvx2()) {
+        return findPrefixAvx2(data, pos, size);
+    }
+#ifdef __SSE2__
+    if (!g_forceScalar) {
+        return findPrefixSse2(data, pos, size);
+    }
+#endif
+#endif
+#ifdef JPEGVERIFIER_NEON
+    if (!g_forceScalar) {
+        return findPrefixNeon(data, pos, size);
+    }
+#endif
+    return findPrefixScalar(data, pos, size);
+}
+
+/**
+ * @brief 跳过熵编码数据，返回下一个真正标记的 0xFF 位置，找不到时返回 size
+ *
+ * 扫描数据中的 0xFF 00 是转义的数据字节，0xFF D0~D7 是重启标记，0xFF FF 是填充，都不结束扫描。
+ */
+size_t skipEntropyData(const uint8_t *data, size_t pos, size_t size) {
+    while (true) {
+        pos = findPrefix(data, pos, size);
+        if (pos + 1 >= size) {
+            return size;
+        }
+        uint8_t next = data[pos + 1];
+        if (next == 0x00 || isRestartMarker(next)) {
+            pos += 2;
+        } else if (next == MARKER_PREFIX) {
+            pos += 1;
+        } else {
+            return pos;
+        }
+    }
+}
+
+} // namespace
+
+Status verify(const uint8_t *data, size_t size) {
+    if (size < 2 || data[0] != MARKER_PREFIX || data[1] != SOI) {
+        return Status::NotJpeg;
+    }
+
+    bool hasFrame = false;
+    bool hasScan = false;
+    size_t pos = 2;
+    while (true) {
+        if (pos >= size) {
+            return Status::Truncated;
+        }
+        if (data[pos] != MARKER_PREFIX) {
+            return Status::BadSegment;
+        }
+        // 标记前允许任意个 0xFF 填充字节
+        while (pos < size && data[pos] == MARKER_PREFIX) {
+            ++pos;
+        }
+        if (pos >= size) {
+            return Status::Truncated;
+        }
+
+        const uint8_t marker = data[pos++];
+        if (marker == EOI) {
+            return hasFrame && hasScan ? Status::Ok : Status::MissingImage;
+        }
+        if (marker == 0x00 || marker == SOI) {
+            return Status::BadSegment;
+        }
+        if (marker == TEM || isRestartMarker(marker)) {
+            continue;
+        }
+
+        // 其余标记后面是两字节大端长度，长度包含自身
+        if (size - pos < 2) {
+            return Status::Truncated;
+        }
+        const size_t length = (static_cast<size_t>(data[pos]) << 8) | data[pos + 1];
+        if (length < 2) {
+            return Status::BadSegment;
+        }
+        if (size - pos < length) {
+            return Status::Truncated;
+        }
+        pos += length;
+
+        if (isFrameMarker(marker)) {
+            hasFrame = true;
+        } else if (marker == SOS) {
+            if (!hasFrame) {
+                return Status::MissingImage;
+            }
+            hasScan = true;
+            pos = skipEntropyData(data, pos, size);
+        }
+    }
+}
+
+const char *statusName(Status status) {
+    switch (status) {
+    case Status::Ok:
+        return "ok";
+    case Status::NotJpeg:
+        return "not_jpeg";
+    case Status::Truncated:
+        return "truncated";
+    case Status::BadSegment:
+        return "bad_segment";
+    case Status::MissingImage:
+        return "missing_image";
+    }
+    return "unknown";
+}
+
+const char *implementationName() {
+    if (g_forceScalar) {
+        return "scalar";
+    }
+#ifdef JPEGVERIFIER_X86
+    if (cpuHasAvx2()) {
+        return "avx2";
+    }
+#ifdef __SSE2__
+    return "sse2";
+#endif
+#endif
+#ifdef JPEGVERIFIER_NEON
+    return "neon";
+#endif
+    return "scalar";
+}
+
+void setForceScalar(bool forceScalar) {
+    g_forceScalar = forceScalar;
+}
+
+} // namespace JpegVerifier
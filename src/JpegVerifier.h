@@ -0,0 +1,46 @@
+#ifndef JPEGVERIFIER_H
+#define JPEGVERIFIER_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief 不解码地检查 JPEG 文件结构是否完整
+ *
+ * 依次检查 SOI、各标记段长度、图像帧与扫描数据，扫描数据中向量化查找下一个标记，
+ * 直到遇到 EOI。能发现下载中断或崩溃留下的截断文件，但不能发现熵编码数据内部的损坏。
+ * 不依赖 Qt，便于单独做基准测试；x86 上运行时检测 AVX2，ARM64 上使用 NEON。
+ */
+namespace JpegVerifier {
+
+enum class Status {
+    Ok,
+    NotJpeg,            // 没有 SOI 标记
+    Truncated,          // 数据在 EOI 之前结束
+    BadSegment,         // 标记段长度或标记本身不合法
+    MissingImage        // 没有图像帧或扫描数据
+};
+
+/**
+ * @brief 检查一段完整的 JPEG 数据
+ */
+Status verify(const uint8_t *data, size_t size);
+
+/**
+ * @brief 状态的英文简称，用于日志和指标标签
+ */
+const char *statusName(Status status);
+
+/**
+ * @brief 当前使用的实现："avx2"、"sse2"、"neon" 或 "scalar"
+ */
+const char *implementationName();
+
+/**
+ * @brief 强制使用标量实现（基准测试对比用）
+ */
+void setForceScalar(bool forceScalar);
+
+} // namespace JpegVerifier
+
+#endif // JPEGVERIFIER_H
@@ -0,0 +1,62 @@
+#include "LockScreenGenerator.h"
+#include "ImageKernels.h"
+#include "VariantImage.h"
+#include <QImage>
+#include <QImageReader>
+#include <QFile>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <QDebug>
+
+namespace {
+
+const int BLUR_PASSES = 3;          // 3 次盒式模糊已接近高斯模糊
+const int BASE_BLUR_RADIUS = 8;     // 1/4 分辨率下的半径，相当于原图 32 像素
+const int LOCK_DIM_FACTOR = 150;    // 亮度压到约 60%，保证锁屏时钟和文字清晰
+
+}
+
+QString LockScreenGenerator::variantPath(const QString &imagePath, const QString &variantDir) {
+    return variantDir + "/" + QFileInfo(imagePath).completeBaseName() + "_lock.jpg";
+}
+
+QString LockScreenGenerator::generate(const QString &imagePath, const QString &variantDir, double busyness) {
+    QString lockPath = variantPath(imagePath, variantDir);
+    if (QFile::exists(lockPath)) {
+        return lockPath;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // 让 JPEG 解码器按 DCT 缩放直接输出 1/4 尺寸
+    QImageReader reader(imagePath);
+    QSize size = reader.size();
+    if (size.isValid()) {
+        reader.setScaledSize(size / 4);
+    }
+    QImage image = reader.read();
+    if (image.isNull()) {
+        qDebug() << "生成锁屏图片失败，无法解码:" << imagePath;
+        return QString();
+    }
+    // RGB32 每行恰好 width*4 字节，满足模糊核要求的紧密排列
+    image = image.convertToFormat(QImage::Format_RGB32);
+
+    int radius = BASE_BLUR_RADIUS;
+    if (busyness >= 0.0) {
+        radius += qRound(busyness * BASE_BLUR_RADIUS);
+    }
+
+    uint32_t *pixels = reinterpret_cast<uint32_t *>(image.bits());
+    ImageKernels::boxBlur(pixels, image.width(), image.height(), radius, BLUR_PASSES);
+    ImageKernels::scaleBrightness(pixels, size_t(image.width()) * image.height(), LOCK_DIM_FACTOR);
+
+    if (!VariantImage::save(image, lockPath, 90)) {
+        qDebug() << "保存锁屏图片失败:" << lockPath;
+        return QString();
+    }
+
+    qDebug() << "锁屏图片已生成:" << lockPath << timer.elapsed() << "ms";
+    return lockPath;
+}
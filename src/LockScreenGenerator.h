@@ -0,0 +1,27 @@
+#ifndef LOCKSCREENGENERATOR_H
+#define LOCKSCREENGENERATOR_H
+
+#include <QString>
+
+/**
+ * @brief 生成锁屏使用的模糊、压暗版本壁纸
+ *
+ * 解码时直接缩小到 1/4 分辨率，模糊后画面本来就没有细节，
+ * 既省去了大部分解码和模糊的计算量，保存的文件也很小。
+ * 每张壁纸只生成一次，之后直接复用已有文件。耗时操作，应在工作线程中调用。
+ */
+class LockScreenGenerator {
+public:
+    /**
+     * @brief 生成（或复用）锁屏图片
+     * @param imagePath 壁纸路径
+     * @param variantDir 存放衍生图片的目录
+     * @param busyness 画面繁杂度（0~1，未知时为负数），越杂乱模糊越强
+     * @return 锁屏图片路径，失败时返回空字符串
+     */
+    static QString generate(const QString &imagePath, const QString &variantDir, double busyness = -1.0);
+
+    static QString variantPath(const QString &imagePath, const QString &variantDir);
+};
+
+#endif // LOCKSCREENGENERATOR_H
@@ -1,48 +1,132 @@
 #include "MainWindow.h"
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
 #include <QApplication>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QGroupBox>
 #include <QMessageBox>
 #include <QCloseEvent>
+#include <QShowEvent>
+#include <QHideEvent>
 #include <QDesktopServices>
 #include <QUrl>
-#include <QSettings>
 #include <QPixmap>
 #include <QLabel>
 #include <QDialog>
 #include <QScrollArea>
 #include <QFileDialog>
-#include <QPainter>
-#include <QPainterPath>
+#include <QDir>
 #include <QDebug>
 #include <QStyle>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QPixmapCache>
+#include <QSignalBlocker>
+#include <QLocale>
+#include "Metrics.h"
+#include "SettingsStore.h"
+#include "ThumbnailCache.h"
+#include "WallpaperGalleryModel.h"
+#include "WallpaperGalleryView.h"
+
+namespace {
+
+// 定时更新前多久预热连接，需短于 QNetworkAccessManager 关闭空闲连接的时间
+const int PREWARM_LEAD_MS = 15000;
+
+}
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , m_wallpaperSetter(new BingWallpaperSetter(this))
     , m_trayIcon(new QSystemTrayIcon(this))
+    , m_trayMenu(nullptr)
     , m_autoUpdateTimer(new QTimer(this))
+    , m_prewarmTimer(new QTimer(this))
+    , m_statusLabel(nullptr)
+    , m_currentWallpaperLabel(nullptr)
+    , m_wallpaperPreviewLabel(nullptr)
+    , m_directoryLabel(nullptr)
+    , m_prevButton(nullptr)
+    , m_nextButton(nullptr)
+    , m_updateButton(nullptr)
+    , m_openFolderButton(nullptr)
+    , m_galleryButton(nullptr)
+    , m_changeDirectoryButton(nullptr)
+    , m_resetDirectoryButton(nullptr)
+    , m_autoUpdateCheckBox(nullptr)
+    , m_lowMemoryCheckBox(nullptr)
+    , m_updateIntervalSpinBox(nullptr)
+    , m_progressBar(nullptr)
+    , m_searchEdit(nullptr)
+    , m_searchResultList(nullptr)
+    , m_releaseUiTimer(new QTimer(this))
     , m_isAutoUpdateEnabled(false)
     , m_updateIntervalHours(24)
+    , m_lowMemoryMode(true)
+    , m_uiBuilt(false)
+    , m_isDownloading(false)
+    , m_downloadPercentage(0)
+    , m_lastOffset(-1)
+    , m_libraryCheckRequested(false)
 {
-    setupUI();
-    setupSystemTray();
+    setWindowTitle("Bing壁纸设置器");
+    setMinimumSize(500, 400);
+    setWindowIcon(createBingIcon(false));  // 窗口使用PNG
+    
+    m_prewarmTimer->setSingleShot(true);
+    connect(m_prewarmTimer, &QTimer::timeout, m_wallpaperSetter, &BingWallpaperSetter::prewarmConnections);
+    
     loadSettings();
     
+    // 程序启动后隐藏在托盘中，低内存模式下界面推迟到第一次显示时再创建
+    if (!m_lowMemoryMode) {
+        ensureUi();
+    }
+    setupSystemTray();
+    
+    // 窗口隐藏一段时间后再释放，避免反复开关窗口时频繁重建
+    m_releaseUiTimer->setSingleShot(true);
+    m_releaseUiTimer->setInterval(30000);
+    connect(m_releaseUiTimer, &QTimer::timeout, this, &MainWindow::releaseUi);
+    
+    Metrics::instance()->sampleProcessMemory();
+    
     // 连接信号
     connect(m_wallpaperSetter, &BingWallpaperSetter::downloadStarted, 
             this, &MainWindow::onDownloadStarted);
     connect(m_wallpaperSetter, &BingWallpaperSetter::downloadProgress, 
             this, &MainWindow::onDownloadProgress);
+    connect(m_wallpaperSetter, &BingWallpaperSetter::downloadPreviewAvailable, 
+            this, &MainWindow::onDownloadPreview);
+    connect(m_wallpaperSetter, &BingWallpaperSetter::downloadRateChanged, 
+            this, &MainWindow::onDownloadRateChanged);
+    connect(m_wallpaperSetter, &BingWallpaperSetter::downloadRetrying, 
+            this, &MainWindow::onDownloadRetrying);
     connect(m_wallpaperSetter, &BingWallpaperSetter::downloadFinished, 
             this, &MainWindow::onDownloadFinished);
     connect(m_wallpaperSetter, &BingWallpaperSetter::wallpaperSet, 
             this, &MainWindow::onWallpaperSet);
+    connect(m_wallpaperSetter, &BingWallpaperSetter::wallpaperApplyFailed, 
+            this, &MainWindow::onWallpaperApplyFailed);
+    connect(m_wallpaperSetter, &BingWallpaperSetter::libraryVerified, 
+            this, &MainWindow::onLibraryVerified);
+    connect(m_wallpaperSetter, &BingWallpaperSetter::wallpaperDirectoryChanged, 
+            this, &MainWindow::updateDirectoryLabel);
+    
+    connect(m_wallpaperSetter->library(), &WallpaperLibrary::libraryChanged, this, [this]() {
+        if (m_searchEdit) {
+            onSearchTextChanged(m_searchEdit->text());
+        }
+    });
     
-    connect(m_autoUpdateTimer, &QTimer::timeout, this, &MainWindow::updateWallpaper);
+    connect(m_autoUpdateTimer, &QTimer::timeout, this, &MainWindow::onAutoUpdateTimeout);
+    connect(m_autoUpdateTimer, &QTimer::timeout, this, &MainWindow::schedulePrewarm);
     
-    // 启动时更新一次壁纸
+    // 启动时更新一次壁纸，先利用这一秒建立连接
+    m_wallpaperSetter->prewarmConnections();
     QTimer::singleShot(1000, this, &MainWindow::updateWallpaper);
     
     // 启动时加载预览
@@ -51,13 +135,11 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow() {
     saveSettings();
+    // 此时事件循环已经结束，等待后台写回完成
+    SettingsStore::instance()->flush();
 }
 
 void MainWindow::setupUI() {
-    setWindowTitle("Bing壁纸设置器");
-    setMinimumSize(500, 400);
-    setWindowIcon(createBingIcon(false));  // 窗口使用PNG
-    
     QWidget *centralWidget = new QWidget(this);
     QVBoxLayout *mainLayout = new QVBoxLayout(centralWidget);
     
@@ -95,6 +177,25 @@ void MainWindow::setupUI() {
     
     mainLayout->addWidget(previewGroup);
     
+    // 壁纸搜索组
+    QGroupBox *searchGroup = new QGroupBox("🔍 搜索壁纸库", this);
+    QVBoxLayout *searchLayout = new QVBoxLayout(searchGroup);
+    
+    m_searchEdit = new QLineEdit(this);
+    m_searchEdit->setPlaceholderText("输入标题、版权或地点关键字");
+    m_searchEdit->setClearButtonEnabled(true);
+    connect(m_searchEdit, &QLineEdit::textChanged, this, &MainWindow::onSearchTextChanged);
+    searchLayout->addWidget(m_searchEdit);
+    
+    m_searchResultList = new QListWidget(this);
+    m_searchResultList->setMaximumHeight(150);
+    m_searchResultList->setVisible(false);
+    m_searchResultList->setToolTip("双击将该壁纸设置为桌面背景");
+    connect(m_searchResultList, &QListWidget::itemActivated, this, &MainWindow::onSearchResultActivated);
+    searchLayout->addWidget(m_searchResultList);
+    
+    mainLayout->addWidget(searchGroup);
+    
     // 操作组
     QGroupBox *actionGroup = new QGroupBox("操作", this);
     QVBoxLayout *actionLayout = new QVBoxLayout(actionGroup);
@@ -134,6 +235,10 @@ void MainWindow::setupUI() {
     m_openFolderButton = new QPushButton(QIcon(style->standardPixmap(QStyle::SP_DirOpenIcon)), "打开壁纸文件夹");
     connect(m_openFolderButton, &QPushButton::clicked, this, &MainWindow::openWallpaperFolder);
     actionLayout->addWidget(m_openFolderButton);
+    
+    m_galleryButton = new QPushButton(QIcon(style->standardPixmap(QStyle::SP_FileDialogContentsView)), "浏览壁纸库");
+    connect(m_galleryButton, &QPushButton::clicked, this, &MainWindow::openLibraryGallery);
+    actionLayout->addWidget(m_galleryButton);
     mainLayout->addWidget(actionGroup);
     
     // 壁纸存储路径设置组
@@ -180,7 +285,7 @@ void MainWindow::setupUI() {
     connect(m_updateIntervalSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), [this](int value) {
         m_updateIntervalHours = value;
         if (m_isAutoUpdateEnabled) {
-            m_autoUpdateTimer->start(m_updateIntervalHours * 3600000);
+            startAutoUpdateTimer();
         }
         saveSettings();
     });
@@ -188,6 +293,14 @@ void MainWindow::setupUI() {
     intervalLayout->addStretch();
     
     autoUpdateLayout->addLayout(intervalLayout);
+    
+    m_lowMemoryCheckBox = new QCheckBox("隐藏到托盘时释放界面内存", this);
+    m_lowMemoryCheckBox->setToolTip("窗口隐藏后释放预览图和界面控件，再次打开时重新创建");
+    connect(m_lowMemoryCheckBox, &QCheckBox::toggled, [this](bool checked) {
+        m_lowMemoryMode = checked;
+        saveSettings();
+    });
+    autoUpdateLayout->addWidget(m_lowMemoryCheckBox);
     mainLayout->addWidget(autoUpdateGroup);
     
     mainLayout->addStretch();
@@ -201,94 +314,132 @@ void MainWindow::setupUI() {
     setCentralWidget(centralWidget);
 }
 
+void MainWindow::ensureUi() {
+    if (m_uiBuilt) {
+        return;
+    }
+    setupUI();
+    m_uiBuilt = true;
+    applyStateToUi();
+}
+
+void MainWindow::applyStateToUi() {
+    updateSettingsWidgets();
+    updateDirectoryLabel();
+    
+    QString wallpaperPath = m_wallpaperSetter->getCurrentWallpaperPath();
+    if (!wallpaperPath.isEmpty()) {
+        m_currentWallpaperLabel->setText("当前壁纸: " + wallpaperPath);
+    }
+    updateWallpaperPreview();
+    
+    if (m_isDownloading) {
+        m_statusLabel->setText("正在下载壁纸...");
+        m_progressBar->setValue(m_downloadPercentage);
+        m_progressBar->setVisible(true);
+        m_updateButton->setEnabled(false);
+        m_prevButton->setEnabled(false);
+        m_nextButton->setEnabled(false);
+    } else {
+        updateNavigationButtons();
+    }
+}
+
+void MainWindow::updateNavigationButtons() {
+    if (!m_uiBuilt) {
+        return;
+    }
+    m_updateButton->setEnabled(true);
+    m_prevButton->setEnabled(m_lastOffset != 7);
+    m_nextButton->setEnabled(m_lastOffset != 0);
+}
+
+void MainWindow::releaseUi() {
+    if (!m_uiBuilt || isVisible()) {
+        return;
+    }
+    
+    // 中央控件销毁时会连同预览图、搜索结果等子控件一起释放
+    delete takeCentralWidget();
+    m_statusLabel = nullptr;
+    m_currentWallpaperLabel = nullptr;
+    m_wallpaperPreviewLabel = nullptr;
+    m_directoryLabel = nullptr;
+    m_prevButton = nullptr;
+    m_nextButton = nullptr;
+    m_updateButton = nullptr;
+    m_openFolderButton = nullptr;
+    m_galleryButton = nullptr;
+    m_changeDirectoryButton = nullptr;
+    m_resetDirectoryButton = nullptr;
+    m_autoUpdateCheckBox = nullptr;
+    m_lowMemoryCheckBox = nullptr;
+    m_updateIntervalSpinBox = nullptr;
+    m_progressBar = nullptr;
+    m_searchEdit = nullptr;
+    m_searchResultList = nullptr;
+    m_uiBuilt = false;
+    
+    QPixmapCache::clear();
+#ifdef __GLIBC__
+    // 把释放的堆内存归还给系统，否则 RSS 不会下降
+    malloc_trim(0);
+#endif
+    
+    Metrics::instance()->sampleProcessMemory();
+    qDebug() << "已释放界面资源";
+}
+
+void MainWindow::showMainWindow() {
+    ensureUi();
+    showNormal();
+    activateWindow();
+}
+
+void MainWindow::showEvent(QShowEvent *event) {
+    m_releaseUiTimer->stop();
+    ensureUi();
+    m_wallpaperSetter->setProgressivePreviewEnabled(true);
+    // 打开窗口后很可能会点击更新或切换壁纸
+    m_wallpaperSetter->prewarmConnections();
+    QMainWindow::showEvent(event);
+}
+
+void MainWindow::hideEvent(QHideEvent *event) {
+    QMainWindow::hideEvent(event);
+    m_wallpaperSetter->setProgressivePreviewEnabled(false);
+    if (m_lowMemoryMode && !event->spontaneous()) {
+        m_releaseUiTimer->start();
+    } else {
+        // 不释放界面时在这里记录常驻内存，释放界面时由 releaseUi 记录
+        Metrics::instance()->sampleProcessMemory();
+    }
+}
+
 QIcon MainWindow::createBingIcon(bool forTray) {
-    // 如果是窗口图标，直接使用PNG文件
-    if (!forTray) {
-        QIcon icon("/usr/share/pixmaps/bing-wallpaper-setter.png");
-        if (!icon.isNull()) {
-            return icon;
+    // 各尺寸的图标在编译时生成并嵌入资源（见 tools/IconGenerator.cpp），这里只需按尺寸登记，
+    // 由 QIcon 按托盘和窗口的实际尺寸与缩放比例选取，不再在运行时绘制或缩放
+    QString prefix = "app-";
+    if (forTray) {
+        prefix = QString("tray-%1-").arg(SettingsStore::instance()->value(SettingsKeys::TrayIconVariant));
+    }
+
+    QIcon icon;
+    const QStringList files = QDir(":/icons").entryList({prefix + "*.png"}, QDir::Files);
+    for (const QString &file : files) {
+        int size = file.mid(prefix.size()).chopped(4).toInt();
+        if (size > 0) {
+            icon.addFile(":/icons/" + file, QSize(size, size));
         }
     }
-    
-    // 托盘图标：创建基于 Bing 官方 SVG 的图标
-    QPixmap pixmap(64, 64);
-    pixmap.fill(Qt::transparent);
-    QPainter painter(&pixmap);
-    painter.setRenderHint(QPainter::Antialiasing);
-    
-    // 托盘图标始终使用白色
-    QColor iconColor(255, 255, 255);
-    
-    painter.setBrush(iconColor);
-    painter.setPen(Qt::NoPen);
-    
-    // 缩放和偏移以适应64x64画布
-    painter.translate(8, 8);
-    painter.scale(2.0, 2.0);
-    
-    // 绘制 Bing SVG 路径
-    QPainterPath path;
-    path.moveTo(4.842, 0.005);
-    
-    // SVG path data 转换为 QPainterPath
-    path.cubicTo(5.046, -0.042, 5.263, 0.005, 5.446, 0.147);
-    path.lineTo(8.066, 1.960);
-    path.cubicTo(8.435, 2.216, 8.558, 2.312, 8.703, 2.456);
-    path.cubicTo(9.174, 2.926, 9.455, 3.546, 9.500, 4.221);
-    path.lineTo(9.508, 5.068);
-    path.lineTo(9.511, 6.509);
-    path.lineTo(9.515, 19.511);
-    path.lineTo(9.659, 19.417);
-    path.lineTo(16.674, 15.064);
-    path.lineTo(16.689, 15.067);
-    path.lineTo(16.718, 15.077);
-    path.cubicTo(16.320, 14.907, 15.825, 14.738, 15.063, 14.511);
-    path.lineTo(14.579, 14.365);
-    path.cubicTo(13.995, 14.185, 13.869, 14.127, 13.658, 13.985);
-    path.cubicTo(13.525, 13.894, 13.405, 13.784, 13.288, 13.673);
-    path.cubicTo(13.108, 13.488, 12.953, 13.272, 12.878, 13.081);
-    path.lineTo(11.320, 9.063);
-    path.cubicTo(11.154, 8.619, 11.154, 8.573, 11.164, 8.433);
-    path.cubicTo(11.192, 8.153, 11.373, 7.918, 11.640, 7.805);
-    path.cubicTo(11.754, 7.756, 11.883, 7.729, 11.970, 7.795);
-    path.lineTo(12.094, 7.805);
-    path.lineTo(12.146, 7.826);
-    path.cubicTo(12.206, 7.852, 12.306, 7.901, 12.459, 7.980);
-    path.lineTo(16.089, 9.888);
-    path.cubicTo(17.452, 10.634, 18.574, 11.804, 19.381, 13.419);
-    path.cubicTo(19.575, 14.409, 19.540, 15.456, 19.279, 16.431);
-    path.cubicTo(19.063, 17.236, 18.640, 18.125, 18.225, 18.644);
-    path.lineTo(18.145, 18.743);
-    path.lineTo(18.098, 18.793);
-    path.cubicTo(18.088, 18.803, 18.085, 18.803, 18.088, 18.795);
-    path.lineTo(18.131, 18.721);
-    path.lineTo(18.059, 18.835);
-    path.cubicTo(18.048, 18.866, 17.826, 19.115, 17.679, 19.260);
-    path.lineTo(17.509, 19.421);
-    path.cubicTo(17.289, 19.623, 17.078, 19.781, 16.677, 20.041);
-    path.lineTo(13.544, 23.0);
-    path.cubicTo(12.603, 23.600, 11.684, 23.912, 10.631, 23.992);
-    path.cubicTo(10.401, 24.010, 9.777, 24.000, 9.557, 23.975);
-    path.cubicTo(9.035, 23.919, 8.534, 23.780, 7.899, 23.563);
-    path.cubicTo(6.045, 22.825, 4.676, 21.275, 4.194, 19.368);
-    path.cubicTo(4.126, 19.110, 4.083, 18.914, 4.073, 18.798);
-    path.lineTo(4.027, 18.473);
-    path.cubicTo(4.020, 18.395, 4.016, 18.327, 4.013, 18.305);
-    path.lineTo(4.007, 18.276);
-    path.lineTo(4.0, 11.617);
-    path.lineTo(4.010, 0.866);
-    path.cubicTo(4.011, 0.805, 4.014, 0.770, 4.017, 0.755);
-    path.cubicTo(4.062, 0.464, 4.264, 0.218, 4.535, 0.116);
-    path.cubicTo(4.647, 0.071, 4.751, 0.039, 4.842, 0.005);
-    path.closeSubpath();
-    
-    painter.drawPath(path);
-    
-    return QIcon(pixmap);
+    if (icon.isNull()) {
+        qDebug() << "未找到图标资源:" << prefix;
+    }
+    return icon;
 }
 
 void MainWindow::setupSystemTray() {
-    // 设置托盘图标 - 使用动态生成的图标，适应主题
+    // 设置托盘图标，浅色或深色由配置决定以适应面板颜色
     m_trayIcon->setIcon(createBingIcon(true));
     m_trayIcon->setToolTip("Bing壁纸设置器");
     
@@ -296,7 +447,7 @@ void MainWindow::setupSystemTray() {
     m_trayMenu = new QMenu(this);
     
     QAction *showAction = new QAction("显示主窗口", this);
-    connect(showAction, &QAction::triggered, this, &QMainWindow::showNormal);
+    connect(showAction, &QAction::triggered, this, &MainWindow::showMainWindow);
     m_trayMenu->addAction(showAction);
     
     QAction *prevAction = new QAction("上一张", this);
@@ -315,10 +466,18 @@ void MainWindow::setupSystemTray() {
     connect(viewAction, &QAction::triggered, this, &MainWindow::viewCurrentWallpaper);
     m_trayMenu->addAction(viewAction);
     
+    QAction *galleryAction = new QAction("浏览壁纸库", this);
+    connect(galleryAction, &QAction::triggered, this, &MainWindow::openLibraryGallery);
+    m_trayMenu->addAction(galleryAction);
+    
     QAction *folderAction = new QAction("打开壁纸文件夹", this);
     connect(folderAction, &QAction::triggered, this, &MainWindow::openWallpaperFolder);
     m_trayMenu->addAction(folderAction);
     
+    QAction *verifyAction = new QAction("检查壁纸完整性", this);
+    connect(verifyAction, &QAction::triggered, this, &MainWindow::verifyWallpaperLibrary);
+    m_trayMenu->addAction(verifyAction);
+    
     m_trayMenu->addSeparator();
     
     QAction *quitAction = new QAction("退出", this);
@@ -334,22 +493,72 @@ void MainWindow::setupSystemTray() {
 }
 
 void MainWindow::loadSettings() {
-    QSettings settings("BingWallpaper", "Settings");
-    m_isAutoUpdateEnabled = settings.value("autoUpdate", false).toBool();
-    m_updateIntervalHours = settings.value("updateInterval", 24).toInt();
+    SettingsStore *settings = SettingsStore::instance();
+    m_isAutoUpdateEnabled = settings->value(SettingsKeys::AutoUpdate);
+    m_updateIntervalHours = settings->value(SettingsKeys::UpdateInterval);
+    m_lowMemoryMode = settings->value(SettingsKeys::LowMemoryMode);
     
+    if (m_isAutoUpdateEnabled) {
+        startAutoUpdateTimer();
+    }
+    
+    // 其他实例或管理员修改配置文件后立即生效；自己保存的值相同，不会重复处理
+    settings->onChanged(SettingsKeys::AutoUpdate, this, [this](bool enabled) {
+        if (enabled != m_isAutoUpdateEnabled) {
+            toggleAutoUpdate(enabled);
+            updateSettingsWidgets();
+        }
+    });
+    settings->onChanged(SettingsKeys::UpdateInterval, this, [this](int hours) {
+        if (hours != m_updateIntervalHours) {
+            m_updateIntervalHours = hours;
+            if (m_isAutoUpdateEnabled) {
+                startAutoUpdateTimer();
+            }
+            updateSettingsWidgets();
+        }
+    });
+    settings->onChanged(SettingsKeys::LowMemoryMode, this, [this](bool enabled) {
+        m_lowMemoryMode = enabled;
+        updateSettingsWidgets();
+    });
+    settings->onChanged(SettingsKeys::TrayIconVariant, this, [this](const QString &) {
+        m_trayIcon->setIcon(createBingIcon(true));
+    });
+}
+
+void MainWindow::updateSettingsWidgets() {
+    if (!m_uiBuilt) {
+        return;
+    }
+    QSignalBlocker autoUpdateBlocker(m_autoUpdateCheckBox);
+    QSignalBlocker intervalBlocker(m_updateIntervalSpinBox);
+    QSignalBlocker lowMemoryBlocker(m_lowMemoryCheckBox);
     m_autoUpdateCheckBox->setChecked(m_isAutoUpdateEnabled);
     m_updateIntervalSpinBox->setValue(m_updateIntervalHours);
-    
-    if (m_isAutoUpdateEnabled) {
-        m_autoUpdateTimer->start(m_updateIntervalHours * 3600000);
+    m_lowMemoryCheckBox->setChecked(m_lowMemoryMode);
+}
+
+void MainWindow::startAutoUpdateTimer() {
+    m_autoUpdateTimer->start(m_updateIntervalHours * 3600000);
+    schedulePrewarm();
+}
+
+void MainWindow::schedulePrewarm() {
+    int remaining = m_autoUpdateTimer->remainingTime();
+    if (remaining < 0) {
+        m_prewarmTimer->stop();
+        return;
     }
+    m_prewarmTimer->start(qMax(0, remaining - PREWARM_LEAD_MS));
 }
 
 void MainWindow::saveSettings() {
-    QSettings settings("BingWallpaper", "Settings");
-    settings.setValue("autoUpdate", m_isAutoUpdateEnabled);
-    settings.setValue("updateInterval", m_updateIntervalHours);
+    // 只更新内存中的配置，写回文件由 SettingsStore 合并后在后台完成
+    SettingsStore *settings = SettingsStore::instance();
+    settings->setValue(SettingsKeys::AutoUpdate, m_isAutoUpdateEnabled);
+    settings->setValue(SettingsKeys::UpdateInterval, m_updateIntervalHours);
+    settings->setValue(SettingsKeys::LowMemoryMode, m_lowMemoryMode);
 }
 
 void MainWindow::closeEvent(QCloseEvent *event) {
@@ -366,17 +575,31 @@ void MainWindow::closeEvent(QCloseEvent *event) {
 }
 
 void MainWindow::updateWallpaper() {
-    m_updateButton->setEnabled(false);
+    if (m_updateButton) {
+        m_updateButton->setEnabled(false);
+    }
     m_wallpaperSetter->downloadAndSetWallpaper(0);
 }
 
+void MainWindow::onAutoUpdateTimeout() {
+    if (m_updateButton) {
+        m_updateButton->setEnabled(false);
+    }
+    // 自动更新在计费网络或电量不足时可以推迟
+    m_wallpaperSetter->downloadAndSetWallpaper(0, false);
+}
+
 void MainWindow::onPrevWallpaper() {
-    m_prevButton->setEnabled(false);
+    if (m_prevButton) {
+        m_prevButton->setEnabled(false);
+    }
     m_wallpaperSetter->downloadAndSetWallpaper(-1);
 }
 
 void MainWindow::onNextWallpaper() {
-    m_nextButton->setEnabled(false);
+    if (m_nextButton) {
+        m_nextButton->setEnabled(false);
+    }
     m_wallpaperSetter->downloadAndSetWallpaper(1);
 }
 
@@ -399,9 +622,14 @@ void MainWindow::viewCurrentWallpaper() {
     scrollArea->setWidgetResizable(true);
     
     QLabel *imageLabel = new QLabel();
-    QPixmap pixmap(wallpaperPath);
-    if (!pixmap.isNull()) {
-        imageLabel->setPixmap(pixmap.scaled(780, 580, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+    // 解码时直接缩小，避免为 4K 原图分配几十MB的临时位图
+    QImageReader reader(wallpaperPath);
+    if (reader.size().isValid()) {
+        reader.setScaledSize(reader.size().scaled(780, 580, Qt::KeepAspectRatio));
+    }
+    QImage image = reader.read();
+    if (!image.isNull()) {
+        imageLabel->setPixmap(QPixmap::fromImage(image));
         imageLabel->setAlignment(Qt::AlignCenter);
     } else {
         imageLabel->setText("无法加载壁纸图片");
@@ -419,6 +647,40 @@ void MainWindow::viewCurrentWallpaper() {
     delete dialog;
 }
 
+void MainWindow::openLibraryGallery() {
+    if (m_wallpaperSetter->library()->count() == 0) {
+        QMessageBox::information(this, "提示", "壁纸库为空，请先更新壁纸");
+        return;
+    }
+    
+    const QSize thumbnailSize(240, 135);
+    
+    // 缩略图缓存和模型都归对话框所有，关闭后内存随之释放
+    QDialog *dialog = new QDialog(this);
+    dialog->setWindowTitle(QString("壁纸库（%1 张）").arg(m_wallpaperSetter->library()->count()));
+    dialog->resize(900, 640);
+    
+    QVBoxLayout *layout = new QVBoxLayout(dialog);
+    
+    ThumbnailCache *cache = new ThumbnailCache(thumbnailSize, dialog);
+    WallpaperGalleryModel *model = new WallpaperGalleryModel(m_wallpaperSetter->library(), cache, dialog);
+    WallpaperGalleryView *view = new WallpaperGalleryView(thumbnailSize, dialog);
+    view->setGalleryModel(model);
+    layout->addWidget(view);
+    
+    QLabel *hintLabel = new QLabel("双击缩略图将其设置为桌面壁纸");
+    hintLabel->setStyleSheet("QLabel { color: #555; font-size: 10px; }");
+    layout->addWidget(hintLabel);
+    
+    connect(view, &QListView::activated, this, [this](const QModelIndex &index) {
+        QString path = index.data(WallpaperGalleryModel::FilePathRole).toString();
+        applyWallpaperFromFile(path);
+    });
+    
+    dialog->exec();
+    delete dialog;
+}
+
 void MainWindow::openWallpaperFolder() {
     QString folderPath = m_wallpaperSetter->getWallpaperDirectory();
     QDesktopServices::openUrl(QUrl::fromLocalFile(folderPath));
@@ -457,6 +719,10 @@ void MainWindow::resetWallpaperDirectory() {
 }
 
 void MainWindow::updateDirectoryLabel() {
+    if (!m_uiBuilt) {
+        return;
+    }
+    
     QString dir = m_wallpaperSetter->getWallpaperDirectory();
     QString displayText = "当前路径: " + dir;
     
@@ -472,6 +738,10 @@ void MainWindow::updateDirectoryLabel() {
 }
 
 void MainWindow::updateWallpaperPreview() {
+    if (!m_uiBuilt) {
+        return;
+    }
+    
     QString wallpaperPath = m_wallpaperSetter->getCurrentWallpaperPath();
     
     if (wallpaperPath.isEmpty() || !QFile::exists(wallpaperPath)) {
@@ -480,12 +750,16 @@ void MainWindow::updateWallpaperPreview() {
         return;
     }
     
-    QPixmap pixmap(wallpaperPath);
-    if (!pixmap.isNull()) {
-        // 缩放图片以适应预览区域
-        int maxHeight = 280;
-        QPixmap scaled = pixmap.scaledToHeight(maxHeight, Qt::SmoothTransformation);
-        m_wallpaperPreviewLabel->setPixmap(scaled);
+    // 缩放图片以适应预览区域，解码时直接缩小
+    int maxHeight = 280;
+    QImageReader reader(wallpaperPath);
+    QSize originalSize = reader.size();
+    if (originalSize.isValid() && originalSize.height() > maxHeight) {
+        reader.setScaledSize(QSize(originalSize.width() * maxHeight / originalSize.height(), maxHeight));
+    }
+    QImage image = reader.read();
+    if (!image.isNull()) {
+        m_wallpaperPreviewLabel->setPixmap(QPixmap::fromImage(image));
     } else {
         m_wallpaperPreviewLabel->setText("⚠️ 无法加载壁纸图片");
     }
@@ -495,10 +769,11 @@ void MainWindow::toggleAutoUpdate(bool enabled) {
     m_isAutoUpdateEnabled = enabled;
     
     if (enabled) {
-        m_autoUpdateTimer->start(m_updateIntervalHours * 3600000);
+        startAutoUpdateTimer();
         showStatusMessage("自动更新已启用，间隔: " + QString::number(m_updateIntervalHours) + " 小时");
     } else {
         m_autoUpdateTimer->stop();
+        m_prewarmTimer->stop();
         showStatusMessage("自动更新已禁用");
     }
     
@@ -506,25 +781,63 @@ void MainWindow::toggleAutoUpdate(bool enabled) {
 }
 
 void MainWindow::onDownloadStarted() {
+    m_isDownloading = true;
+    m_downloadPercentage = 0;
+    if (!m_uiBuilt) {
+        return;
+    }
     m_statusLabel->setText("正在下载壁纸...");
+    m_progressBar->setFormat("%p%");
     m_progressBar->setValue(0);
     m_progressBar->setVisible(true);
 }
 
 void MainWindow::onDownloadProgress(int percentage) {
+    m_downloadPercentage = percentage;
+    if (!m_uiBuilt) {
+        return;
+    }
     m_progressBar->setValue(percentage);
 }
 
-void MainWindow::onDownloadFinished(bool success, const QString &message, int offset) {
-    m_updateButton->setEnabled(true);
-    m_prevButton->setEnabled(true);
-    m_nextButton->setEnabled(true);
-    if (offset == 0){
-        m_nextButton->setEnabled(false);
+void MainWindow::onDownloadRateChanged(double bytesPerSecond, int etaSeconds) {
+    if (!m_uiBuilt) {
+        return;
     }
-    if (offset == 7){
-        m_prevButton->setEnabled(false);
+    QString format = QString("%p% · %1/s").arg(QLocale().formattedDataSize(qint64(bytesPerSecond)));
+    if (etaSeconds >= 0) {
+        format += QString(" · 剩余 %1 秒").arg(etaSeconds);
+    }
+    m_progressBar->setFormat(format);
+}
+
+void MainWindow::onDownloadRetrying(int attempt) {
+    if (!m_uiBuilt) {
+        return;
+    }
+    m_statusLabel->setText(QString("下载停滞，正在断点续传（第 %1 次）...").arg(attempt));
+}
+
+void MainWindow::onDownloadPreview(const QImage &preview) {
+    if (!m_uiBuilt || !m_isDownloading) {
+        return;
+    }
+    // 下载完成并设置壁纸后由 updateWallpaperPreview 换成完整图片
+    m_wallpaperPreviewLabel->setPixmap(QPixmap::fromImage(preview));
+}
+
+void MainWindow::onDownloadFinished(bool success, const QString &message, int offset) {
+    m_isDownloading = false;
+    m_lastOffset = offset;
+    
+    if (!m_uiBuilt) {
+        if (!success) {
+            m_trayIcon->showMessage("错误", message, QSystemTrayIcon::Critical, 5000);
+        }
+        return;
     }
+    
+    updateNavigationButtons();
     m_progressBar->setVisible(false);
     
     if (success) {
@@ -534,15 +847,26 @@ void MainWindow::onDownloadFinished(bool success, const QString &message, int of
     } else {
         m_statusLabel->setText("✗ " + message);
         m_statusLabel->setStyleSheet("QLabel { color: red; }");
+        // 丢掉下载到一半的预览
+        updateWallpaperPreview();
         m_trayIcon->showMessage("错误", message, QSystemTrayIcon::Critical, 5000);
     }
     
-    QTimer::singleShot(5000, [this]() {
-        m_statusLabel->setStyleSheet("");
+    QTimer::singleShot(5000, this, [this]() {
+        if (m_statusLabel) {
+            m_statusLabel->setStyleSheet("");
+        }
     });
 }
 
 void MainWindow::onWallpaperSet(const QString &path) {
+    if (path == m_pendingApplyPath) {
+        m_pendingApplyPath.clear();
+        showStatusMessage("已设置壁纸: " + QFileInfo(path).fileName());
+    }
+    if (!m_uiBuilt) {
+        return;
+    }
     m_currentWallpaperLabel->setText("当前壁纸: " + path);
     updateWallpaperPreview();
 }
@@ -552,15 +876,100 @@ void MainWindow::trayIconActivated(QSystemTrayIcon::ActivationReason reason) {
         if (isVisible()) {
             hide();
         } else {
-            showNormal();
-            activateWindow();
+            showMainWindow();
+        }
+    }
+}
+
+void MainWindow::onSearchTextChanged(const QString &text) {
+    if (!m_uiBuilt) {
+        return;
+    }
+    m_searchResultList->clear();
+    
+    if (text.trimmed().isEmpty()) {
+        m_searchResultList->setVisible(false);
+        return;
+    }
+    
+    // 索引常驻内存，每次按键同步查询即可
+    const QVector<WallpaperInfo> results = m_wallpaperSetter->library()->search(text, 50);
+    for (const WallpaperInfo &info : results) {
+        QString display = info.date + "  " + (info.title.isEmpty() ? info.location : info.title);
+        if (!info.title.isEmpty() && !info.location.isEmpty()) {
+            display += " — " + info.location;
         }
+        QListWidgetItem *item = new QListWidgetItem(display, m_searchResultList);
+        item->setData(Qt::UserRole, info.filePath);
+        item->setToolTip(info.copyright.isEmpty() ? info.filePath : info.copyright);
+    }
+    
+    if (results.isEmpty()) {
+        QListWidgetItem *item = new QListWidgetItem("没有找到匹配的壁纸", m_searchResultList);
+        item->setFlags(Qt::NoItemFlags);
+    }
+    m_searchResultList->setVisible(true);
+}
+
+void MainWindow::onSearchResultActivated(QListWidgetItem *item) {
+    QString path = item->data(Qt::UserRole).toString();
+    if (path.isEmpty()) {
+        return;
+    }
+    
+    if (!QFile::exists(path)) {
+        showStatusMessage("壁纸文件已不存在: " + path, 5000);
+        return;
+    }
+    
+    applyWallpaperFromFile(path);
+}
+
+void MainWindow::applyWallpaperFromFile(const QString &path) {
+    // 设置在后台完成，结果通过 wallpaperSet 或 wallpaperApplyFailed 返回
+    m_pendingApplyPath = path;
+    showStatusMessage("正在设置壁纸: " + QFileInfo(path).fileName());
+    m_wallpaperSetter->setWallpaperFromFile(path);
+}
+
+void MainWindow::onWallpaperApplyFailed(const QString &path) {
+    if (path != m_pendingApplyPath) {
+        return;
+    }
+    m_pendingApplyPath.clear();
+    showStatusMessage("设置壁纸失败", 5000);
+}
+
+void MainWindow::verifyWallpaperLibrary() {
+    m_libraryCheckRequested = true;
+    showStatusMessage("正在检查壁纸完整性...");
+    m_wallpaperSetter->verifyLibrary(true);
+}
+
+void MainWindow::onLibraryVerified(int checked, int corrupt) {
+    // 启动时的例行检查没有发现问题就不打扰用户
+    if (!m_libraryCheckRequested && corrupt == 0) {
+        return;
+    }
+    m_libraryCheckRequested = false;
+    
+    QString message = corrupt == 0
+        ? QString("已检查 %1 张壁纸，全部完整").arg(checked)
+        : QString("已检查 %1 张壁纸，%2 张损坏，已隔离并安排重新下载").arg(checked).arg(corrupt);
+    showStatusMessage(message, 5000);
+    if (!isVisible()) {
+        m_trayIcon->showMessage("Bing壁纸设置器", message, QSystemTrayIcon::Information, 5000);
     }
 }
 
 void MainWindow::showStatusMessage(const QString &message, int timeout) {
+    if (!m_uiBuilt) {
+        return;
+    }
     m_statusLabel->setText(message);
-    QTimer::singleShot(timeout, [this]() {
-        m_statusLabel->setText("准备就绪");
+    QTimer::singleShot(timeout, this, [this]() {
+        if (m_statusLabel) {
+            m_statusLabel->setText("准备就绪");
+        }
     });
 }
@@ -10,6 +10,8 @@
 #include <QCheckBox>
 #include <QSpinBox>
 #include <QProgressBar>
+#include <QLineEdit>
+#include <QListWidget>
 #include "BingWallpaperSetter.h"
 
 class MainWindow : public QMainWindow {
@@ -21,36 +23,58 @@ public:
 
 protected:
     void closeEvent(QCloseEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
 
 private slots:
+    void showMainWindow();
+    void releaseUi();
+    void onAutoUpdateTimeout();
     void onPrevWallpaper();
     void onNextWallpaper();
     void updateWallpaper();
     void viewCurrentWallpaper();
+    void openLibraryGallery();
     void openWallpaperFolder();
+    void verifyWallpaperLibrary();
     void changeWallpaperDirectory();
     void resetWallpaperDirectory();
     void toggleAutoUpdate(bool enabled);
     void onDownloadStarted();
     void onDownloadProgress(int percentage);
+    void onDownloadPreview(const QImage &preview);
+    void onDownloadRateChanged(double bytesPerSecond, int etaSeconds);
+    void onDownloadRetrying(int attempt);
     void onDownloadFinished(bool success, const QString &message, int offset);
     void onWallpaperSet(const QString &path);
+    void onWallpaperApplyFailed(const QString &path);
+    void onLibraryVerified(int checked, int corrupt);
     void trayIconActivated(QSystemTrayIcon::ActivationReason reason);
+    void onSearchTextChanged(const QString &text);
+    void onSearchResultActivated(QListWidgetItem *item);
 
 private:
     void setupUI();
+    void ensureUi();
+    void applyStateToUi();
+    void updateSettingsWidgets();
+    void updateNavigationButtons();
     void setupSystemTray();
     void loadSettings();
     void saveSettings();
     void showStatusMessage(const QString &message, int timeout = 3000);
+    void applyWallpaperFromFile(const QString &path);
     void updateDirectoryLabel();
     void updateWallpaperPreview();
+    void startAutoUpdateTimer();
+    void schedulePrewarm();
     QIcon createBingIcon(bool forTray = false);
 
     BingWallpaperSetter *m_wallpaperSetter;
     QSystemTrayIcon *m_trayIcon;
     QMenu *m_trayMenu;
     QTimer *m_autoUpdateTimer;
+    QTimer *m_prewarmTimer;
     
     // UI组件
     QLabel *m_statusLabel;
@@ -61,14 +85,31 @@ private:
     QPushButton *m_nextButton;
     QPushButton *m_updateButton;
     QPushButton *m_openFolderButton;
+    QPushButton *m_galleryButton;
     QPushButton *m_changeDirectoryButton;
     QPushButton *m_resetDirectoryButton;
     QCheckBox *m_autoUpdateCheckBox;
+    QCheckBox *m_lowMemoryCheckBox;
     QSpinBox *m_updateIntervalSpinBox;
     QProgressBar *m_progressBar;
+    QLineEdit *m_searchEdit;
+    QListWidget *m_searchResultList;
+    
+    QTimer *m_releaseUiTimer;
     
     bool m_isAutoUpdateEnabled;
     int m_updateIntervalHours;
+    
+    // 低内存模式：窗口隐藏后销毁界面，再次显示时根据以下状态重建
+    bool m_lowMemoryMode;
+    bool m_uiBuilt;
+    bool m_isDownloading;
+    int m_downloadPercentage;
+    int m_lastOffset;
+    // 从壁纸库或搜索结果中选中、正在后台设置的壁纸
+    QString m_pendingApplyPath;
+    // 用户手动发起的完整性检查，完成时需要提示结果
+    bool m_libraryCheckRequested;
 };
 
 #endif // MAINWINDOW_H
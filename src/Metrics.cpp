@@ -0,0 +1,172 @@
+#include "Metrics.h"
+#include <QStandardPaths>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QSet>
+#include <QDebug>
+#include <QCoreApplication>
+
+Metrics *Metrics::instance() {
+    static Metrics *metrics = new Metrics();
+    return metrics;
+}
+
+Metrics::Metrics(QObject *parent)
+    : QObject(parent)
+{
+    // 指标变化很频繁，合并成每5秒最多写一次文件
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(5000);
+    connect(&m_flushTimer, &QTimer::timeout, this, &Metrics::flush);
+
+    // 退出前写入还在合并窗口内的指标
+    if (QCoreApplication::instance()) {
+        connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, [this]() {
+            if (m_flushTimer.isActive()) {
+                m_flushTimer.stop();
+                flush();
+            }
+        });
+    }
+}
+
+void Metrics::scheduleFlush() {
+    if (!m_flushTimer.isActive()) {
+        m_flushTimer.start();
+    }
+}
+
+void Metrics::setGauge(const QString &name, double value) {
+    m_gauges[name] = value;
+    scheduleFlush();
+}
+
+void Metrics::incrementCounter(const QString &name, double delta) {
+    m_counters[name] += delta;
+    scheduleFlush();
+}
+
+void Metrics::observe(const QString &name, double value, const QVector<double> &buckets) {
+    Histogram &histogram = m_histograms[name];
+    if (histogram.buckets.isEmpty()) {
+        histogram.buckets = buckets;
+        histogram.counts.fill(0, buckets.size());
+    }
+
+    for (int i = 0; i < histogram.buckets.size(); ++i) {
+        if (value <= histogram.buckets[i]) {
+            ++histogram.counts[i];
+        }
+    }
+    histogram.sum += value;
+    ++histogram.count;
+    scheduleFlush();
+}
+
+void Metrics::sampleProcessMemory() {
+    // smaps_rollup 自 Linux 4.14 起可用，旧内核退回到 status 中的 VmRSS
+    QFile rollup("/proc/self/smaps_rollup");
+    qint64 rssKb = -1;
+    qint64 pssKb = -1;
+
+    if (rollup.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        const QList<QByteArray> lines = rollup.readAll().split('\n');
+        for (const QByteArray &line : lines) {
+            if (line.startsWith("Rss:")) {
+                rssKb = line.mid(4).trimmed().split(' ').value(0).toLongLong();
+            } else if (line.startsWith("Pss:")) {
+                pssKb = line.mid(4).trimmed().split(' ').value(0).toLongLong();
+            }
+        }
+    } else {
+        QFile status("/proc/self/status");
+        if (status.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            const QList<QByteArray> lines = status.readAll().split('\n');
+            for (const QByteArray &line : lines) {
+                if (line.startsWith("VmRSS:")) {
+                    rssKb = line.mid(6).trimmed().split(' ').value(0).toLongLong();
+                }
+            }
+        }
+    }
+
+    if (rssKb >= 0) {
+        setGauge("bing_wallpaper_process_rss_bytes", rssKb * 1024.0);
+    }
+    if (pssKb >= 0) {
+        setGauge("bing_wallpaper_process_pss_bytes", pssKb * 1024.0);
+    }
+}
+
+static QString baseName(const QString &name) {
+    int brace = name.indexOf('{');
+    return brace < 0 ? name : name.left(brace);
+}
+
+static QString withLabel(const QString &name, const QString &suffix, const QString &label) {
+    // name{a="b"} + _bucket + le="1" => name_bucket{a="b",le="1"}
+    int brace = name.indexOf('{');
+    QString base = brace < 0 ? name : name.left(brace);
+    QString labels = brace < 0 ? QString() : name.mid(brace + 1, name.size() - brace - 2);
+    if (!label.isEmpty()) {
+        labels = labels.isEmpty() ? label : labels + "," + label;
+    }
+    return base + suffix + (labels.isEmpty() ? QString() : "{" + labels + "}");
+}
+
+QString Metrics::exportText() const {
+    QString text;
+    QTextStream out(&text);
+    QSet<QString> typed;
+
+    for (auto it = m_gauges.constBegin(); it != m_gauges.constEnd(); ++it) {
+        if (!typed.contains(baseName(it.key()))) {
+            typed.insert(baseName(it.key()));
+            out << "# TYPE " << baseName(it.key()) << " gauge\n";
+        }
+        out << it.key() << ' ' << QString::number(it.value(), 'g', 12) << '\n';
+    }
+
+    for (auto it = m_counters.constBegin(); it != m_counters.constEnd(); ++it) {
+        if (!typed.contains(baseName(it.key()))) {
+            typed.insert(baseName(it.key()));
+            out << "# TYPE " << baseName(it.key()) << " counter\n";
+        }
+        out << it.key() << ' ' << QString::number(it.value(), 'g', 12) << '\n';
+    }
+
+    for (auto it = m_histograms.constBegin(); it != m_histograms.constEnd(); ++it) {
+        const Histogram &histogram = it.value();
+        if (!typed.contains(baseName(it.key()))) {
+            typed.insert(baseName(it.key()));
+            out << "# TYPE " << baseName(it.key()) << " histogram\n";
+        }
+        for (int i = 0; i < histogram.buckets.size(); ++i) {
+            out << withLabel(it.key(), "_bucket", QString("le=\"%1\"").arg(histogram.buckets[i]))
+                << ' ' << histogram.counts[i] << '\n';
+        }
+        out << withLabel(it.key(), "_bucket", "le=\"+Inf\"") << ' ' << histogram.count << '\n';
+        out << withLabel(it.key(), "_sum", QString()) << ' ' << QString::number(histogram.sum, 'g', 12) << '\n';
+        out << withLabel(it.key(), "_count", QString()) << ' ' << histogram.count << '\n';
+    }
+
+    return text;
+}
+
+QString Metrics::exportFilePath() const {
+    QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dataDir);
+    return dataDir + "/metrics.prom";
+}
+
+void Metrics::flush() {
+    QSaveFile file(exportFilePath());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qDebug() << "写入指标文件失败:" << file.fileName();
+        return;
+    }
+    file.write(exportText().toUtf8());
+    file.commit();
+}
@@ -0,0 +1,65 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QObject>
+#include <QMap>
+#include <QVector>
+#include <QString>
+#include <QTimer>
+
+/**
+ * @brief 进程内指标汇总
+ *
+ * 以 Prometheus 文本格式定期写入应用数据目录下的 metrics.prom，
+ * 可以直接交给 node_exporter 的 textfile 收集器，也方便在终端里 cat 查看。
+ * 指标名可以带标签，例如 bing_wallpaper_ttfb_ms{host="cn.bing.com"}。
+ */
+class Metrics : public QObject {
+    Q_OBJECT
+
+public:
+    static Metrics *instance();
+
+    void setGauge(const QString &name, double value);
+    void incrementCounter(const QString &name, double delta = 1.0);
+
+    /**
+     * @brief 记录一次直方图观测值
+     * @param name 指标名
+     * @param value 观测值
+     * @param buckets 桶上界，仅在第一次记录该指标时生效
+     */
+    void observe(const QString &name, double value, const QVector<double> &buckets);
+
+    /**
+     * @brief 读取 /proc/self/smaps_rollup 中的 RSS 和 PSS 并更新对应的 gauge
+     *
+     * 只在内存占用可能变化的时刻（启动、隐藏窗口、释放界面）调用，不定时采样，
+     * 空闲时不会因为采样而反复写指标文件。
+     */
+    void sampleProcessMemory();
+
+    QString exportText() const;
+    QString exportFilePath() const;
+
+public slots:
+    void flush();
+
+private:
+    explicit Metrics(QObject *parent = nullptr);
+    void scheduleFlush();
+
+    struct Histogram {
+        QVector<double> buckets;
+        QVector<quint64> counts;
+        double sum = 0.0;
+        quint64 count = 0;
+    };
+
+    QMap<QString, double> m_gauges;
+    QMap<QString, double> m_counters;
+    QMap<QString, Histogram> m_histograms;
+    QTimer m_flushTimer;
+};
+
+#endif // METRICS_H
@@ -0,0 +1,169 @@
+#include "Prefetcher.h"
+#include "Awaitables.h"
+#include "Metrics.h"
+#include "SettingsStore.h"
+#include <QDateTime>
+#include <QRandomGenerator>
+#include <QPointer>
+#include <QDebug>
+#include <climits>
+#ifdef Q_OS_LINUX
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const int IDLE_DELAY_MS = 60 * 1000;
+// Bing 在零点后陆续发布，稍等并随机错开，避免所有客户端同时请求
+const int PUBLISH_GRACE_SECS = 5 * 60;
+const int PUBLISH_JITTER_SECS = 10 * 60;
+const int PUBLISH_RETRY_MS = 30 * 60 * 1000;
+// 每个周期从读缓冲区取走一份数据，缓冲区满时 TCP 窗口关闭，服务器随之放慢
+const int PUMP_INTERVAL_MS = 100;
+
+#ifdef Q_OS_LINUX
+const int IOPRIO_WHO_PROCESS = 1;       // who 为 0 时指当前线程
+const int IOPRIO_CLASS_SHIFT = 13;
+const int IOPRIO_CLASS_IDLE = 3;
+#endif
+
+}
+
+Prefetcher::IdleIoPriority::IdleIoPriority()
+    : m_previous(-1)
+{
+#ifdef Q_OS_LINUX
+    m_previous = syscall(SYS_ioprio_get, IOPRIO_WHO_PROCESS, 0);
+    if (m_previous >= 0) {
+        syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT);
+    }
+#endif
+}
+
+Prefetcher::IdleIoPriority::~IdleIoPriority() {
+#ifdef Q_OS_LINUX
+    // 线程池中的线程会被复用，恢复原来的优先级
+    if (m_previous >= 0) {
+        syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, m_previous);
+    }
+#endif
+}
+
+Prefetcher::Prefetcher(QObject *parent)
+    : QObject(parent)
+    , m_pass(Adjacent)
+    , m_running(false)
+{
+    m_idleTimer.setSingleShot(true);
+    m_idleTimer.setInterval(IDLE_DELAY_MS);
+    connect(&m_idleTimer, &QTimer::timeout, this, &Prefetcher::idleReached);
+
+    m_publishTimer.setSingleShot(true);
+    m_publishTimer.setTimerType(Qt::VeryCoarseTimer);
+    connect(&m_publishTimer, &QTimer::timeout, this, &Prefetcher::publishDue);
+    schedulePublish();
+    // 启动后同样在空闲一分钟后预取，第一次点击前一天时多半已经下载好
+    userRequestsFinished();
+
+    // 关闭后取消正在进行的预取；重新打开时等下一次空闲
+    SettingsStore::instance()->onChanged(SettingsKeys::PrefetchRateLimit, this, [this](int rate) {
+        if (rate <= 0) {
+            userRequestStarted();
+        }
+    });
+}
+
+bool Prefetcher::isEnabled() const {
+    return bytesPerSecond() > 0;
+}
+
+qint64 Prefetcher::bytesPerSecond() const {
+    return qint64(SettingsStore::instance()->value(SettingsKeys::PrefetchRateLimit)) * 1024;
+}
+
+void Prefetcher::schedulePublish() {
+    QDateTime now = QDateTime::currentDateTime();
+    QDateTime next(now.date().addDays(1), QTime(0, 0));
+    next = next.addSecs(PUBLISH_GRACE_SECS + QRandomGenerator::global()->bounded(PUBLISH_JITTER_SECS));
+    m_publishTimer.start(int(qMin<qint64>(now.msecsTo(next), INT_MAX)));
+}
+
+void Prefetcher::userRequestStarted() {
+    m_idleTimer.stop();
+    if (!m_running) {
+        return;
+    }
+    m_running = false;
+    m_passToken.cancel();
+    qDebug() << "用户请求开始，暂停预取";
+    Metrics::instance()->incrementCounter("bing_wallpaper_prefetch_yields_total");
+    if (m_pass == Published) {
+        m_publishTimer.start(PUBLISH_RETRY_MS);
+    }
+}
+
+void Prefetcher::userRequestsFinished() {
+    if (isEnabled()) {
+        m_idleTimer.start();
+    }
+}
+
+Async::CancellationToken Prefetcher::beginPass(Pass pass) {
+    m_passToken = Async::CancellationToken();
+    m_pass = pass;
+    m_running = true;
+    return m_passToken;
+}
+
+void Prefetcher::endPass(bool published) {
+    if (!m_running) {
+        return;
+    }
+    m_running = false;
+    if (m_pass == Published) {
+        if (published) {
+            schedulePublish();
+        } else {
+            m_publishTimer.start(PUBLISH_RETRY_MS);
+        }
+    }
+}
+
+Async::Task<QByteArray> Prefetcher::download(QNetworkAccessManager *manager, QNetworkRequest request,
+                                             Async::CancellationToken token, QString &error) {
+    // 单独走 HTTP/1.1 连接：限速靠停止读取形成的 TCP 背压，
+    // 在共用的 HTTP/2 连接上会占住连接级流量窗口，拖慢同时进行的用户请求
+    request.setPriority(QNetworkRequest::LowPriority);
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, false);
+    qint64 bytesPerTick = qMax<qint64>(1, bytesPerSecond() * PUMP_INTERVAL_MS / 1000);
+
+    QNetworkReply *reply = manager->get(request);
+    // 对象销毁导致的取消时 reply 已随网络管理器删除
+    QPointer<QNetworkReply> guard(reply);
+    reply->setReadBufferSize(bytesPerTick);
+    QByteArray data;
+    QTimer pump;
+    pump.setInterval(PUMP_INTERVAL_MS);
+    connect(&pump, &QTimer::timeout, reply, [reply, &data, bytesPerTick]() {
+        data.append(reply->read(bytesPerTick));
+    });
+    pump.start();
+
+    co_await Async::awaitReply(reply, token);
+    if (token.isCancelled()) {
+        if (guard) {
+            guard->deleteLater();
+        }
+        co_return QByteArray();
+    }
+    pump.stop();
+    reply->deleteLater();
+    if (reply->error() != QNetworkReply::NoError) {
+        error = "预取失败: " + reply->errorString();
+        co_return QByteArray();
+    }
+    data.append(reply->readAll());
+    Metrics::instance()->incrementCounter("bing_wallpaper_prefetch_bytes_total", data.size());
+    co_return data;
+}
@@ -0,0 +1,87 @@
+#ifndef PREFETCHER_H
+#define PREFETCHER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QByteArray>
+#include <QNetworkAccessManager>
+#include <QNetworkRequest>
+#include "Task.h"
+
+/**
+ * @brief 空闲时预先下载用户接下来可能要看的壁纸
+ *
+ * 启动或最后一次请求结束一分钟后发出 idleReached，由 BingWallpaperSetter 预取今天以及当前壁纸
+ * 前后一天的图片；每天零点后（加上随机延迟）发出 publishDue 预取新发布的壁纸。
+ * 预取以低优先级、限速（prefetchRateLimit，KiB/s，0 表示关闭）下载，
+ * 用户发起请求时立即取消，之后重新计时。
+ */
+class Prefetcher : public QObject {
+    Q_OBJECT
+
+public:
+    enum Pass {
+        Adjacent,       // 今天和当前壁纸前后一天
+        Published       // 只取今天新发布的壁纸
+    };
+
+    /**
+     * @brief 在作用域内把当前线程的 I/O 调度类降为 idle（仅 Linux）
+     */
+    class IdleIoPriority {
+    public:
+        IdleIoPriority();
+        ~IdleIoPriority();
+        IdleIoPriority(const IdleIoPriority &) = delete;
+        IdleIoPriority &operator=(const IdleIoPriority &) = delete;
+
+    private:
+        long m_previous;
+    };
+
+    explicit Prefetcher(QObject *parent = nullptr);
+
+    bool isEnabled() const;
+
+    /**
+     * @brief 用户请求开始，取消正在进行的预取并停止计时
+     */
+    void userRequestStarted();
+
+    /**
+     * @brief 所有请求都已结束，重新开始空闲计时
+     */
+    void userRequestsFinished();
+
+    /**
+     * @brief 开始一轮预取，返回的令牌在用户请求开始时被取消
+     */
+    Async::CancellationToken beginPass(Pass pass);
+
+    /**
+     * @param published 今天的壁纸是否已经取到；Published 轮未取到时稍后重试
+     */
+    void endPass(bool published);
+
+    /**
+     * @brief 以低优先级、限速下载，取消或失败时返回空数据
+     */
+    Async::Task<QByteArray> download(QNetworkAccessManager *manager, QNetworkRequest request,
+                                     Async::CancellationToken token, QString &error);
+
+signals:
+    void idleReached();
+    void publishDue();
+
+private:
+    void schedulePublish();
+    qint64 bytesPerSecond() const;
+
+    QTimer m_idleTimer;
+    QTimer m_publishTimer;
+    Async::CancellationToken m_passToken;
+    Pass m_pass;
+    bool m_running;
+};
+
+#endif // PREFETCHER_H
@@ -0,0 +1,129 @@
+#include "ProgressivePreview.h"
+#include "Metrics.h"
+#include <QBuffer>
+#include <QImageReader>
+#include <QThreadPool>
+#include <QPointer>
+#include <QMetaObject>
+#include <QCoreApplication>
+#include <QDebug>
+
+namespace {
+
+const int PREVIEW_INTERVAL_MS = 250;        // 每秒最多刷新 4 次
+const int MIN_PREVIEW_BYTES = 32 * 1024;    // 数据太少时只有文件头，解码没有意义
+
+}
+
+ProgressivePreview::ProgressivePreview(const QSize &previewSize, QObject *parent)
+    : QObject(parent)
+    , m_previewSize(previewSize)
+    , m_enabled(false)
+    , m_decoding(false)
+    , m_firstPreviewShown(false)
+    , m_generation(0)
+    , m_decodedBytes(0)
+{
+    m_throttleTimer.setSingleShot(true);
+    m_throttleTimer.setInterval(PREVIEW_INTERVAL_MS);
+    connect(&m_throttleTimer, &QTimer::timeout, this, &ProgressivePreview::decodeSnapshot);
+}
+
+void ProgressivePreview::setEnabled(bool enabled) {
+    m_enabled = enabled;
+    if (!enabled) {
+        m_throttleTimer.stop();
+    }
+}
+
+bool ProgressivePreview::isEnabled() const {
+    return m_enabled;
+}
+
+void ProgressivePreview::reset() {
+    // 旧任务的结果通过代数判断丢弃
+    ++m_generation;
+    m_data.clear();
+    m_throttleTimer.stop();
+    m_decoding = false;
+    m_firstPreviewShown = false;
+    m_decodedBytes = 0;
+    m_downloadTimer.start();
+}
+
+void ProgressivePreview::append(const QByteArray &chunk) {
+    m_data.append(chunk);
+    if (m_enabled && !m_decoding && !m_throttleTimer.isActive() && m_data.size() >= MIN_PREVIEW_BYTES) {
+        m_throttleTimer.start();
+    }
+}
+
+qint64 ProgressivePreview::bufferedBytes() const {
+    return m_data.size();
+}
+
+QByteArray ProgressivePreview::takeData() {
+    ++m_generation;
+    m_throttleTimer.stop();
+    m_decoding = false;
+    QByteArray data;
+    data.swap(m_data);
+    return data;
+}
+
+void ProgressivePreview::decodeSnapshot() {
+    if (!m_enabled || m_decoding || m_data.size() <= m_decodedBytes) {
+        return;
+    }
+
+    // 快照与缓冲区共享数据，下一次 append 时才会复制一次
+    QByteArray snapshot = m_data;
+    m_decodedBytes = snapshot.size();
+    m_decoding = true;
+
+    int generation = m_generation;
+    QSize previewSize = m_previewSize;
+    QPointer<ProgressivePreview> guard(this);
+
+    QThreadPool::globalInstance()->start([guard, generation, snapshot, previewSize]() {
+        QBuffer buffer;
+        buffer.setData(snapshot);
+        buffer.open(QIODevice::ReadOnly);
+
+        QImageReader reader(&buffer, "jpg");
+        QImage image;
+        QSize size = reader.size();
+        // 文件头还没收全时读不到尺寸
+        if (size.isValid()) {
+            reader.setScaledSize(size.scaled(previewSize, Qt::KeepAspectRatio));
+            image = reader.read();
+        }
+
+        QMetaObject::invokeMethod(qApp, [guard, generation, image]() {
+            if (guard) {
+                guard->onDecoded(generation, image);
+            }
+        }, Qt::QueuedConnection);
+    });
+}
+
+void ProgressivePreview::onDecoded(int generation, const QImage &image) {
+    if (generation != m_generation) {
+        return;
+    }
+    m_decoding = false;
+
+    if (!image.isNull()) {
+        if (!m_firstPreviewShown) {
+            m_firstPreviewShown = true;
+            Metrics::instance()->observe("bing_wallpaper_first_preview_ms", m_downloadTimer.elapsed(),
+                                         {100, 250, 500, 1000, 2000, 5000, 10000});
+        }
+        emit previewAvailable(image);
+    }
+
+    // 解码期间又收到了新数据
+    if (m_enabled && m_data.size() > m_decodedBytes) {
+        m_throttleTimer.start();
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef PROGRESSIVEPREVIEW_H
+#define PROGRESSIVEPREVIEW_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QImage>
+#include <QSize>
+#include <QTimer>
+#include <QElapsedTimer>
+
+/**
+ * @brief 下载过程中对不完整的 JPEG 数据做增量预览
+ *
+ * 收到的数据累积在内部缓冲区里，每隔一段时间取一份快照交给工作线程，
+ * 用 QImageReader 按预览尺寸解码。libjpeg 遇到数据提前结束时会补上结束标记，
+ * 基线 JPEG 得到上半部分逐渐补全的图像，渐进式 JPEG 得到逐渐清晰的整幅图像。
+ * 同一时刻最多只有一个解码任务，解码跟不上时中间的快照直接跳过。
+ */
+class ProgressivePreview : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ProgressivePreview(const QSize &previewSize, QObject *parent = nullptr);
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    /**
+     * @brief 开始新的下载，丢弃之前的数据和尚未返回的解码结果
+     */
+    void reset();
+    void append(const QByteArray &chunk);
+    qint64 bufferedBytes() const;
+
+    /**
+     * @brief 取出已累积的完整数据并停止预览
+     */
+    QByteArray takeData();
+
+signals:
+    void previewAvailable(const QImage &image);
+
+private:
+    void decodeSnapshot();
+    void onDecoded(int generation, const QImage &image);
+
+    QSize m_previewSize;
+    QByteArray m_data;
+    QTimer m_throttleTimer;
+    QElapsedTimer m_downloadTimer;
+    bool m_enabled;
+    bool m_decoding;
+    bool m_firstPreviewShown;
+    int m_generation;
+    int m_decodedBytes;
+};
+
+#endif // PROGRESSIVEPREVIEW_H
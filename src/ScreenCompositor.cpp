@@ -0,0 +1,129 @@
+#include "ScreenCompositor.h"
+#include "VariantImage.h"
+#include <QImageReader>
+#include <QPainter>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QCryptographicHash>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <atomic>
+#include <vector>
+
+namespace {
+
+const char *COMPOSITE_PREFIX = "spanned_";
+const int COMPOSITE_QUALITY = 92;
+
+}
+
+QString ScreenCompositor::compositePath(const QList<Tile> &tiles, const QString &variantDir) {
+    // 布局或任一图片变化（包括被重新下载）时文件名随之变化
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    for (const Tile &tile : tiles) {
+        QFileInfo info(tile.imagePath);
+        hash.addData(QString("%1|%2,%3,%4,%5|%6|%7|%8\n")
+                     .arg(tile.screenName)
+                     .arg(tile.geometry.x()).arg(tile.geometry.y())
+                     .arg(tile.geometry.width()).arg(tile.geometry.height())
+                     .arg(tile.imagePath)
+                     .arg(info.size())
+                     .arg(info.lastModified().toMSecsSinceEpoch())
+                     .toUtf8());
+    }
+    return variantDir + "/" + COMPOSITE_PREFIX + hash.result().toHex().left(16) + ".jpg";
+}
+
+QImage ScreenCompositor::renderTile(const QString &imagePath, const QSize &size) {
+    QImageReader reader(imagePath);
+    QSize source = reader.size();
+    if (source.isValid() && size.isValid()) {
+        // 取源图中与显示器比例相同的最大居中区域，JPEG 解码器只解出这一部分并按 DCT 缩放
+        QSize crop = size.scaled(source, Qt::KeepAspectRatio);
+        reader.setClipRect(QRect(QPoint((source.width() - crop.width()) / 2,
+                                        (source.height() - crop.height()) / 2), crop));
+        reader.setScaledSize(size);
+    }
+    QImage image = reader.read();
+    if (image.isNull()) {
+        qDebug() << "无法解码壁纸:" << imagePath << reader.errorString();
+    }
+    return image;
+}
+
+QString ScreenCompositor::compose(const QList<Tile> &tiles, const QString &variantDir) {
+    if (tiles.isEmpty()) {
+        return QString();
+    }
+    QString path = compositePath(tiles, variantDir);
+    if (QFile::exists(path)) {
+        return path;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // 各线程从同一个计数器领取显示器；函数返回前等待所有辅助任务结束，可以按引用捕获
+    std::vector<QImage> rendered(tiles.size());
+    std::atomic<int> next{0};
+    QSemaphore finished;
+    auto work = [&tiles, &rendered, &next]() {
+        for (int i = next.fetch_add(1); i < int(tiles.size()); i = next.fetch_add(1)) {
+            rendered[i] = renderTile(tiles.at(i).imagePath, tiles.at(i).geometry.size());
+        }
+    };
+
+    QThreadPool *pool = QThreadPool::globalInstance();
+    int helpers = qBound(0, pool->maxThreadCount() - 1, int(tiles.size()) - 1);
+    for (int i = 0; i < helpers; ++i) {
+        pool->start([&work, &finished]() {
+            work();
+            finished.release();
+        });
+    }
+    work();
+
+    // 当前线程也属于线程池，等待期间让出名额，避免辅助任务排不上队
+    pool->releaseThread();
+    finished.acquire(helpers);
+    pool->reserveThread();
+
+    QRect bounds;
+    for (const Tile &tile : tiles) {
+        bounds = bounds.united(tile.geometry);
+    }
+
+    // 显示器之间的空隙（布局不规则时）保持黑色
+    QImage canvas(bounds.size(), QImage::Format_RGB32);
+    canvas.fill(Qt::black);
+    QPainter painter(&canvas);
+    for (int i = 0; i < tiles.size(); ++i) {
+        if (rendered[i].isNull()) {
+            return QString();
+        }
+        painter.drawImage(tiles.at(i).geometry.topLeft() - bounds.topLeft(), rendered[i]);
+    }
+    painter.end();
+
+    if (!VariantImage::save(canvas, path, COMPOSITE_QUALITY)) {
+        qDebug() << "保存跨屏壁纸失败:" << path;
+        return QString();
+    }
+
+    // 旧的合成图不会再用到，只保留当前这一张
+    QDir dir(variantDir);
+    const QStringList stale = dir.entryList({QString(COMPOSITE_PREFIX) + "*.jpg"}, QDir::Files);
+    const QString current = QFileInfo(path).fileName();
+    for (const QString &name : stale) {
+        if (name != current) {
+            dir.remove(name);
+        }
+    }
+
+    qDebug() << "跨屏壁纸已合成:" << path << bounds.size() << tiles.size() << "块屏幕," << timer.elapsed() << "ms";
+    return path;
+}
@@ -0,0 +1,39 @@
+#ifndef SCREENCOMPOSITOR_H
+#define SCREENCOMPOSITOR_H
+
+#include <QString>
+#include <QRect>
+#include <QList>
+#include <QImage>
+
+/**
+ * @brief 把每个显示器各自的壁纸拼成一张跨屏（spanned）壁纸
+ *
+ * GNOME 和 UKUI 只能为所有显示器设置一张图片，按 spanned 方式铺满整个桌面布局。
+ * 每块图片在解码时直接裁剪并缩放到对应显示器的尺寸，各显示器在线程池中并行处理，
+ * 三块屏幕的耗时与一块相近。相同的布局和图片只合成一次。耗时操作，应在工作线程中调用。
+ */
+class ScreenCompositor {
+public:
+    struct Tile {
+        QString screenName;
+        QRect geometry;         // 在整个桌面布局中的位置，物理像素
+        QString imagePath;
+    };
+
+    /**
+     * @brief 合成（或复用）跨屏壁纸
+     * @param variantDir 存放衍生图片的目录，之前合成的其他跨屏壁纸会被删除
+     * @return 合成图片路径，失败时返回空字符串
+     */
+    static QString compose(const QList<Tile> &tiles, const QString &variantDir);
+
+    static QString compositePath(const QList<Tile> &tiles, const QString &variantDir);
+
+    /**
+     * @brief 按 zoom 方式（保持比例、居中裁剪）解码出指定尺寸的图片
+     */
+    static QImage renderTile(const QString &imagePath, const QSize &size);
+};
+
+#endif // SCREENCOMPOSITOR_H
@@ -0,0 +1,223 @@
+#include "SearchIndex.h"
+#include <algorithm>
+#include <iterator>
+#include <vector>
+#include <utility>
+
+void SearchIndex::clear() {
+    m_postings.clear();
+    m_documentTerms.clear();
+    m_sortedTerms.clear();
+    m_sortedTermsDirty = true;
+    m_maxDocId = -1;
+}
+
+bool SearchIndex::isCjk(QChar ch) {
+    const ushort u = ch.unicode();
+    return (u >= 0x4E00 && u <= 0x9FFF)     // 中日韩统一表意文字
+        || (u >= 0x3400 && u <= 0x4DBF)     // 扩展A
+        || (u >= 0xF900 && u <= 0xFAFF)     // 兼容表意文字
+        || (u >= 0x3040 && u <= 0x30FF)     // 平假名、片假名
+        || (u >= 0xAC00 && u <= 0xD7AF);    // 韩文音节
+}
+
+QVector<SearchIndex::Token> SearchIndex::tokenize(const QString &text) {
+    // NFKC 把全角字母数字折叠为半角，再统一大小写
+    const QString normalized = text.normalized(QString::NormalizationForm_KC).toCaseFolded();
+
+    QVector<Token> tokens;
+    QString current;
+    bool currentIsCjk = false;
+
+    auto flush = [&]() {
+        if (!current.isEmpty()) {
+            tokens.append({current, currentIsCjk});
+            current.clear();
+        }
+    };
+
+    for (const QChar ch : normalized) {
+        if (isCjk(ch)) {
+            if (!currentIsCjk) {
+                flush();
+                currentIsCjk = true;
+            }
+            current.append(ch);
+        } else if (ch.isLetterOrNumber()) {
+            if (currentIsCjk) {
+                flush();
+                currentIsCjk = false;
+            }
+            current.append(ch);
+        } else {
+            flush();
+        }
+    }
+    flush();
+
+    return tokens;
+}
+
+QStringList SearchIndex::termsOf(const QString &text) {
+    QStringList terms;
+    for (const Token &token : tokenize(text)) {
+        if (!token.isCjk) {
+            terms.append(token.text);
+            continue;
+        }
+        for (int i = 0; i < token.text.size(); ++i) {
+            terms.append(token.text.mid(i, 1));
+            if (i + 1 < token.text.size()) {
+                terms.append(token.text.mid(i, 2));
+            }
+        }
+    }
+    // 同一文档中重复出现的词只记录一次
+    terms.removeDuplicates();
+    return terms;
+}
+
+void SearchIndex::addDocument(int docId, const QString &text) {
+    if (m_documentTerms.contains(docId)) {
+        removeDocument(docId);
+    }
+
+    const QStringList terms = termsOf(text);
+    for (const QString &term : terms) {
+        auto it = m_postings.find(term);
+        if (it == m_postings.end()) {
+            it = m_postings.insert(term, QVector<int>());
+            if (!isCjk(term.at(0))) {
+                if (m_sortedTermsDirty) {
+                    m_sortedTerms.append(term);
+                } else {
+                    m_sortedTerms.insert(std::lower_bound(m_sortedTerms.begin(), m_sortedTerms.end(), term), term);
+                }
+            }
+        }
+        // 新文档的编号通常最大，直接追加
+        if (it->isEmpty() || it->last() < docId) {
+            it->append(docId);
+        } else {
+            it->insert(std::lower_bound(it->begin(), it->end(), docId), docId);
+        }
+    }
+
+    m_documentTerms.insert(docId, terms);
+    m_maxDocId = qMax(m_maxDocId, docId);
+}
+
+void SearchIndex::removeDocument(int docId) {
+    auto doc = m_documentTerms.find(docId);
+    if (doc == m_documentTerms.end()) {
+        return;
+    }
+
+    for (const QString &term : std::as_const(doc.value())) {
+        auto it = m_postings.find(term);
+        if (it == m_postings.end()) {
+            continue;
+        }
+        auto pos = std::lower_bound(it->begin(), it->end(), docId);
+        if (pos != it->end() && *pos == docId) {
+            it->erase(pos);
+        }
+        if (!it->isEmpty()) {
+            continue;
+        }
+        m_postings.erase(it);
+        if (isCjk(term.at(0))) {
+            continue;
+        }
+        if (m_sortedTermsDirty) {
+            m_sortedTerms.removeOne(term);
+        } else {
+            auto sorted = std::lower_bound(m_sortedTerms.begin(), m_sortedTerms.end(), term);
+            if (sorted != m_sortedTerms.end() && *sorted == term) {
+                m_sortedTerms.erase(sorted);
+            }
+        }
+    }
+    m_documentTerms.erase(doc);
+}
+
+void SearchIndex::ensureSortedTerms() const {
+    if (m_sortedTermsDirty) {
+        std::sort(m_sortedTerms.begin(), m_sortedTerms.end());
+        m_sortedTermsDirty = false;
+    }
+}
+
+QVector<int> SearchIndex::postingsForPrefix(const QString &prefix) const {
+    ensureSortedTerms();
+
+    auto first = std::lower_bound(m_sortedTerms.cbegin(), m_sortedTerms.cend(), prefix);
+    auto last = first;
+    while (last != m_sortedTerms.cend() && last->startsWith(prefix)) {
+        ++last;
+    }
+
+    if (first == last) {
+        return QVector<int>();
+    }
+    if (last - first == 1) {
+        return m_postings.value(*first);
+    }
+
+    // 多个词条共享前缀时用位图合并，避免反复做有序归并
+    std::vector<char> marks(static_cast<size_t>(m_maxDocId + 1), 0);
+    for (auto it = first; it != last; ++it) {
+        for (int docId : m_postings.value(*it)) {
+            marks[static_cast<size_t>(docId)] = 1;
+        }
+    }
+
+    QVector<int> merged;
+    for (int docId = 0; docId <= m_maxDocId; ++docId) {
+        if (marks[static_cast<size_t>(docId)]) {
+            merged.append(docId);
+        }
+    }
+    return merged;
+}
+
+QVector<int> SearchIndex::search(const QString &query, int limit) const {
+    QVector<QVector<int>> lists;
+
+    for (const Token &token : tokenize(query)) {
+        if (!token.isCjk) {
+            lists.append(postingsForPrefix(token.text));
+        } else if (token.text.size() == 1) {
+            lists.append(m_postings.value(token.text));
+        } else {
+            for (int i = 0; i + 1 < token.text.size(); ++i) {
+                lists.append(m_postings.value(token.text.mid(i, 2)));
+            }
+        }
+    }
+
+    if (lists.isEmpty()) {
+        return QVector<int>();
+    }
+
+    // 从最短的倒排表开始求交集
+    std::sort(lists.begin(), lists.end(), [](const QVector<int> &a, const QVector<int> &b) {
+        return a.size() < b.size();
+    });
+
+    QVector<int> result = lists.first();
+    for (int i = 1; i < lists.size() && !result.isEmpty(); ++i) {
+        QVector<int> intersection;
+        intersection.reserve(result.size());
+        std::set_intersection(result.cbegin(), result.cend(),
+                              lists[i].cbegin(), lists[i].cend(),
+                              std::back_inserter(intersection));
+        result.swap(intersection);
+    }
+
+    std::reverse(result.begin(), result.end());
+    if (limit > 0 && result.size() > limit) {
+        result.resize(limit);
+    }
+    return result;
+}
@@ -0,0 +1,63 @@
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * @brief 壁纸元数据的内存倒排索引
+ *
+ * 分词规则：
+ * - 拉丁字母/数字按单词切分，统一做 NFKC 规范化和大小写折叠，查询时按前缀匹配，
+ *   便于边输入边出结果；
+ * - 中日韩文字没有空格分隔，按连续字符串切成二元组（bigram），同时保留单字，
+ *   这样单字查询和多字查询都能命中。
+ *
+ * 文档编号由调用方分配并保持不变，倒排表按编号有序。文档可以随时添加、替换或删除，
+ * 只改动它涉及的词条，不需要重建整个索引。
+ */
+class SearchIndex {
+public:
+    void clear();
+
+    /**
+     * @brief 添加文档，编号已存在时替换原来的内容
+     */
+    void addDocument(int docId, const QString &text);
+    void removeDocument(int docId);
+
+    /**
+     * @brief 查询同时包含所有查询词的文档
+     * @param query 用户输入
+     * @param limit 最多返回的条数，<= 0 表示不限
+     * @return 命中的文档编号，编号大的在前
+     */
+    QVector<int> search(const QString &query, int limit = 0) const;
+
+    int documentCount() const { return m_documentTerms.size(); }
+
+private:
+    struct Token {
+        QString text;
+        bool isCjk;
+    };
+
+    static QVector<Token> tokenize(const QString &text);
+    static QStringList termsOf(const QString &text);
+    static bool isCjk(QChar ch);
+    QVector<int> postingsForPrefix(const QString &prefix) const;
+    void ensureSortedTerms() const;
+
+    QHash<QString, QVector<int>> m_postings;
+    QHash<int, QStringList> m_documentTerms;    // 删除或替换文档时只更新这些倒排表
+    int m_maxDocId = -1;
+
+    // 拉丁词条的有序列表，用于前缀查询。批量添加时先追加，第一次查询时排序一次；
+    // 之后新增的词条直接插入到有序位置
+    mutable QStringList m_sortedTerms;
+    mutable bool m_sortedTermsDirty = true;
+};
+
+#endif // SEARCHINDEX_H
@@ -0,0 +1,198 @@
+#include "SettingsStore.h"
+#include <QCoreApplication>
+#include <QSettings>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDebug>
+#include <utility>
+
+namespace {
+
+const char *ORGANIZATION = "BingWallpaper";
+const char *APPLICATION = "Settings";
+// 连续调整（如按住微调框的箭头）合并成一次写入
+const int WRITE_DELAY_MS = 500;
+// 编辑器保存文件可能分几步完成，稍等再读取
+const int RELOAD_DELAY_MS = 200;
+
+/**
+ * @brief 比较内存中的值和从文件读到的值
+ *
+ * INI 文件读回来的都是字符串，先转换成内存中的类型再比较，避免把自己写入的值当成外部修改。
+ */
+bool sameValue(const QVariant &current, QVariant incoming) {
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    incoming.convert(current.metaType());
+#else
+    incoming.convert(current.userType());
+#endif
+    return incoming == current;
+}
+
+}
+
+SettingsStore *SettingsStore::instance() {
+    static SettingsStore *store = new SettingsStore();
+    return store;
+}
+
+SettingsStore::SettingsStore(QObject *parent)
+    : QObject(parent)
+    , m_values(readAll())
+    , m_writesInFlight(0)
+    , m_reloadPending(false)
+{
+    m_writer.setMaxThreadCount(1);
+
+    m_writeTimer.setSingleShot(true);
+    m_writeTimer.setInterval(WRITE_DELAY_MS);
+    connect(&m_writeTimer, &QTimer::timeout, this, &SettingsStore::startWrite);
+
+    m_reloadTimer.setSingleShot(true);
+    m_reloadTimer.setInterval(RELOAD_DELAY_MS);
+    connect(&m_reloadTimer, &QTimer::timeout, this, &SettingsStore::reload);
+
+    // 同时监视文件和所在目录：QSettings 写入时会替换文件，文件被删除后重建也要能发现
+    m_watchedFiles << QSettings(ORGANIZATION, APPLICATION).fileName()
+                   << QSettings(QSettings::SystemScope, ORGANIZATION, APPLICATION).fileName();
+    QDir().mkpath(QFileInfo(m_watchedFiles.first()).absolutePath());
+    for (const QString &path : std::as_const(m_watchedFiles)) {
+        QString directory = QFileInfo(path).absolutePath();
+        if (QDir(directory).exists()) {
+            m_watcher.addPath(directory);
+        }
+    }
+    watchFiles();
+    connect(&m_watcher, &QFileSystemWatcher::fileChanged, this, &SettingsStore::scheduleReload);
+    connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, &SettingsStore::scheduleReload);
+
+    if (QCoreApplication::instance()) {
+        connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, &SettingsStore::flush);
+    }
+}
+
+QString SettingsStore::filePath() const {
+    return m_watchedFiles.first();
+}
+
+QVariantMap SettingsStore::readAll() {
+    // 用户配置之外还会读到 /etc/xdg 下的系统配置作为默认值
+    QSettings settings(ORGANIZATION, APPLICATION);
+    settings.sync();
+    QVariantMap values;
+    const QStringList keys = settings.allKeys();
+    for (const QString &key : keys) {
+        values.insert(key, settings.value(key));
+    }
+    return values;
+}
+
+void SettingsStore::setRawValue(const QString &key, const QVariant &value) {
+    QVariant current = m_values.value(key);
+    if (current.isValid() == value.isValid() && (!value.isValid() || sameValue(current, value))) {
+        return;
+    }
+
+    if (value.isValid()) {
+        m_values.insert(key, value);
+    } else {
+        m_values.remove(key);
+    }
+    m_dirty.insert(key, value);
+    scheduleWrite();
+    emit valueChanged(key, value);
+}
+
+void SettingsStore::scheduleWrite() {
+    m_writeTimer.start();
+}
+
+void SettingsStore::startWrite() {
+    if (m_dirty.isEmpty()) {
+        return;
+    }
+
+    // 只写入改动过的键，其他进程同时修改的键不受影响
+    QVariantMap changes = m_dirty;
+    m_dirty.clear();
+    ++m_writesInFlight;
+    m_writer.start([this, changes]() {
+        QSettings settings(ORGANIZATION, APPLICATION);
+        for (auto it = changes.constBegin(); it != changes.constEnd(); ++it) {
+            if (it.value().isValid()) {
+                settings.setValue(it.key(), it.value());
+            } else {
+                settings.remove(it.key());
+            }
+        }
+        settings.sync();
+        if (settings.status() != QSettings::NoError) {
+            qDebug() << "写入配置文件失败:" << settings.fileName();
+        }
+        QMetaObject::invokeMethod(this, &SettingsStore::onWriteFinished, Qt::QueuedConnection);
+    });
+}
+
+void SettingsStore::onWriteFinished() {
+    --m_writesInFlight;
+    if (m_reloadPending) {
+        reload();
+    }
+}
+
+void SettingsStore::flush() {
+    m_writeTimer.stop();
+    startWrite();
+    m_writer.waitForDone();
+}
+
+void SettingsStore::watchFiles() {
+    // 文件被替换后监视会失效，需要重新添加
+    const QStringList watched = m_watcher.files();
+    for (const QString &path : std::as_const(m_watchedFiles)) {
+        if (!watched.contains(path) && QFile::exists(path)) {
+            m_watcher.addPath(path);
+        }
+    }
+}
+
+void SettingsStore::scheduleReload() {
+    m_reloadTimer.start();
+}
+
+void SettingsStore::reload() {
+    watchFiles();
+
+    // 自己的修改还没写完时读到的是旧内容，等写完再读
+    if (m_writesInFlight > 0 || !m_dirty.isEmpty()) {
+        m_reloadPending = true;
+        return;
+    }
+    m_reloadPending = false;
+
+    QVariantMap fresh = readAll();
+    QStringList keys = m_values.keys();
+    for (auto it = fresh.constBegin(); it != fresh.constEnd(); ++it) {
+        if (!m_values.contains(it.key())) {
+            keys.append(it.key());
+        }
+    }
+
+    for (const QString &key : std::as_const(keys)) {
+        QVariant current = m_values.value(key);
+        QVariant incoming = fresh.value(key);
+        if (!incoming.isValid()) {
+            m_values.remove(key);
+            qDebug() << "配置项已被删除:" << key;
+            emit valueChanged(key, QVariant());
+            continue;
+        }
+        if (current.isValid() && sameValue(current, incoming)) {
+            continue;
+        }
+        m_values.insert(key, incoming);
+        qDebug() << "配置项已在外部修改:" << key << incoming;
+        emit valueChanged(key, incoming);
+    }
+}
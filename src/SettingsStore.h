@@ -0,0 +1,125 @@
+#ifndef SETTINGSSTORE_H
+#define SETTINGSSTORE_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVariantMap>
+#include <QTimer>
+#include <QThreadPool>
+#include <QFileSystemWatcher>
+
+/**
+ * @brief 带类型和默认值的配置项
+ */
+template<typename T>
+struct SettingsKey {
+    const char *name;
+    T defaultValue;
+};
+
+/**
+ * @brief 所有配置项，配置文件中的键名与旧版本保持一致
+ */
+namespace SettingsKeys {
+
+inline const SettingsKey<bool> AutoUpdate{"autoUpdate", false};
+inline const SettingsKey<int> UpdateInterval{"updateInterval", 24};             // 小时
+inline const SettingsKey<bool> LowMemoryMode{"lowMemoryMode", true};
+inline const SettingsKey<QString> WallpaperDirectory{"wallpaperDirectory", QString()}; // 空为默认路径
+inline const SettingsKey<QStringList> Endpoints{"endpoints", {"https://www.bing.com", "https://cn.bing.com"}};
+inline const SettingsKey<int> StallTimeout{"stallTimeout", 15};                 // 秒
+inline const SettingsKey<bool> RespectMeteredConnections{"respectMeteredConnections", true};
+inline const SettingsKey<int> LowBatteryThreshold{"lowBatteryThreshold", 20};   // 百分比
+inline const SettingsKey<QString> ReducedResolution{"reducedResolution", "1920x1080"};
+inline const SettingsKey<QString> TrayIconVariant{"trayIconVariant", "light"};     // light 用于深色面板，dark 用于浅色面板
+inline const SettingsKey<QStringList> ScreenAssignments{"screenAssignments", {}};  // "显示器名=相对天数[@地区]"
+inline const SettingsKey<int> PrefetchRateLimit{"prefetchRateLimit", 1024};        // KiB/s，0 关闭预取
+
+}
+
+/**
+ * @brief 进程内共享的配置，替代各处自行构造的 QSettings
+ *
+ * 读写只访问内存中的副本。修改在 500 毫秒内合并后由后台线程写回配置文件，
+ * 只写入改动过的键，不会覆盖其他进程同时做的修改；退出时同步写完。
+ * 配置文件（以及 /etc/xdg 下的系统配置）被其他实例或管理员修改后自动重新读取，
+ * 变化的键通过 valueChanged 通知，无需重启。
+ */
+class SettingsStore : public QObject {
+    Q_OBJECT
+
+public:
+    static SettingsStore *instance();
+
+    template<typename T>
+    T value(const SettingsKey<T> &key) const {
+        QVariant stored = m_values.value(key.name);
+        return stored.isValid() ? stored.value<T>() : key.defaultValue;
+    }
+
+    template<typename T>
+    void setValue(const SettingsKey<T> &key, const T &value) {
+        setRawValue(key.name, QVariant::fromValue(value));
+    }
+
+    /**
+     * @brief 删除配置项，之后读取返回默认值
+     */
+    template<typename T>
+    void remove(const SettingsKey<T> &key) {
+        setRawValue(key.name, QVariant());
+    }
+
+    /**
+     * @brief 配置项变化时调用 functor，参数为新值（被删除时为默认值）
+     * @param context functor 所属对象，销毁后自动断开
+     */
+    template<typename T, typename Functor>
+    QMetaObject::Connection onChanged(const SettingsKey<T> &key, const QObject *context, Functor functor) {
+        return connect(this, &SettingsStore::valueChanged, context,
+                       [name = QString(key.name), defaultValue = key.defaultValue, functor](
+                           const QString &changed, const QVariant &value) {
+            if (changed == name) {
+                functor(value.isValid() ? value.value<T>() : defaultValue);
+            }
+        });
+    }
+
+    /**
+     * @brief 立即写回所有未保存的修改并等待完成
+     */
+    void flush();
+
+    QString filePath() const;
+
+signals:
+    /**
+     * @param value 新值，配置项被删除时无效
+     */
+    void valueChanged(const QString &key, const QVariant &value);
+
+private:
+    explicit SettingsStore(QObject *parent = nullptr);
+    void setRawValue(const QString &key, const QVariant &value);
+    void scheduleWrite();
+    void startWrite();
+    void onWriteFinished();
+    void scheduleReload();
+    void reload();
+    void watchFiles();
+    static QVariantMap readAll();
+
+    QVariantMap m_values;
+    QVariantMap m_dirty;            // 尚未交给写线程的修改，值无效表示删除
+    int m_writesInFlight;
+    bool m_reloadPending;
+    QTimer m_writeTimer;
+    QTimer m_reloadTimer;
+    QThreadPool m_writer;           // 单线程，写入按提交顺序执行
+    QFileSystemWatcher m_watcher;
+    QStringList m_watchedFiles;
+};
+
+#endif // SETTINGSSTORE_H
@@ -0,0 +1,389 @@
+#ifndef TASK_H
+#define TASK_H
+
+#include <atomic>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 基于 C++20 协程的轻量任务层
+ *
+ * Task<T> 是惰性启动的协程，被 co_await 时才开始执行，结束后通过对称转移直接恢复等待者。
+ * 顶层任务用 spawn() 启动，由协程帧自行管理生命周期。
+ * 所有恢复都发生在主线程（见 Awaitables.h），因此任务内部不需要加锁。
+ * 本文件不依赖 Qt。
+ */
+namespace Async {
+
+/**
+ * @brief 取消令牌
+ *
+ * 复制后共享同一状态。cancel() 在主线程调用，依次执行已登记的回调
+ * （例如中止网络请求、结束子进程）；isCancelled() 可以在工作线程中轮询。
+ */
+class CancellationToken {
+    struct State {
+        std::atomic<bool> cancelled{false};
+        std::map<int, std::function<void()>> callbacks;
+        int nextId = 0;
+    };
+
+public:
+    /**
+     * @brief 回调登记，析构时自动注销
+     */
+    class Registration {
+    public:
+        Registration() = default;
+        Registration(std::weak_ptr<State> state, int id) : m_state(std::move(state)), m_id(id) {}
+        Registration(Registration &&other) noexcept
+            : m_state(std::move(other.m_state)), m_id(std::exchange(other.m_id, -1)) {}
+        Registration &operator=(Registration &&other) noexcept {
+            if (this != &other) {
+                reset();
+                m_state = std::move(other.m_state);
+                m_id = std::exchange(other.m_id, -1);
+            }
+            return *this;
+        }
+        Registration(const Registration &) = delete;
+        Registration &operator=(const Registration &) = delete;
+        ~Registration() { reset(); }
+
+        void reset() {
+            if (auto state = m_state.lock()) {
+                state->callbacks.erase(m_id);
+            }
+            m_state.reset();
+            m_id = -1;
+        }
+
+    private:
+        std::weak_ptr<State> m_state;
+        int m_id = -1;
+    };
+
+    CancellationToken() : m_state(std::make_shared<State>()) {}
+
+    bool isCancelled() const { return m_state->cancelled.load(std::memory_order_acquire); }
+
+    void cancel() {
+        if (m_state->cancelled.exchange(true, std::memory_order_acq_rel)) {
+            return;
+        }
+        // 回调中可能注销其他登记，先取出再执行
+        auto callbacks = std::move(m_state->callbacks);
+        m_state->callbacks.clear();
+        for (auto &entry : callbacks) {
+            entry.second();
+        }
+    }
+
+    /**
+     * @brief 登记取消回调，已取消时立即执行
+     */
+    [[nodiscard]] Registration onCancel(std::function<void()> callback) const {
+        if (isCancelled()) {
+            callback();
+            return Registration();
+        }
+        int id = m_state->nextId++;
+        m_state->callbacks.emplace(id, std::move(callback));
+        return Registration(m_state, id);
+    }
+
+private:
+    std::shared_ptr<State> m_state;
+};
+
+template<typename T = void>
+class Task;
+
+namespace detail {
+
+struct PromiseBase {
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+
+        template<typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            std::coroutine_handle<> continuation = handle.promise().continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() { exception = std::current_exception(); }
+
+    std::coroutine_handle<> continuation;
+    std::exception_ptr exception;
+};
+
+template<typename Promise>
+class TaskBase {
+public:
+    using Handle = std::coroutine_handle<Promise>;
+
+    TaskBase(TaskBase &&other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+    TaskBase &operator=(TaskBase &&other) noexcept {
+        if (this != &other) {
+            if (m_handle) {
+                m_handle.destroy();
+            }
+            m_handle = std::exchange(other.m_handle, {});
+        }
+        return *this;
+    }
+    TaskBase(const TaskBase &) = delete;
+    TaskBase &operator=(const TaskBase &) = delete;
+    ~TaskBase() {
+        if (m_handle) {
+            m_handle.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept { return !m_handle || m_handle.done(); }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        m_handle.promise().continuation = awaiting;
+        return m_handle;
+    }
+
+protected:
+    explicit TaskBase(Handle handle) : m_handle(handle) {}
+
+    void rethrowIfFailed() const {
+        if (m_handle.promise().exception) {
+            std::rethrow_exception(m_handle.promise().exception);
+        }
+    }
+
+    Handle m_handle;
+};
+
+} // namespace detail
+
+namespace detail {
+
+template<typename T>
+struct TaskPromise;
+
+} // namespace detail
+
+template<typename T>
+class Task : public detail::TaskBase<detail::TaskPromise<T>> {
+public:
+    using promise_type = detail::TaskPromise<T>;
+
+    T await_resume() {
+        this->rethrowIfFailed();
+        return std::move(*this->m_handle.promise().result);
+    }
+
+private:
+    friend struct detail::TaskPromise<T>;
+    explicit Task(std::coroutine_handle<promise_type> handle)
+        : detail::TaskBase<promise_type>(handle) {}
+};
+
+template<>
+class Task<void> : public detail::TaskBase<detail::TaskPromise<void>> {
+public:
+    using promise_type = detail::TaskPromise<void>;
+
+    void await_resume() { rethrowIfFailed(); }
+
+private:
+    friend struct detail::TaskPromise<void>;
+    explicit Task(std::coroutine_handle<promise_type> handle)
+        : detail::TaskBase<promise_type>(handle) {}
+};
+
+namespace detail {
+
+template<typename T>
+struct TaskPromise : PromiseBase {
+    Task<T> get_return_object() { return Task<T>(std::coroutine_handle<TaskPromise>::from_promise(*this)); }
+
+    template<typename U>
+    void return_value(U &&value) { result.emplace(std::forward<U>(value)); }
+
+    std::optional<T> result;
+};
+
+template<>
+struct TaskPromise<void> : PromiseBase {
+    Task<void> get_return_object() { return Task<void>(std::coroutine_handle<TaskPromise>::from_promise(*this)); }
+    void return_void() {}
+};
+
+} // namespace detail
+
+namespace detail {
+
+// 立即开始执行、结束后自行销毁的协程，只用于 spawn()
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() const noexcept { return {}; }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+};
+
+} // namespace detail
+
+/**
+ * @brief 启动顶层任务，运行到第一次挂起后返回
+ */
+inline detail::DetachedTask spawn(Task<void> task) {
+    co_await task;
+}
+
+namespace detail {
+
+template<typename T>
+struct WhenAllState {
+    std::vector<std::optional<T>> results;
+    std::size_t remaining = 0;
+    std::exception_ptr exception;
+    std::coroutine_handle<> waiter;
+};
+
+template<typename T>
+DetachedTask runWhenAllChild(Task<T> task, std::shared_ptr<WhenAllState<T>> state, std::size_t index) {
+    try {
+        state->results[index].emplace(co_await task);
+    } catch (...) {
+        if (!state->exception) {
+            state->exception = std::current_exception();
+        }
+    }
+    // 最后一个结束的子任务恢复 whenAll；都同步完成时 waiter 为空，由 await_ready 直接放行
+    if (--state->remaining == 0 && state->waiter) {
+        state->waiter.resume();
+    }
+}
+
+template<typename T>
+class WhenAllAwaiter {
+public:
+    explicit WhenAllAwaiter(std::shared_ptr<WhenAllState<T>> state) : m_state(std::move(state)) {}
+
+    bool await_ready() const noexcept { return m_state->remaining == 0; }
+    void await_suspend(std::coroutine_handle<> handle) noexcept { m_state->waiter = handle; }
+    void await_resume() const noexcept {}
+
+private:
+    std::shared_ptr<WhenAllState<T>> m_state;
+};
+
+} // namespace detail
+
+/**
+ * @brief 同时启动所有子任务，全部结束后按原顺序返回结果
+ *
+ * 子任务立即开始执行并交错运行，总耗时取决于最慢的一个。取消由各子任务自己的令牌处理；
+ * 子任务抛出的第一个异常在全部结束后重新抛出。
+ */
+template<typename T>
+Task<std::vector<T>> whenAll(std::vector<Task<T>> tasks) {
+    auto state = std::make_shared<detail::WhenAllState<T>>();
+    state->results.resize(tasks.size());
+    state->remaining = tasks.size();
+    for (std::size_t i = 0; i < tasks.size(); ++i) {
+        detail::runWhenAllChild(std::move(tasks[i]), state, i);
+    }
+
+    detail::WhenAllAwaiter<T> all(state);
+    co_await all;
+    if (state->exception) {
+        std::rethrow_exception(state->exception);
+    }
+    std::vector<T> results;
+    results.reserve(state->results.size());
+    for (std::optional<T> &result : state->results) {
+        results.push_back(std::move(*result));
+    }
+    co_return results;
+}
+
+/**
+ * @brief 协程互斥锁，等待者按先后顺序获得锁
+ *
+ * 只能在同一线程内使用。用 std::shared_ptr 持有，锁的所有者销毁后，
+ * 仍在等待或持有锁的协程可以安全地继续运行并释放锁。
+ */
+class AsyncMutex : public std::enable_shared_from_this<AsyncMutex> {
+public:
+    /**
+     * @brief 持锁守卫，析构时释放锁并把锁直接交给下一个等待者
+     */
+    class Guard {
+    public:
+        explicit Guard(std::shared_ptr<AsyncMutex> mutex) : m_mutex(std::move(mutex)) {}
+        Guard(Guard &&other) noexcept = default;
+        Guard &operator=(Guard &&other) = delete;
+        Guard(const Guard &) = delete;
+        Guard &operator=(const Guard &) = delete;
+        ~Guard() {
+            if (m_mutex) {
+                m_mutex->unlock();
+            }
+        }
+
+    private:
+        std::shared_ptr<AsyncMutex> m_mutex;
+    };
+
+    class LockAwaiter {
+    public:
+        explicit LockAwaiter(std::shared_ptr<AsyncMutex> mutex) : m_mutex(std::move(mutex)) {}
+
+        bool await_ready() {
+            if (m_mutex->m_locked) {
+                return false;
+            }
+            m_mutex->m_locked = true;
+            return true;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) { m_mutex->m_waiters.push_back(handle); }
+
+        Guard await_resume() { return Guard(std::move(m_mutex)); }
+
+    private:
+        std::shared_ptr<AsyncMutex> m_mutex;
+    };
+
+    LockAwaiter lock() { return LockAwaiter(shared_from_this()); }
+
+private:
+    void unlock() {
+        if (m_waiters.empty()) {
+            m_locked = false;
+            return;
+        }
+        std::coroutine_handle<> next = m_waiters.front();
+        m_waiters.pop_front();
+        next.resume();
+    }
+
+    bool m_locked = false;
+    std::deque<std::coroutine_handle<>> m_waiters;
+};
+
+} // namespace Async
+
+#endif // TASK_H
@@ -0,0 +1,207 @@
+#include "ThumbnailCache.h"
+#include <QRunnable>
+#include <QImageReader>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QMetaObject>
+#include <QDebug>
+#include <QFile>
+#include <QThread>
+#include <functional>
+#include <utility>
+
+namespace {
+
+class ThumbnailJob : public QRunnable {
+public:
+    ThumbnailJob(ThumbnailCache *cache, const QString &imagePath, const QString &cacheFile,
+                 const QSize &size, std::function<void(const QImage &)> deliver,
+                 QSharedPointer<QAtomicInt> cancelled)
+        : m_cache(cache)
+        , m_imagePath(imagePath)
+        , m_cacheFile(cacheFile)
+        , m_size(size)
+        , m_deliver(std::move(deliver))
+        , m_cancelled(std::move(cancelled))
+    {
+    }
+
+    void run() override {
+        // 已移出可见区域的请求直接丢弃
+        if (m_cancelled->loadAcquire()) {
+            return;
+        }
+
+        QImage image;
+        if (QFile::exists(m_cacheFile)) {
+            image.load(m_cacheFile);
+        }
+
+        if (image.isNull()) {
+            if (m_cancelled->loadAcquire()) {
+                return;
+            }
+
+            QImageReader reader(m_imagePath);
+            QSize original = reader.size();
+            if (original.isValid()) {
+                reader.setScaledSize(original.scaled(m_size, Qt::KeepAspectRatio));
+            }
+            image = reader.read();
+            if (!image.isNull()) {
+                image.save(m_cacheFile, "JPG", 85);
+            }
+        }
+
+        if (m_cancelled->loadAcquire()) {
+            return;
+        }
+
+        QMetaObject::invokeMethod(m_cache, [deliver = m_deliver, image]() {
+            deliver(image);
+        }, Qt::QueuedConnection);
+    }
+
+private:
+    ThumbnailCache *m_cache;
+    QString m_imagePath;
+    QString m_cacheFile;
+    QSize m_size;
+    std::function<void(const QImage &)> m_deliver;
+    QSharedPointer<QAtomicInt> m_cancelled;
+};
+
+} // namespace
+
+ThumbnailCache::ThumbnailCache(const QSize &thumbnailSize, QObject *parent)
+    : QObject(parent)
+    , m_thumbnailSize(thumbnailSize)
+{
+    // 解码是CPU密集任务，留出一半核心给界面和其他程序
+    m_threadPool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() / 2));
+    m_memoryCache.setMaxCost(200);
+    QDir().mkpath(diskCacheDirectory());
+}
+
+ThumbnailCache::~ThumbnailCache() {
+    for (const CancelFlag &flag : std::as_const(m_pending)) {
+        flag->storeRelease(1);
+    }
+    m_threadPool.clear();
+    m_threadPool.waitForDone();
+}
+
+QString ThumbnailCache::diskCacheDirectory() const {
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/thumbnails";
+}
+
+QString ThumbnailCache::cacheFileName(const QString &imagePath, const QSize &thumbnailSize) {
+    // 磁盘缓存以路径、大小和修改时间为键，原图被替换后自动失效
+    QFileInfo info(imagePath);
+    QByteArray key = imagePath.toUtf8() + '|' + QByteArray::number(info.size()) + '|'
+                   + QByteArray::number(info.lastModified().toMSecsSinceEpoch()) + '|'
+                   + QByteArray::number(thumbnailSize.width()) + 'x'
+                   + QByteArray::number(thumbnailSize.height());
+    return QString::fromLatin1(QCryptographicHash::hash(key, QCryptographicHash::Sha1).toHex()) + ".jpg";
+}
+
+QSize ThumbnailCache::thumbnailSize() const {
+    return m_thumbnailSize;
+}
+
+QPixmap ThumbnailCache::thumbnail(const QString &imagePath) const {
+    QPixmap *pixmap = m_memoryCache.object(imagePath);
+    return pixmap ? *pixmap : QPixmap();
+}
+
+void ThumbnailCache::request(const QString &imagePath) {
+    if (m_memoryCache.contains(imagePath) || m_pending.contains(imagePath)) {
+        return;
+    }
+
+    QString cacheFile = diskCacheDirectory() + "/" + cacheFileName(imagePath, m_thumbnailSize);
+
+    CancelFlag flag(new QAtomicInt(0));
+    m_pending.insert(imagePath, flag);
+
+    auto deliver = [this, imagePath, flag](const QImage &image) {
+        onThumbnailLoaded(imagePath, image, flag);
+    };
+    m_threadPool.start(new ThumbnailJob(this, imagePath, cacheFile, m_thumbnailSize, deliver, flag));
+}
+
+void ThumbnailCache::onThumbnailLoaded(const QString &imagePath, const QImage &image, const CancelFlag &flag) {
+    // 取消后又重新请求时，旧任务的结果不再使用
+    auto it = m_pending.find(imagePath);
+    if (it == m_pending.end() || it.value() != flag) {
+        return;
+    }
+    m_pending.erase(it);
+
+    if (image.isNull()) {
+        qDebug() << "生成缩略图失败:" << imagePath;
+        return;
+    }
+
+    m_memoryCache.insert(imagePath, new QPixmap(QPixmap::fromImage(image)));
+    emit thumbnailReady(imagePath);
+}
+
+void ThumbnailCache::cancel(const QString &imagePath) {
+    auto it = m_pending.find(imagePath);
+    if (it != m_pending.end()) {
+        it.value()->storeRelease(1);
+        m_pending.erase(it);
+    }
+}
+
+void ThumbnailCache::cancelAllExcept(const QSet<QString> &keep) {
+    for (auto it = m_pending.begin(); it != m_pending.end();) {
+        if (keep.contains(it.key())) {
+            ++it;
+        } else {
+            it.value()->storeRelease(1);
+            it = m_pending.erase(it);
+        }
+    }
+}
+
+void ThumbnailCache::remove(const QString &imagePath) {
+    cancel(imagePath);
+    m_memoryCache.remove(imagePath);
+}
+
+void ThumbnailCache::pruneDiskCache(const QStringList &imagePaths) {
+    // 每张图片都要读取文件信息，放到全局线程池里，不占用解码线程
+    QString directory = diskCacheDirectory();
+    QSize thumbnailSize = m_thumbnailSize;
+    QThreadPool::globalInstance()->start([directory, imagePaths, thumbnailSize]() {
+        QSet<QString> keep;
+        for (const QString &imagePath : imagePaths) {
+            keep.insert(cacheFileName(imagePath, thumbnailSize));
+        }
+        QDir dir(directory);
+        const QStringList files = dir.entryList(QStringList() << "*.jpg", QDir::Files);
+        int removed = 0;
+        for (const QString &file : files) {
+            if (!keep.contains(file) && dir.remove(file)) {
+                ++removed;
+            }
+        }
+        if (removed > 0) {
+            qDebug() << "清理过期缩略图:" << removed;
+        }
+    });
+}
+
+void ThumbnailCache::setCapacity(int count) {
+    m_memoryCache.setMaxCost(qMax(1, count));
+}
+
+void ThumbnailCache::clear() {
+    cancelAllExcept(QSet<QString>());
+    m_memoryCache.clear();
+}
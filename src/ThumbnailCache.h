@@ -0,0 +1,66 @@
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+#include <QObject>
+#include <QCache>
+#include <QHash>
+#include <QSet>
+#include <QPixmap>
+#include <QImage>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QAtomicInt>
+#include <QSharedPointer>
+
+/**
+ * @brief 异步缩略图缓存
+ *
+ * 两级缓存：内存中保留有限数量的 QPixmap，磁盘上在 ~/.cache 下保存缩小后的 JPEG。
+ * 未命中时在独立线程池中解码，利用 QImageReader::setScaledSize 让 libjpeg
+ * 直接按 DCT 缩放解码，不会把整张 4K 图解到内存里。
+ * 尚未开始或正在排队的请求可以随时取消。
+ */
+class ThumbnailCache : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ThumbnailCache(const QSize &thumbnailSize, QObject *parent = nullptr);
+    ~ThumbnailCache();
+
+    QPixmap thumbnail(const QString &imagePath) const;
+    void request(const QString &imagePath);
+    void cancel(const QString &imagePath);
+    void cancelAllExcept(const QSet<QString> &keep);
+    /**
+     * @brief 丢弃某张图片的缩略图，图片从壁纸库中删除时调用
+     */
+    void remove(const QString &imagePath);
+    /**
+     * @brief 在后台删除磁盘上不属于这些图片的缩略图
+     *
+     * 包括已删除的壁纸、被替换过的原图和其他尺寸的旧缩略图。
+     */
+    void pruneDiskCache(const QStringList &imagePaths);
+    void setCapacity(int count);
+    void clear();
+    QSize thumbnailSize() const;
+
+signals:
+    void thumbnailReady(const QString &imagePath);
+
+private:
+    typedef QSharedPointer<QAtomicInt> CancelFlag;
+
+    void onThumbnailLoaded(const QString &imagePath, const QImage &image, const CancelFlag &flag);
+    QString diskCacheDirectory() const;
+    static QString cacheFileName(const QString &imagePath, const QSize &thumbnailSize);
+
+    QSize m_thumbnailSize;
+    QThreadPool m_threadPool;
+    QCache<QString, QPixmap> m_memoryCache;
+    QHash<QString, CancelFlag> m_pending;
+};
+
+#endif // THUMBNAILCACHE_H
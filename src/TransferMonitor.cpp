@@ -0,0 +1,110 @@
+#include "TransferMonitor.h"
+#include "Metrics.h"
+#include <QDebug>
+#include <cmath>
+
+namespace {
+
+const int TICK_INTERVAL_MS = 100;       // 界面每秒最多刷新 10 次
+const double SMOOTHING = 0.2;           // 速度平滑系数，越小越平稳
+const int DEFAULT_STALL_TIMEOUT_MS = 15000;
+
+}
+
+TransferMonitor::TransferMonitor(QObject *parent)
+    : QObject(parent)
+    , m_stallTimeoutMs(DEFAULT_STALL_TIMEOUT_MS)
+    , m_bytesReceived(0)
+    , m_bytesTotal(-1)
+    , m_bytesAtLastTick(0)
+    , m_bytesPerSecond(0.0)
+    , m_active(false)
+{
+    m_tickTimer.setInterval(TICK_INTERVAL_MS);
+    connect(&m_tickTimer, &QTimer::timeout, this, &TransferMonitor::onTick);
+}
+
+void TransferMonitor::setStallTimeout(int milliseconds) {
+    m_stallTimeoutMs = milliseconds;
+}
+
+void TransferMonitor::start() {
+    m_bytesReceived = 0;
+    m_bytesTotal = -1;
+    m_bytesAtLastTick = 0;
+    m_bytesPerSecond = 0.0;
+    m_active = true;
+    m_transferTimer.start();
+    m_sinceLastBytes.start();
+    m_sinceLastTick.start();
+    m_tickTimer.start();
+}
+
+void TransferMonitor::update(qint64 bytesReceived, qint64 bytesTotal) {
+    if (!m_active) {
+        return;
+    }
+    if (bytesReceived > m_bytesReceived) {
+        m_sinceLastBytes.restart();
+    }
+    m_bytesReceived = bytesReceived;
+    m_bytesTotal = bytesTotal;
+}
+
+void TransferMonitor::restartStallTimer() {
+    m_sinceLastBytes.restart();
+}
+
+void TransferMonitor::rebase() {
+    // 速度估计保留，链路本身没有变化
+    m_bytesReceived = 0;
+    m_bytesTotal = -1;
+    m_bytesAtLastTick = 0;
+    m_sinceLastBytes.restart();
+}
+
+void TransferMonitor::onTick() {
+    qint64 elapsedMs = m_sinceLastTick.restart();
+    if (elapsedMs > 0) {
+        double instant = qMax(0.0, (m_bytesReceived - m_bytesAtLastTick) * 1000.0 / elapsedMs);
+        // 第一次有数据时直接采用瞬时速度，避免从 0 慢慢爬升
+        m_bytesPerSecond = m_bytesPerSecond <= 0.0 ? instant
+                                                   : SMOOTHING * instant + (1.0 - SMOOTHING) * m_bytesPerSecond;
+    }
+    m_bytesAtLastTick = m_bytesReceived;
+
+    if (m_sinceLastBytes.elapsed() >= m_stallTimeoutMs) {
+        qDebug() << "下载停滞超过" << m_stallTimeoutMs / 1000 << "秒";
+        Metrics::instance()->incrementCounter("bing_wallpaper_download_stalls_total");
+        m_sinceLastBytes.restart();
+        emit stalled();
+        return;
+    }
+
+    if (m_bytesTotal <= 0) {
+        return;
+    }
+    int percentage = int(m_bytesReceived * 100 / m_bytesTotal);
+    int etaSeconds = -1;
+    if (m_bytesPerSecond > 1.0) {
+        etaSeconds = int(std::ceil((m_bytesTotal - m_bytesReceived) / m_bytesPerSecond));
+    }
+    emit progressUpdated(percentage, m_bytesPerSecond, etaSeconds);
+}
+
+void TransferMonitor::finish(bool success) {
+    if (!m_active) {
+        return;
+    }
+    m_active = false;
+    m_tickTimer.stop();
+
+    qint64 elapsedMs = m_transferTimer.elapsed();
+    if (success && elapsedMs > 0 && m_bytesReceived > 0) {
+        double average = m_bytesReceived * 1000.0 / elapsedMs;
+        Metrics::instance()->observe("bing_wallpaper_download_throughput_bytes_per_second", average,
+                                     {131072, 262144, 524288, 1048576, 2097152, 4194304, 8388608, 16777216, 33554432});
+        Metrics::instance()->observe("bing_wallpaper_download_duration_ms", elapsedMs,
+                                     {250, 500, 1000, 2000, 4000, 8000, 16000, 32000, 64000});
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef TRANSFERMONITOR_H
+#define TRANSFERMONITOR_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+
+/**
+ * @brief 下载进度汇总：固定频率刷新、平滑速度与剩余时间、停滞检测
+ *
+ * QNetworkReply 每收到一个数据块就发出一次 downloadProgress，4K 图片会触发上千次，
+ * 直接驱动进度条会造成大量重绘。这里只记录最新数值，由定时器以 10 Hz 统一发出，
+ * 并用指数加权移动平均计算下载速度。超过设定时间没有收到新数据时发出 stalled，
+ * 由调用方中止并重试。
+ */
+class TransferMonitor : public QObject {
+    Q_OBJECT
+
+public:
+    explicit TransferMonitor(QObject *parent = nullptr);
+
+    void setStallTimeout(int milliseconds);
+
+    void start();
+
+    /**
+     * @brief 记录最新进度
+     * @param bytesReceived 已收到的字节数（含断点续传前已下载的部分）
+     * @param bytesTotal 总字节数，未知时为 -1
+     */
+    void update(qint64 bytesReceived, qint64 bytesTotal);
+
+    /**
+     * @brief 重新发起请求后调用，停滞计时重新开始
+     */
+    void restartStallTimer();
+
+    /**
+     * @brief 服务器不支持续传、从头重新下载时调用，进度从 0 开始计算并重新开始停滞计时
+     */
+    void rebase();
+
+    void finish(bool success);
+
+signals:
+    void progressUpdated(int percentage, double bytesPerSecond, int etaSeconds);
+    void stalled();
+
+private:
+    void onTick();
+
+    QTimer m_tickTimer;
+    QElapsedTimer m_transferTimer;
+    QElapsedTimer m_sinceLastBytes;
+    QElapsedTimer m_sinceLastTick;
+    int m_stallTimeoutMs;
+    qint64 m_bytesReceived;
+    qint64 m_bytesTotal;
+    qint64 m_bytesAtLastTick;
+    double m_bytesPerSecond;
+    bool m_active;
+};
+
+#endif // TRANSFERMONITOR_H
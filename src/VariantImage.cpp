@@ -0,0 +1,17 @@
+#include "VariantImage.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+
+namespace VariantImage {
+
+bool save(const QImage &image, const QString &path, int quality) {
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || !image.save(&file, "JPG", quality)) {
+        return false;
+    }
+    return file.commit();
+}
+
+}
@@ -0,0 +1,24 @@
+#ifndef VARIANTIMAGE_H
+#define VARIANTIMAGE_H
+
+#include <QImage>
+#include <QString>
+
+/**
+ * @brief 派生图片（暗色版本、锁屏图片、跨屏合成图）的写入
+ *
+ * 派生图片之后只按文件是否存在决定是否复用，不会再检查内容。因此先写入同目录下的
+ * 临时文件，编码完整后再原子地替换目标文件：崩溃、磁盘写满或两个任务同时生成同一张图时，
+ * 目标路径上要么没有文件，要么是一张完整的图片。
+ */
+namespace VariantImage {
+
+/**
+ * @brief 以 JPEG 格式原子地写入图片，目录不存在时自动创建
+ * @return 写入失败时返回 false，目标文件保持原样
+ */
+bool save(const QImage &image, const QString &path, int quality);
+
+}
+
+#endif // VARIANTIMAGE_H
@@ -0,0 +1,140 @@
+#include "WallpaperCacheClient.h"
+#include "Metrics.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QDebug>
+
+#ifdef Q_OS_LINUX
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+
+namespace {
+
+// 服务需要先从上游下载完整的 4K 图片，慢速网络下也要留足时间
+const int REQUEST_TIMEOUT_MS = 120000;
+
+}
+
+WallpaperCacheClient::WallpaperCacheClient(QObject *parent)
+    : QObject(parent)
+    , m_socketPath(defaultSocketPath())
+    , m_socket(new QLocalSocket(this))
+{
+    m_timeoutTimer.setSingleShot(true);
+    m_timeoutTimer.setInterval(REQUEST_TIMEOUT_MS);
+    connect(&m_timeoutTimer, &QTimer::timeout, this, [this]() {
+        fail("共享缓存服务响应超时");
+    });
+
+    connect(m_socket, &QLocalSocket::connected, this, &WallpaperCacheClient::onConnected);
+    connect(m_socket, &QLocalSocket::readyRead, this, &WallpaperCacheClient::onReadyRead);
+    connect(m_socket, &QLocalSocket::errorOccurred, this, [this]() {
+        fail("连接共享缓存服务失败: " + m_socket->errorString());
+    });
+}
+
+QString WallpaperCacheClient::defaultSocketPath() {
+    QString path = qEnvironmentVariable("BING_WALLPAPER_CACHE_SOCKET");
+    return path.isEmpty() ? QString("/run/bing-wallpaper/cache.sock") : path;
+}
+
+bool WallpaperCacheClient::isAvailable() const {
+    return QFile::exists(m_socketPath);
+}
+
+void WallpaperCacheClient::fetch(const QString &date, const QString &market, const QString &imagePath,
+                                 const QString &destPath) {
+    cancel();
+
+    QJsonObject request;
+    request["date"] = date;
+    request["market"] = market;
+    request["path"] = imagePath;
+    m_request = QJsonDocument(request).toJson(QJsonDocument::Compact) + "\n";
+    m_destPath = destPath;
+
+    m_timeoutTimer.start();
+    m_socket->connectToServer(m_socketPath);
+}
+
+void WallpaperCacheClient::cancel() {
+    m_timeoutTimer.stop();
+    m_request.clear();
+    m_destPath.clear();
+    m_socket->abort();
+}
+
+void WallpaperCacheClient::onConnected() {
+    m_socket->write(m_request);
+}
+
+void WallpaperCacheClient::onReadyRead() {
+    if (!m_socket->canReadLine() || m_destPath.isEmpty()) {
+        return;
+    }
+
+    QJsonObject reply = QJsonDocument::fromJson(m_socket->readLine()).object();
+    if (!reply["ok"].toBool()) {
+        fail("共享缓存服务返回错误: " + reply["error"].toString());
+        return;
+    }
+
+    QString destPath = m_destPath;
+    QString sourcePath = reply["path"].toString();
+    cancel();
+
+    if (!cloneFile(sourcePath, destPath)) {
+        Metrics::instance()->incrementCounter("bing_wallpaper_fleet_cache_total{result=\"fallback\"}");
+        emit finished(false, "复制共享缓存文件失败");
+        return;
+    }
+
+    Metrics::instance()->incrementCounter("bing_wallpaper_fleet_cache_total{result=\"hit\"}");
+    qDebug() << "已从共享缓存获取壁纸:" << sourcePath;
+    emit finished(true, QString());
+}
+
+void WallpaperCacheClient::fail(const QString &error) {
+    // 主动取消后 abort 也会触发 error 信号，此时没有进行中的请求
+    if (m_destPath.isEmpty()) {
+        return;
+    }
+    cancel();
+    qDebug() << error;
+    Metrics::instance()->incrementCounter("bing_wallpaper_fleet_cache_total{result=\"fallback\"}");
+    emit finished(false, error);
+}
+
+bool WallpaperCacheClient::cloneFile(const QString &sourcePath, const QString &destPath) {
+    QFile source(sourcePath);
+    if (!source.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    // 先写临时文件再改名，避免留下不完整的壁纸
+    QSaveFile dest(destPath);
+    if (!dest.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    bool cloned = false;
+#ifdef Q_OS_LINUX
+    // Btrfs/XFS 等支持 reflink 的文件系统上只复制元数据
+    cloned = ioctl(dest.handle(), FICLONE, source.handle()) == 0;
+#endif
+
+    if (!cloned) {
+        while (!source.atEnd()) {
+            QByteArray chunk = source.read(1024 * 1024);
+            if (chunk.isEmpty() || dest.write(chunk) != chunk.size()) {
+                dest.cancelWriting();
+                return false;
+            }
+        }
+    }
+
+    return dest.commit();
+}
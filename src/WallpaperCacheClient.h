@@ -0,0 +1,56 @@
+#ifndef WALLPAPERCACHECLIENT_H
+#define WALLPAPERCACHECLIENT_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QTimer>
+#include <QLocalSocket>
+
+/**
+ * @brief 共享缓存服务的客户端
+ *
+ * 向 WallpaperCacheDaemon 请求壁纸，拿到缓存文件后优先用 FICLONE 在同一文件系统上
+ * 做写时复制克隆，不占额外空间；跨文件系统时退回普通复制。
+ * 服务不存在、超时或出错时通过 finished(false) 通知调用方自行下载。
+ */
+class WallpaperCacheClient : public QObject {
+    Q_OBJECT
+
+public:
+    explicit WallpaperCacheClient(QObject *parent = nullptr);
+
+    /**
+     * @brief 套接字路径，可以用环境变量 BING_WALLPAPER_CACHE_SOCKET 覆盖
+     */
+    static QString defaultSocketPath();
+
+    bool isAvailable() const;
+
+    /**
+     * @brief 请求一张壁纸并复制到 destPath，完成后发出 finished
+     * @param date 壁纸日期，如 20240101
+     * @param market 市场，如 zh-CN
+     * @param imagePath 图片在 Bing 上的路径（/th?id=...）
+     * @param destPath 保存位置
+     */
+    void fetch(const QString &date, const QString &market, const QString &imagePath, const QString &destPath);
+    void cancel();
+
+signals:
+    void finished(bool success, const QString &error);
+
+private:
+    void onConnected();
+    void onReadyRead();
+    void fail(const QString &error);
+    static bool cloneFile(const QString &sourcePath, const QString &destPath);
+
+    QString m_socketPath;
+    QLocalSocket *m_socket;
+    QTimer m_timeoutTimer;
+    QByteArray m_request;
+    QString m_destPath;
+};
+
+#endif // WALLPAPERCACHECLIENT_H
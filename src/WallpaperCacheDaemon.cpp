@@ -0,0 +1,210 @@
+#include "WallpaperCacheDaemon.h"
+#include "Metrics.h"
+#include "JpegVerifier.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QCryptographicHash>
+#include <QNetworkRequest>
+#include <QDebug>
+#include <utility>
+
+namespace {
+
+const int MAX_REQUEST_LENGTH = 4096;
+
+}
+
+WallpaperCacheDaemon::WallpaperCacheDaemon(const QString &cacheDir, QObject *parent)
+    : QObject(parent)
+    , m_cacheDir(cacheDir)
+    , m_baseUrl("https://www.bing.com")
+    , m_server(new QLocalServer(this))
+    , m_networkManager(new QNetworkAccessManager(this))
+{
+    QString baseUrl = qEnvironmentVariable("BING_WALLPAPER_BASE_URL");
+    if (!baseUrl.isEmpty()) {
+        m_baseUrl = baseUrl;
+        while (m_baseUrl.endsWith('/')) {
+            m_baseUrl.chop(1);
+        }
+    }
+
+    // 缓存文件要能被所有用户读取
+    if (!QDir().mkpath(m_cacheDir)) {
+        qDebug() << "无法创建缓存目录:" << m_cacheDir;
+    }
+    QFile::setPermissions(m_cacheDir, QFileDevice::ReadOwner | QFileDevice::WriteOwner | QFileDevice::ExeOwner
+                                      | QFileDevice::ReadGroup | QFileDevice::ExeGroup
+                                      | QFileDevice::ReadOther | QFileDevice::ExeOther);
+
+    connect(m_server, &QLocalServer::newConnection, this, &WallpaperCacheDaemon::onNewConnection);
+}
+
+QString WallpaperCacheDaemon::defaultCacheDir() {
+    // 不能放在服务用户的 ~/.cache 下：家目录通常不允许其他用户进入，客户端会全部回退到直接下载
+    return "/var/cache/bing-wallpaper";
+}
+
+bool WallpaperCacheDaemon::listen(const QString &socketPath) {
+    QDir().mkpath(QFileInfo(socketPath).absolutePath());
+    m_server->setSocketOptions(QLocalServer::WorldAccessOption);
+
+    if (!m_server->listen(socketPath)) {
+        // 能连上说明已有服务在运行，否则是上次异常退出留下的套接字文件
+        QLocalSocket probe;
+        probe.connectToServer(socketPath);
+        if (probe.waitForConnected(1000)) {
+            qDebug() << "共享缓存服务已在运行:" << socketPath;
+            return false;
+        }
+        QLocalServer::removeServer(socketPath);
+        if (!m_server->listen(socketPath)) {
+            qDebug() << "监听失败:" << socketPath << m_server->errorString();
+            return false;
+        }
+    }
+
+    qDebug() << "共享缓存服务已启动:" << socketPath << "缓存目录:" << m_cacheDir;
+    cleanupCache();
+    return true;
+}
+
+void WallpaperCacheDaemon::onNewConnection() {
+    while (QLocalSocket *client = m_server->nextPendingConnection()) {
+        connect(client, &QLocalSocket::readyRead, this, [this, client]() {
+            onClientReadyRead(client);
+        });
+        connect(client, &QLocalSocket::disconnected, client, &QObject::deleteLater);
+    }
+}
+
+void WallpaperCacheDaemon::onClientReadyRead(QLocalSocket *client) {
+    while (client->canReadLine()) {
+        handleRequest(client, client->readLine().trimmed());
+    }
+    // 一直不换行的客户端直接断开
+    if (client->bytesAvailable() > MAX_REQUEST_LENGTH) {
+        client->disconnectFromServer();
+    }
+}
+
+void WallpaperCacheDaemon::handleRequest(QLocalSocket *client, const QByteArray &line) {
+    QJsonObject request = QJsonDocument::fromJson(line).object();
+    QString date = request["date"].toString();
+    QString market = request["market"].toString();
+    QString imagePath = request["path"].toString();
+
+    // 只代理 Bing 的图片地址，防止被用来下载任意内容
+    static const QRegularExpression datePattern("\\A\\d{8}\\z");
+    static const QRegularExpression marketPattern("\\A[A-Za-z]{2}-[A-Za-z]{2}\\z");
+    if (!datePattern.match(date).hasMatch()
+        || !marketPattern.match(market).hasMatch()
+        || !imagePath.startsWith("/th?id=") || imagePath.size() > 512 || imagePath.contains(' ')) {
+        sendReply(client, false, "无效的请求");
+        return;
+    }
+
+    QString hash = QCryptographicHash::hash(imagePath.toUtf8(), QCryptographicHash::Sha1).toHex().left(12);
+    QString cacheFile = QString("%1_%2_%3.jpg").arg(date, market, hash);
+    QString cachePath = m_cacheDir + "/" + cacheFile;
+
+    if (QFile::exists(cachePath)) {
+        Metrics::instance()->incrementCounter("bing_wallpaper_cache_requests_total{result=\"hit\"}");
+        sendReply(client, true, cachePath);
+        return;
+    }
+
+    auto it = m_waiting.find(cacheFile);
+    if (it != m_waiting.end()) {
+        // 同一张图片正在下载，等待下载完成
+        Metrics::instance()->incrementCounter("bing_wallpaper_cache_requests_total{result=\"collapsed\"}");
+        it.value().append(client);
+        return;
+    }
+
+    Metrics::instance()->incrementCounter("bing_wallpaper_cache_requests_total{result=\"miss\"}");
+    m_waiting.insert(cacheFile, {client});
+    startFetch(cacheFile, imagePath);
+}
+
+void WallpaperCacheDaemon::startFetch(const QString &cacheFile, const QString &imagePath) {
+    qDebug() << "从上游下载:" << imagePath;
+    QNetworkRequest request(QUrl(m_baseUrl + imagePath));
+    request.setHeader(QNetworkRequest::UserAgentHeader, "Mozilla/5.0");
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+
+    QNetworkReply *reply = m_networkManager->get(request);
+    connect(reply, &QNetworkReply::finished, this, [this, reply, cacheFile]() {
+        onFetchFinished(reply, cacheFile);
+    });
+    Metrics::instance()->incrementCounter("bing_wallpaper_cache_upstream_fetches_total");
+}
+
+void WallpaperCacheDaemon::onFetchFinished(QNetworkReply *reply, const QString &cacheFile) {
+    reply->deleteLater();
+    QList<QPointer<QLocalSocket>> clients = m_waiting.take(cacheFile);
+    QString cachePath = m_cacheDir + "/" + cacheFile;
+
+    QString error;
+    if (reply->error() != QNetworkReply::NoError) {
+        error = "上游下载失败: " + reply->errorString();
+    } else {
+        QByteArray data = reply->readAll();
+        // 出错时服务器可能返回 HTML 页面或被截断的图片，不能缓存下来分发给所有用户
+        JpegVerifier::Status status = JpegVerifier::verify(reinterpret_cast<const uint8_t *>(data.constData()),
+                                                           static_cast<size_t>(data.size()));
+        if (status != JpegVerifier::Status::Ok) {
+            error = QString("上游返回的不是完整的JPEG图片（%1）").arg(JpegVerifier::statusName(status));
+        } else {
+            QSaveFile file(cachePath);
+            if (!file.open(QIODevice::WriteOnly)) {
+                error = "写入缓存失败";
+            } else {
+                file.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner
+                                    | QFileDevice::ReadGroup | QFileDevice::ReadOther);
+                file.write(data);
+                if (!file.commit()) {
+                    error = "写入缓存失败";
+                }
+            }
+        }
+    }
+
+    if (!error.isEmpty()) {
+        qDebug() << error << cacheFile;
+    }
+    for (const QPointer<QLocalSocket> &client : std::as_const(clients)) {
+        if (client) {
+            sendReply(client, error.isEmpty(), error.isEmpty() ? cachePath : error);
+        }
+    }
+
+    if (error.isEmpty()) {
+        cleanupCache();
+    }
+}
+
+void WallpaperCacheDaemon::sendReply(QLocalSocket *client, bool success, const QString &pathOrError) {
+    QJsonObject reply;
+    reply["ok"] = success;
+    reply[success ? "path" : "error"] = pathOrError;
+    client->write(QJsonDocument(reply).toJson(QJsonDocument::Compact) + "\n");
+}
+
+void WallpaperCacheDaemon::cleanupCache(int keepDays) {
+    QDateTime cutoff = QDateTime::currentDateTime().addDays(-keepDays);
+    QDir dir(m_cacheDir);
+    const QFileInfoList files = dir.entryInfoList(QStringList() << "*.jpg", QDir::Files);
+    for (const QFileInfo &info : files) {
+        if (info.lastModified() < cutoff) {
+            QFile::remove(info.absoluteFilePath());
+            qDebug() << "已删除过期缓存:" << info.fileName();
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef WALLPAPERCACHEDAEMON_H
+#define WALLPAPERCACHEDAEMON_H
+
+#include <QObject>
+#include <QString>
+#include <QHash>
+#include <QList>
+#include <QPointer>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+
+/**
+ * @brief 多用户共享的壁纸缓存服务（--cache-daemon）
+ *
+ * 在多用户终端服务器上，每个会话都运行自己的壁纸设置器，各自下载同一张 4K 图片。
+ * 该服务监听本地套接字，客户端按“日期 + 市场 + 图片路径”请求壁纸，
+ * 缓存中没有时只向上游发起一次下载，同时到达的相同请求等待同一次下载完成。
+ * 应答中返回缓存文件路径，由客户端自行克隆（reflink）或复制到自己的目录。
+ *
+ * 协议为每行一个 JSON 对象：
+ *   请求 {"date":"20240101","market":"zh-CN","path":"/th?id=OHR.xxx_UHD.jpg"}
+ *   应答 {"ok":true,"path":"/var/cache/..."} 或 {"ok":false,"error":"..."}
+ */
+class WallpaperCacheDaemon : public QObject {
+    Q_OBJECT
+
+public:
+    explicit WallpaperCacheDaemon(const QString &cacheDir, QObject *parent = nullptr);
+
+    /**
+     * @brief 开始监听，所有用户都可以连接
+     * @param socketPath 套接字路径，残留的旧套接字文件会被清理
+     */
+    bool listen(const QString &socketPath);
+
+    /**
+     * @brief 默认缓存目录，位于系统目录下，所有用户都能访问其中的文件
+     */
+    static QString defaultCacheDir();
+
+private slots:
+    void onNewConnection();
+
+private:
+    void onClientReadyRead(QLocalSocket *client);
+    void handleRequest(QLocalSocket *client, const QByteArray &line);
+    void startFetch(const QString &cacheFile, const QString &imagePath);
+    void onFetchFinished(QNetworkReply *reply, const QString &cacheFile);
+    void sendReply(QLocalSocket *client, bool success, const QString &pathOrError);
+    void cleanupCache(int keepDays = 30);
+
+    QString m_cacheDir;
+    QString m_baseUrl;
+    QLocalServer *m_server;
+    QNetworkAccessManager *m_networkManager;
+    // 缓存文件名 -> 等待该文件的客户端，非空表示正在下载
+    QHash<QString, QList<QPointer<QLocalSocket>>> m_waiting;
+};
+
+#endif // WALLPAPERCACHEDAEMON_H
@@ -0,0 +1,69 @@
+#include "WallpaperCommands.h"
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+
+QList<WallpaperCommands::GSetting> WallpaperCommands::gnome(const QString &pictureFile, bool spanned,
+                                                            const QString &darkFile, const QStringList &palette) {
+    QList<GSetting> settings;
+    settings.append({"picture-uri", "file://" + pictureFile, true});
+    settings.append(gnomeAppearance(darkFile, palette));
+    // 缩放，或按 spanned 铺满整个桌面布局，每块显示器正好对应其中一块
+    settings.append({"picture-options", spanned ? "spanned" : "zoom", false});
+    return settings;
+}
+
+QList<WallpaperCommands::GSetting> WallpaperCommands::gnomeAppearance(const QString &darkFile,
+                                                                      const QStringList &palette) {
+    QList<GSetting> settings;
+    settings.append({"picture-uri-dark", "file://" + darkFile, false});
+    // 图片加载前和未覆盖区域显示的背景色使用主色调
+    if (!palette.isEmpty()) {
+        settings.append({"primary-color", palette.first(), false});
+        settings.append({"secondary-color", palette.value(1, palette.first()), false});
+    }
+    return settings;
+}
+
+QList<WallpaperCommands::GSetting> WallpaperCommands::ukui(const QString &pictureFile, bool spanned) {
+    QList<GSetting> settings;
+    settings.append({"picture-filename", pictureFile, true});
+    settings.append({"picture-options", spanned ? "spanned" : "zoom", false});
+    return settings;
+}
+
+QStringList WallpaperCommands::gsettingsArguments(const QString &schema, const GSetting &setting) {
+    return QStringList() << "set" << schema << setting.key << setting.value;
+}
+
+QString WallpaperCommands::plasmaScript(const QString &fallbackFile, const QMap<QString, QString> &filesByOrigin) {
+    QJsonObject images;
+    for (auto it = filesByOrigin.constBegin(); it != filesByOrigin.constEnd(); ++it) {
+        images[it.key()] = "file://" + it.value();
+    }
+    // 路径经 JSON 转义后嵌入脚本；Plasma 的屏幕编号与 Qt 的顺序不一定相同，按屏幕左上角坐标对应
+    QString imagesJson = QString::fromUtf8(QJsonDocument(images).toJson(QJsonDocument::Compact));
+    QString fallbackJson = QString::fromUtf8(QJsonDocument(QJsonArray{"file://" + fallbackFile})
+                                             .toJson(QJsonDocument::Compact));
+    return QString(R"(
+var images = %1;
+var fallback = %2[0];
+var allDesktops = desktops();
+for (i=0; i<allDesktops.length; i++) {
+    d = allDesktops[i];
+    var image = fallback;
+    if (d.screen >= 0) {
+        var geometry = screenGeometry(d.screen);
+        image = images[geometry.x + "," + geometry.y] || fallback;
+    }
+    d.wallpaperPlugin = "org.kde.image";
+    d.currentConfigGroup = Array("Wallpaper", "org.kde.image", "General");
+    d.writeConfig("Image", image);
+}
+)").arg(imagesJson, fallbackJson);
+}
+
+QStringList WallpaperCommands::qdbusArguments(const QString &script) {
+    return QStringList() << PLASMA_SERVICE << PLASMA_PATH
+                         << QString("%1.%2").arg(PLASMA_INTERFACE, PLASMA_METHOD) << script;
+}
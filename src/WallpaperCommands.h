@@ -0,0 +1,61 @@
+#ifndef WALLPAPERCOMMANDS_H
+#define WALLPAPERCOMMANDS_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QMap>
+
+/**
+ * @brief 各桌面环境设置壁纸时写入的配置项和执行的脚本
+ *
+ * BingWallpaperSetter 和壁纸设置延迟基准测试（bench_apply_latency）都从这里取得命令序列，
+ * 调整某个后端的设置方式后，基准测试测量的仍是程序实际执行的内容。
+ */
+class WallpaperCommands {
+public:
+    struct GSetting {
+        QString key;
+        QString value;
+        bool required;      // 失败时整个设置失败；其余的键旧版 schema 中可能没有
+    };
+
+    static constexpr const char *GNOME_SCHEMA = "org.gnome.desktop.background";
+    static constexpr const char *UKUI_SCHEMA = "org.mate.background";
+
+    static constexpr const char *PLASMA_SERVICE = "org.kde.plasmashell";
+    static constexpr const char *PLASMA_PATH = "/PlasmaShell";
+    static constexpr const char *PLASMA_INTERFACE = "org.kde.PlasmaShell";
+    static constexpr const char *PLASMA_METHOD = "evaluateScript";
+
+    /**
+     * @brief GNOME 壁纸，按写入顺序排列
+     * @param spanned 图片是覆盖整个桌面布局的跨屏合成图
+     * @param darkFile 暗色模式使用的图片
+     * @param palette 主色调，为空时不设置背景色
+     */
+    static QList<GSetting> gnome(const QString &pictureFile, bool spanned,
+                                 const QString &darkFile, const QStringList &palette);
+
+    /**
+     * @brief 只更新暗色模式图片和背景色，分析完成后单独调用
+     */
+    static QList<GSetting> gnomeAppearance(const QString &darkFile, const QStringList &palette);
+
+    static QList<GSetting> ukui(const QString &pictureFile, bool spanned);
+
+    static QStringList gsettingsArguments(const QString &schema, const GSetting &setting);
+
+    /**
+     * @brief 为每个桌面容器设置壁纸的 plasmashell 脚本
+     * @param filesByOrigin 屏幕左上角坐标 "x,y" -> 图片，其余屏幕使用 fallbackFile
+     */
+    static QString plasmaScript(const QString &fallbackFile, const QMap<QString, QString> &filesByOrigin);
+
+    /**
+     * @brief 通过 qdbus 执行脚本的参数
+     */
+    static QStringList qdbusArguments(const QString &script);
+};
+
+#endif // WALLPAPERCOMMANDS_H
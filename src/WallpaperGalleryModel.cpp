@@ -0,0 +1,160 @@
+#include "WallpaperGalleryModel.h"
+#include <QSet>
+#include <QColor>
+#include <algorithm>
+#include <utility>
+
+WallpaperGalleryModel::WallpaperGalleryModel(WallpaperLibrary *library, ThumbnailCache *cache, QObject *parent)
+    : QAbstractListModel(parent)
+    , m_library(library)
+    , m_cache(cache)
+    , m_placeholder(cache->thumbnailSize())
+    , m_visibleFirst(-1)
+    , m_visibleLast(-1)
+{
+    m_placeholder.fill(QColor("#e9ecef"));
+
+    connect(m_library, &WallpaperLibrary::entriesChanged, this, &WallpaperGalleryModel::onEntriesChanged);
+    connect(m_cache, &ThumbnailCache::thumbnailReady, this, &WallpaperGalleryModel::onThumbnailReady);
+    reload();
+}
+
+void WallpaperGalleryModel::reload() {
+    beginResetModel();
+    m_entries = m_library->entries();
+    std::reverse(m_entries.begin(), m_entries.end());
+    m_rowForPath.clear();
+    updateRowsFrom(0);
+    endResetModel();
+
+    QStringList paths;
+    paths.reserve(m_entries.size());
+    for (const WallpaperInfo &info : std::as_const(m_entries)) {
+        paths.append(info.filePath);
+    }
+    m_cache->pruneDiskCache(paths);
+}
+
+void WallpaperGalleryModel::updateRowsFrom(int row) {
+    for (int i = row; i < m_entries.size(); ++i) {
+        m_rowForPath.insert(m_entries[i].filePath, i);
+    }
+}
+
+void WallpaperGalleryModel::onEntriesChanged(const QStringList &filePaths) {
+    // 分析、预取和校验只更新元数据，对应的行原地刷新，缩略图不必重新加载
+    for (const QString &filePath : filePaths) {
+        auto it = m_rowForPath.constFind(filePath);
+        bool present = m_library->contains(filePath);
+        WallpaperInfo info = present ? m_library->entry(filePath) : WallpaperInfo();
+
+        if (it != m_rowForPath.constEnd()) {
+            int row = it.value();
+            if (present && m_entries[row].date == info.date) {
+                m_entries[row] = info;
+                QModelIndex idx = index(row);
+                emit dataChanged(idx, idx);
+                continue;
+            }
+            // 已删除，或日期变化需要移到新的位置
+            removeEntryAt(row);
+            if (!present) {
+                m_cache->remove(filePath);
+            }
+        }
+        if (present) {
+            insertEntry(info);
+        }
+    }
+}
+
+void WallpaperGalleryModel::removeEntryAt(int row) {
+    beginRemoveRows(QModelIndex(), row, row);
+    m_rowForPath.remove(m_entries[row].filePath);
+    m_entries.remove(row);
+    updateRowsFrom(row);
+    endRemoveRows();
+}
+
+void WallpaperGalleryModel::insertEntry(const WallpaperInfo &info) {
+    // 与壁纸库的顺序相反：日期新的在前，同一天后添加的在前
+    auto position = std::lower_bound(m_entries.cbegin(), m_entries.cend(), info.date,
+                                     [](const WallpaperInfo &entry, const QString &date) {
+        return entry.date > date;
+    });
+    int row = int(position - m_entries.cbegin());
+    beginInsertRows(QModelIndex(), row, row);
+    m_entries.insert(row, info);
+    updateRowsFrom(row);
+    endInsertRows();
+}
+
+int WallpaperGalleryModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : m_entries.size();
+}
+
+QVariant WallpaperGalleryModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() >= m_entries.size()) {
+        return QVariant();
+    }
+
+    const WallpaperInfo &info = m_entries[index.row()];
+
+    switch (role) {
+    case Qt::DisplayRole: {
+        QString date = info.date.size() == 8
+                     ? info.date.left(4) + "-" + info.date.mid(4, 2) + "-" + info.date.mid(6, 2)
+                     : info.date;
+        return date;
+    }
+    case Qt::DecorationRole: {
+        QPixmap pixmap = m_cache->thumbnail(info.filePath);
+        if (!pixmap.isNull()) {
+            return pixmap;
+        }
+        // 只为可见行发起请求，滚动过快时不会积压大量解码任务
+        if (isInVisibleRange(index.row())) {
+            m_cache->request(info.filePath);
+        }
+        return m_placeholder;
+    }
+    case Qt::ToolTipRole:
+        return info.title.isEmpty() ? info.location : info.title + "\n" + info.copyright;
+    case FilePathRole:
+        return info.filePath;
+    default:
+        return QVariant();
+    }
+}
+
+bool WallpaperGalleryModel::isInVisibleRange(int row) const {
+    return m_visibleFirst < 0 || (row >= m_visibleFirst && row <= m_visibleLast);
+}
+
+void WallpaperGalleryModel::setVisibleRange(int first, int last) {
+    first = qBound(0, first, qMax(0, int(m_entries.size()) - 1));
+    last = qBound(first, last, qMax(0, int(m_entries.size()) - 1));
+    if (first == m_visibleFirst && last == m_visibleLast) {
+        return;
+    }
+    m_visibleFirst = first;
+    m_visibleLast = last;
+
+    QSet<QString> visiblePaths;
+    for (int row = first; row <= last && row < m_entries.size(); ++row) {
+        visiblePaths.insert(m_entries[row].filePath);
+    }
+    m_cache->cancelAllExcept(visiblePaths);
+
+    // 保留两屏的缩略图，来回小幅滚动时不必重新加载
+    m_cache->setCapacity(2 * (last - first + 1));
+}
+
+void WallpaperGalleryModel::onThumbnailReady(const QString &imagePath) {
+    auto it = m_rowForPath.constFind(imagePath);
+    if (it == m_rowForPath.constEnd()) {
+        return;
+    }
+    QModelIndex idx = index(it.value());
+    emit dataChanged(idx, idx, {Qt::DecorationRole});
+}
@@ -0,0 +1,58 @@
+#ifndef WALLPAPERGALLERYMODEL_H
+#define WALLPAPERGALLERYMODEL_H
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QPixmap>
+#include <QVector>
+#include "WallpaperLibrary.h"
+#include "ThumbnailCache.h"
+
+/**
+ * @brief 壁纸库画廊的数据模型
+ *
+ * 只为视图可见范围内的行请求缩略图，范围变化时取消范围外的请求，
+ * 内存中的缩略图数量随可见范围而不是壁纸库大小变化。
+ * 壁纸库的增删改按行通知视图，滚动位置、选中项和已加载的缩略图都保留。
+ */
+class WallpaperGalleryModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    enum Roles {
+        FilePathRole = Qt::UserRole
+    };
+
+    WallpaperGalleryModel(WallpaperLibrary *library, ThumbnailCache *cache, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    /**
+     * @brief 设置视图当前可见的行范围
+     * @param first 第一行
+     * @param last 最后一行（含）
+     */
+    void setVisibleRange(int first, int last);
+
+private slots:
+    void onEntriesChanged(const QStringList &filePaths);
+    void onThumbnailReady(const QString &imagePath);
+
+private:
+    void reload();
+    void removeEntryAt(int row);
+    void insertEntry(const WallpaperInfo &info);
+    void updateRowsFrom(int row);
+    bool isInVisibleRange(int row) const;
+
+    WallpaperLibrary *m_library;
+    ThumbnailCache *m_cache;
+    QVector<WallpaperInfo> m_entries;   // 日期新的在前
+    QHash<QString, int> m_rowForPath;
+    QPixmap m_placeholder;
+    int m_visibleFirst;
+    int m_visibleLast;
+};
+
+#endif // WALLPAPERGALLERYMODEL_H
@@ -0,0 +1,59 @@
+#include "WallpaperGalleryView.h"
+#include "WallpaperGalleryModel.h"
+#include <QScrollBar>
+#include <QResizeEvent>
+
+WallpaperGalleryView::WallpaperGalleryView(const QSize &thumbnailSize, QWidget *parent)
+    : QListView(parent)
+    , m_galleryModel(nullptr)
+{
+    setViewMode(QListView::IconMode);
+    setMovement(QListView::Static);
+    setResizeMode(QListView::Adjust);
+    setUniformItemSizes(true);
+    setLayoutMode(QListView::Batched);
+    setBatchSize(500);
+    setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
+    setSelectionMode(QAbstractItemView::SingleSelection);
+    setIconSize(thumbnailSize);
+    setGridSize(thumbnailSize + QSize(16, 32));
+
+    // 合并同一帧内的多次滚动/缩放，只计算一次可见范围
+    m_rangeTimer.setSingleShot(true);
+    m_rangeTimer.setInterval(0);
+    connect(&m_rangeTimer, &QTimer::timeout, this, &WallpaperGalleryView::updateVisibleRange);
+}
+
+void WallpaperGalleryView::setGalleryModel(WallpaperGalleryModel *model) {
+    m_galleryModel = model;
+    setModel(model);
+    connect(model, &QAbstractItemModel::modelReset, &m_rangeTimer, QOverload<>::of(&QTimer::start));
+    // 插入或删除行后可见范围内的行号会移动
+    connect(model, &QAbstractItemModel::rowsInserted, &m_rangeTimer, QOverload<>::of(&QTimer::start));
+    connect(model, &QAbstractItemModel::rowsRemoved, &m_rangeTimer, QOverload<>::of(&QTimer::start));
+    m_rangeTimer.start();
+}
+
+void WallpaperGalleryView::resizeEvent(QResizeEvent *event) {
+    QListView::resizeEvent(event);
+    m_rangeTimer.start();
+}
+
+void WallpaperGalleryView::scrollContentsBy(int dx, int dy) {
+    QListView::scrollContentsBy(dx, dy);
+    m_rangeTimer.start();
+}
+
+void WallpaperGalleryView::updateVisibleRange() {
+    if (!m_galleryModel || m_galleryModel->rowCount() == 0) {
+        return;
+    }
+
+    const QSize grid = gridSize();
+    const int columns = qMax(1, viewport()->width() / grid.width());
+    const int firstLine = verticalScrollBar()->value() / grid.height();
+    const int visibleLines = viewport()->height() / grid.height() + 2;
+
+    m_galleryModel->setVisibleRange(firstLine * columns, (firstLine + visibleLines) * columns - 1);
+    viewport()->update();
+}
@@ -0,0 +1,35 @@
+#ifndef WALLPAPERGALLERYVIEW_H
+#define WALLPAPERGALLERYVIEW_H
+
+#include <QListView>
+#include <QTimer>
+
+class WallpaperGalleryModel;
+
+/**
+ * @brief 壁纸缩略图网格视图
+ *
+ * 所有项尺寸一致，可见范围直接由滚动位置和网格大小算出，
+ * 不需要逐项计算布局，几万张壁纸也能流畅滚动。
+ */
+class WallpaperGalleryView : public QListView {
+    Q_OBJECT
+
+public:
+    explicit WallpaperGalleryView(const QSize &thumbnailSize, QWidget *parent = nullptr);
+
+    void setGalleryModel(WallpaperGalleryModel *model);
+
+protected:
+    void resizeEvent(QResizeEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+
+private slots:
+    void updateVisibleRange();
+
+private:
+    WallpaperGalleryModel *m_galleryModel;
+    QTimer m_rangeTimer;
+};
+
+#endif // WALLPAPERGALLERYVIEW_H
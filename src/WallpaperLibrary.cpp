@@ -0,0 +1,320 @@
+#include "WallpaperLibrary.h"
+#include <QStandardPaths>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QCoreApplication>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QRegularExpression>
+#include <QSet>
+#include <QDebug>
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+// 连续下载、分析多张壁纸时合并成一次写入
+const int SAVE_DELAY_MS = 500;
+
+bool earlierDate(const WallpaperInfo &a, const WallpaperInfo &b) {
+    return a.date < b.date;
+}
+
+}
+
+QJsonObject WallpaperInfo::toJson() const {
+    QJsonObject obj;
+    obj["file"] = filePath;
+    obj["date"] = date;
+    obj["title"] = title;
+    obj["copyright"] = copyright;
+    obj["location"] = location;
+    obj["market"] = market;
+    obj["url"] = imageUrl;
+    if (isAnalyzed()) {
+        QJsonObject analysis;
+        analysis["luminance"] = luminance;
+        analysis["busyness"] = busyness;
+        analysis["palette"] = QJsonArray::fromStringList(palette);
+        analysis["dark"] = darkVariantPath;
+        obj["analysis"] = analysis;
+    }
+    return obj;
+}
+
+WallpaperInfo WallpaperInfo::fromJson(const QJsonObject &obj) {
+    WallpaperInfo info;
+    info.filePath = obj["file"].toString();
+    info.date = obj["date"].toString();
+    info.title = obj["title"].toString();
+    info.copyright = obj["copyright"].toString();
+    info.location = obj["location"].toString();
+    info.market = obj["market"].toString();
+    info.imageUrl = obj["url"].toString();
+    if (obj.contains("analysis")) {
+        QJsonObject analysis = obj["analysis"].toObject();
+        info.luminance = analysis["luminance"].toDouble(-1.0);
+        info.busyness = analysis["busyness"].toDouble(-1.0);
+        for (const QJsonValue &color : analysis["palette"].toArray()) {
+            info.palette.append(color.toString());
+        }
+        info.darkVariantPath = analysis["dark"].toString();
+    }
+    return info;
+}
+
+QString WallpaperInfo::locationFromCopyright(const QString &copyright) {
+    // 例如 "布莱斯峡谷国家公园，美国犹他州 (© Getty Images)"
+    return copyright.section('(', 0, 0).trimmed();
+}
+
+WallpaperLibrary::WallpaperLibrary(QObject *parent)
+    : QObject(parent)
+    , m_nextDocId(0)
+    , m_savePending(false)
+{
+    m_writer.setMaxThreadCount(1);
+    m_saveTimer.setSingleShot(true);
+    m_saveTimer.setInterval(SAVE_DELAY_MS);
+    connect(&m_saveTimer, &QTimer::timeout, this, &WallpaperLibrary::startSave);
+    if (QCoreApplication::instance()) {
+        connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, &WallpaperLibrary::flush);
+    }
+
+    load();
+}
+
+WallpaperLibrary::~WallpaperLibrary() {
+    flush();
+}
+
+QString WallpaperLibrary::libraryFilePath() const {
+    QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dataDir);
+    return dataDir + "/library.json";
+}
+
+QString WallpaperLibrary::searchText(const WallpaperInfo &info) {
+    return info.title + ' ' + info.copyright + ' ' + info.location;
+}
+
+void WallpaperLibrary::load() {
+    QFile file(libraryFilePath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+    if (!doc.isArray()) {
+        qDebug() << "壁纸库文件格式错误:" << file.fileName();
+        return;
+    }
+
+    QSet<QString> seen;
+    for (const QJsonValue &value : doc.array()) {
+        WallpaperInfo info = WallpaperInfo::fromJson(value.toObject());
+        if (!info.filePath.isEmpty() && !seen.contains(info.filePath)) {
+            seen.insert(info.filePath);
+            m_entries.append(info);
+        }
+    }
+    // 文件按日期顺序保存，手工编辑过时也能恢复顺序
+    std::stable_sort(m_entries.begin(), m_entries.end(), earlierDate);
+
+    for (int i = 0; i < m_entries.size(); ++i) {
+        m_entryDocIds.append(m_nextDocId);
+        m_searchIndex.addDocument(m_nextDocId++, searchText(m_entries[i]));
+    }
+    m_docPositions.fill(-1, m_nextDocId);
+    updatePositionsFrom(0);
+
+    qDebug() << "已加载壁纸库:" << m_entries.size() << "条记录";
+}
+
+void WallpaperLibrary::startSave() {
+    if (!m_savePending) {
+        return;
+    }
+    m_savePending = false;
+
+    // 条目是隐式共享的，复制只增加引用计数；序列化和写盘都在后台线程完成
+    QVector<WallpaperInfo> entries = m_entries;
+    QString path = libraryFilePath();
+    m_writer.start([entries, path]() {
+        QJsonArray array;
+        for (const WallpaperInfo &info : entries) {
+            array.append(info.toJson());
+        }
+
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly)) {
+            qDebug() << "保存壁纸库失败:" << path;
+            return;
+        }
+        file.write(QJsonDocument(array).toJson(QJsonDocument::Compact));
+        file.commit();
+    });
+}
+
+void WallpaperLibrary::flush() {
+    m_saveTimer.stop();
+    startSave();
+    m_writer.waitForDone();
+}
+
+void WallpaperLibrary::updatePositionsFrom(int position) {
+    for (int i = position; i < m_entries.size(); ++i) {
+        m_pathIndex.insert(m_entries[i].filePath, i);
+        m_docPositions[m_entryDocIds[i]] = i;
+    }
+}
+
+void WallpaperLibrary::insertSorted(const WallpaperInfo &info, int docId) {
+    // 同一天的记录保持添加顺序；新壁纸通常日期最新，插在末尾，不需要移动其他记录
+    int position = int(std::upper_bound(m_entries.cbegin(), m_entries.cend(), info, earlierDate) - m_entries.cbegin());
+    m_entries.insert(position, info);
+    m_entryDocIds.insert(position, docId);
+    if (docId >= m_docPositions.size()) {
+        m_docPositions.resize(docId + 1);
+    }
+    updatePositionsFrom(position);
+}
+
+void WallpaperLibrary::removeAt(int position) {
+    m_pathIndex.remove(m_entries[position].filePath);
+    m_docPositions[m_entryDocIds[position]] = -1;
+    m_entries.remove(position);
+    m_entryDocIds.remove(position);
+    updatePositionsFrom(position);
+}
+
+void WallpaperLibrary::addOrUpdate(const WallpaperInfo &info) {
+    int docId;
+    auto it = m_pathIndex.constFind(info.filePath);
+    if (it != m_pathIndex.constEnd() && m_entries[it.value()].date == info.date) {
+        docId = m_entryDocIds[it.value()];
+        m_entries[it.value()] = info;
+    } else if (it != m_pathIndex.constEnd()) {
+        // 日期变化时移到新的位置
+        docId = m_entryDocIds[it.value()];
+        removeAt(it.value());
+        insertSorted(info, docId);
+    } else {
+        docId = m_nextDocId++;
+        insertSorted(info, docId);
+    }
+    m_searchIndex.addDocument(docId, searchText(info));
+
+    commitChanges(QStringList() << info.filePath);
+}
+
+void WallpaperLibrary::remove(const QString &filePath) {
+    auto it = m_pathIndex.constFind(filePath);
+    if (it == m_pathIndex.constEnd()) {
+        return;
+    }
+    int docId = m_entryDocIds[it.value()];
+    removeAt(it.value());
+    m_searchIndex.removeDocument(docId);
+    commitChanges(QStringList() << filePath);
+}
+
+void WallpaperLibrary::importDirectory(const QString &directory) {
+    // 补录没有元数据的旧壁纸，文件名格式为 bing_wallpaper_<日期>_<地点>.jpg
+    static const QRegularExpression pattern("^bing_wallpaper_(\\d{8})_?(.*)\\.jpg$");
+
+    QDir dir(directory);
+    QFileInfoList fileList = dir.entryInfoList(QStringList() << "bing_wallpaper_*.jpg", QDir::Files);
+
+    QStringList added;
+    for (const QFileInfo &fileInfo : fileList) {
+        QString path = fileInfo.absoluteFilePath();
+        if (m_pathIndex.contains(path)) {
+            continue;
+        }
+
+        QRegularExpressionMatch match = pattern.match(fileInfo.fileName());
+        if (!match.hasMatch()) {
+            continue;
+        }
+
+        WallpaperInfo info;
+        info.filePath = path;
+        info.date = match.captured(1);
+        info.location = match.captured(2).replace('_', QChar(0xFF0C));
+        int docId = m_nextDocId++;
+        insertSorted(info, docId);
+        m_searchIndex.addDocument(docId, searchText(info));
+        added.append(path);
+    }
+
+    if (added.isEmpty()) {
+        return;
+    }
+
+    commitChanges(added);
+}
+
+void WallpaperLibrary::commitChanges(const QStringList &changedPaths) {
+    m_savePending = true;
+    m_saveTimer.start();
+    emit entriesChanged(changedPaths);
+    emit libraryChanged();
+}
+bool WallpaperLibrary::contains(const QString &filePath) const {
+    return m_pathIndex.contains(filePath);
+}
+
+WallpaperInfo WallpaperLibrary::entry(const QString &filePath) const {
+    auto it = m_pathIndex.constFind(filePath);
+    if (it == m_pathIndex.constEnd()) {
+        return WallpaperInfo();
+    }
+    return m_entries[it.value()];
+}
+
+WallpaperInfo WallpaperLibrary::findByDate(const QString &date, const QString &market) const {
+    // 条目按日期排序，从新到旧查找
+    for (int i = m_entries.size() - 1; i >= 0; --i) {
+        const WallpaperInfo &info = m_entries[i];
+        if (info.date < date) {
+            break;
+        }
+        if (info.date == date && (info.market.isEmpty() || info.market == market)) {
+            return info;
+        }
+    }
+    return WallpaperInfo();
+}
+
+QVector<WallpaperInfo> WallpaperLibrary::entries() const {
+    return m_entries;
+}
+
+int WallpaperLibrary::count() const {
+    return m_entries.size();
+}
+
+QVector<WallpaperInfo> WallpaperLibrary::search(const QString &query, int limit) const {
+    const QVector<int> docIds = m_searchIndex.search(query);
+
+    // 命中的记录在日期顺序中打上标记，再从最新的一端取前 limit 条，不必对结果排序
+    std::vector<char> hits(static_cast<size_t>(m_entries.size()), 0);
+    for (int docId : docIds) {
+        hits[static_cast<size_t>(m_docPositions[docId])] = 1;
+    }
+
+    QVector<WallpaperInfo> results;
+    for (int i = m_entries.size() - 1; i >= 0; --i) {
+        if (!hits[static_cast<size_t>(i)]) {
+            continue;
+        }
+        results.append(m_entries[i]);
+        if (limit > 0 && results.size() >= limit) {
+            break;
+        }
+    }
+    return results;
+}
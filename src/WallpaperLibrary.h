@@ -0,0 +1,109 @@
+#ifndef WALLPAPERLIBRARY_H
+#define WALLPAPERLIBRARY_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QJsonObject>
+#include <QStringList>
+#include <QTimer>
+#include <QThreadPool>
+#include "SearchIndex.h"
+
+/**
+ * @brief 单张壁纸的元数据（来自Bing API）
+ */
+struct WallpaperInfo {
+    QString filePath;
+    QString date;        // startdate，格式 yyyyMMdd
+    QString title;
+    QString copyright;   // 完整版权文本
+    QString location;    // 版权文本中括号前的地点描述
+    QString market;
+    QString imageUrl;
+
+    // 下载时的图像分析结果，luminance < 0 表示尚未分析
+    double luminance = -1.0;
+    double busyness = -1.0;
+    QStringList palette;        // 主色调 #rrggbb，按占比从高到低
+    QString darkVariantPath;    // 暗色主题使用的图片
+
+    bool isAnalyzed() const { return luminance >= 0.0; }
+    QJsonObject toJson() const;
+    static WallpaperInfo fromJson(const QJsonObject &obj);
+    static QString locationFromCopyright(const QString &copyright);
+};
+
+/**
+ * @brief 本地壁纸库：持久化每张壁纸的元数据，并提供全文检索
+ *
+ * 元数据保存在应用数据目录下的 library.json 中，与壁纸存储路径无关，
+ * 更改存储路径后旧壁纸的记录仍然保留。修改在 500 毫秒内合并后于后台线程写回。
+ * 检索索引随增删改增量更新，每条记录有一个不变的文档编号。
+ */
+class WallpaperLibrary : public QObject {
+    Q_OBJECT
+
+public:
+    explicit WallpaperLibrary(QObject *parent = nullptr);
+    ~WallpaperLibrary();
+
+    void addOrUpdate(const WallpaperInfo &info);
+    void remove(const QString &filePath);
+    void importDirectory(const QString &directory);
+    bool contains(const QString &filePath) const;
+    WallpaperInfo entry(const QString &filePath) const;
+    /**
+     * @brief 查找某一天的壁纸，没有时返回空记录
+     * @param date 日期，格式 yyyyMMdd
+     * @param market 市场，旧版本导入的记录没有市场信息，也视为匹配
+     */
+    WallpaperInfo findByDate(const QString &date, const QString &market) const;
+    QVector<WallpaperInfo> entries() const;
+    int count() const;
+
+    /**
+     * @brief 按标题、版权和地点检索
+     * @param query 用户输入，支持中文和英文前缀
+     * @param limit 最多返回的条数
+     * @return 命中的壁纸，日期新的在前
+     */
+    QVector<WallpaperInfo> search(const QString &query, int limit = 100) const;
+
+    /**
+     * @brief 立即写回尚未保存的修改并等待写入完成
+     */
+    void flush();
+
+signals:
+    /**
+     * @brief 记录被添加、更新或删除
+     * @param filePaths 发生变化的记录，已删除的记录不再被 contains() 找到
+     */
+    void entriesChanged(const QStringList &filePaths);
+    void libraryChanged();
+
+private:
+    void load();
+    void startSave();
+    void insertSorted(const WallpaperInfo &info, int docId);
+    void removeAt(int position);
+    void updatePositionsFrom(int position);
+    void commitChanges(const QStringList &changedPaths);
+    static QString searchText(const WallpaperInfo &info);
+    QString libraryFilePath() const;
+
+    QVector<WallpaperInfo> m_entries;   // 按日期升序
+    QVector<int> m_entryDocIds;         // 与 m_entries 一一对应
+    QHash<QString, int> m_pathIndex;    // 文件路径 -> m_entries 中的位置
+    QVector<int> m_docPositions;        // 文档编号 -> m_entries 中的位置，已删除为 -1
+    int m_nextDocId;
+
+    SearchIndex m_searchIndex;
+    QTimer m_saveTimer;
+    QThreadPool m_writer;               // 单线程，写入按提交顺序执行
+    bool m_savePending;
+};
+
+#endif // WALLPAPERLIBRARY_H
@@ -0,0 +1,547 @@
+// 壁纸设置延迟基准测试：测量各桌面后端从发出设置到设置生效的耗时。
+// 在私有的 dbus-daemon 中运行，dconf 数据库放在内存文件系统里，KDE 由模拟的 org.kde.plasmashell 代替，
+// 不会改动当前桌面。每种后端分别测量与程序一致的外部命令方式（spawn）和进程内调用方式（inprocess）。
+// "生效"指 dconf 发出变更通知（KDE 为 evaluateScript 返回），"完成"指整个设置序列结束。
+// 用法：bench_apply_latency [次数] [--backend gnome|kde|ukui] [--csv 文件]
+#ifdef HAVE_GIO
+// GIO 的结构体中有名为 signals 的成员，需在 Qt 定义同名宏之前包含
+#include <gio/gio.h>
+#endif
+#include "../Awaitables.h"
+#include "../WallpaperCommands.h"
+#include <QCoreApplication>
+#include <QDBusConnection>
+#include <QDBusConnectionInterface>
+#include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QTemporaryDir>
+#include <QScopedPointer>
+#include <QStandardPaths>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QThread>
+#include <QVector>
+#include <QPair>
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <utility>
+
+namespace {
+
+const int DEFAULT_ITERATIONS = 50;
+// 第一次调用包含 dconf-service 的按需启动，不计入结果
+const int WARMUP_ITERATIONS = 3;
+const int COMMAND_TIMEOUT_MS = 5000;
+const int VISIBLE_TIMEOUT_MS = 5000;
+const int STARTUP_TIMEOUT_MS = 5000;
+
+const char *GNOME_WATCH_KEY = "/org/gnome/desktop/background/picture-uri";
+const char *UKUI_WATCH_KEY = "/org/mate/desktop/background/picture-filename";
+
+struct Case {
+    QString backend;
+    QString strategy;
+    QString watchKey;           // 为空时以调用返回作为生效时间
+    std::function<Async::Task<bool>(const QString &)> apply;
+    QString skipReason;
+};
+
+struct Distribution {
+    int count = 0;
+    double min = 0;
+    double p50 = 0;
+    double p90 = 0;
+    double p99 = 0;
+    double max = 0;
+};
+
+Distribution distribution(QVector<double> samples) {
+    Distribution d;
+    if (samples.isEmpty()) {
+        return d;
+    }
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&samples](double q) {
+        return samples[qMin(int(samples.size()) - 1, int(q * samples.size()))];
+    };
+    d.count = samples.size();
+    d.min = samples.first();
+    d.p50 = percentile(0.50);
+    d.p90 = percentile(0.90);
+    d.p99 = percentile(0.99);
+    d.max = samples.last();
+    return d;
+}
+
+// 与程序设置已分析过的壁纸时相同：暗色模式沿用原图，并设置背景色
+QList<WallpaperCommands::GSetting> gnomeSettings(const QString &imagePath) {
+    return WallpaperCommands::gnome(imagePath, false, imagePath, QStringList() << "#2a4b6c" << "#1d3347");
+}
+
+QList<WallpaperCommands::GSetting> ukuiSettings(const QString &imagePath) {
+    return WallpaperCommands::ukui(imagePath, false);
+}
+
+// 单显示器时所有桌面容器都使用 fallback
+QString kdeScript(const QString &imagePath) {
+    return WallpaperCommands::plasmaScript(imagePath, QMap<QString, QString>());
+}
+
+QString findExecutable(const QStringList &names) {
+    for (const QString &name : names) {
+        QString path = QStandardPaths::findExecutable(name);
+        if (!path.isEmpty()) {
+            return path;
+        }
+    }
+    return QString();
+}
+
+} // namespace
+
+/**
+ * @brief 记录 dconf 写入服务发出的变更通知
+ */
+class DconfWatcher : public QObject {
+    Q_OBJECT
+
+public:
+    bool attach() {
+        return QDBusConnection::sessionBus().connect(QString(), QString(), "ca.desrt.dconf.Writer", "Notify", this,
+                                                     SLOT(onNotify(QString, QStringList, QString)));
+    }
+
+    void expect(const QString &key, const QElapsedTimer *clock) {
+        m_key = key;
+        m_clock = clock;
+        m_seenMs = -1;
+    }
+
+    bool hasSeen() const { return m_seenMs >= 0; }
+    double seenMs() const { return m_seenMs; }
+
+signals:
+    void seen();
+
+private slots:
+    void onNotify(const QString &prefix, const QStringList &changes, const QString &) {
+        if (hasSeen() || !m_clock) {
+            return;
+        }
+        // 单个键的通知 changes 为 [""]，批量写入时 prefix 是目录
+        for (const QString &change : changes) {
+            if (prefix + change == m_key) {
+                m_seenMs = m_clock->nsecsElapsed() / 1e6;
+                emit seen();
+                return;
+            }
+        }
+    }
+
+private:
+    QString m_key;
+    const QElapsedTimer *m_clock = nullptr;
+    double m_seenMs = -1;
+};
+
+/**
+ * @brief 模拟 plasmashell：执行脚本时把脚本写入桌面配置文件后返回
+ */
+class MockPlasmaShell : public QObject {
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.PlasmaShell")
+
+public slots:
+    Q_SCRIPTABLE QString evaluateScript(const QString &script) {
+        QSaveFile file(qEnvironmentVariable("XDG_CONFIG_HOME") + "/plasma-org.kde.plasma.desktop-appletsrc");
+        if (file.open(QIODevice::WriteOnly)) {
+            file.write(script.toUtf8());
+            file.commit();
+        }
+        return QString();
+    }
+};
+
+namespace {
+
+int runMockPlasmaShell() {
+    MockPlasmaShell shell;
+    QDBusConnection bus = QDBusConnection::sessionBus();
+    if (!bus.registerObject("/PlasmaShell", &shell, QDBusConnection::ExportScriptableSlots)
+        || !bus.registerService("org.kde.plasmashell")) {
+        std::fprintf(stderr, "模拟 plasmashell 注册失败\n");
+        return 1;
+    }
+    return QCoreApplication::exec();
+}
+
+/**
+ * @brief 私有的会话总线和内存中的配置目录，进程结束时一并清理
+ */
+class PrivateSession {
+public:
+    ~PrivateSession() {
+        stop(m_mockShell);
+        stop(m_daemon);
+    }
+
+    bool start() {
+        // /dev/shm 是 tmpfs，dconf 数据库的写入不落盘
+        QString base = QFileInfo("/dev/shm").isWritable() ? QString("/dev/shm") : QDir::tempPath();
+        m_dir.reset(new QTemporaryDir(base + "/bench-apply-XXXXXX"));
+        if (!m_dir->isValid()) {
+            std::fprintf(stderr, "无法创建临时目录\n");
+            return false;
+        }
+        QString runtimeDir = m_dir->filePath("runtime");
+        QDir().mkpath(runtimeDir);
+        QFile::setPermissions(runtimeDir, QFileDevice::ReadOwner | QFileDevice::WriteOwner | QFileDevice::ExeOwner);
+        QDir().mkpath(m_dir->filePath("config"));
+
+        // dbus-daemon 和它按需启动的 dconf-service 都继承这些变量
+        qputenv("XDG_CONFIG_HOME", m_dir->filePath("config").toUtf8());
+        qputenv("XDG_CACHE_HOME", m_dir->filePath("cache").toUtf8());
+        qputenv("XDG_RUNTIME_DIR", runtimeDir.toUtf8());
+        qputenv("GSETTINGS_BACKEND", "dconf");
+
+        QString daemon = findExecutable({"dbus-daemon"});
+        if (daemon.isEmpty()) {
+            std::fprintf(stderr, "未找到 dbus-daemon\n");
+            return false;
+        }
+        m_daemon.start(daemon, QStringList() << "--session" << "--nofork" << "--print-address"
+                                             << "--address=unix:path=" + m_dir->filePath("bus"));
+        if (!m_daemon.waitForReadyRead(STARTUP_TIMEOUT_MS)) {
+            std::fprintf(stderr, "dbus-daemon 启动失败\n");
+            return false;
+        }
+        QByteArray address = m_daemon.readLine().trimmed();
+        // 之后的 QDBusConnection::sessionBus() 和子进程都只会连到私有总线
+        qputenv("DBUS_SESSION_BUS_ADDRESS", address);
+        qunsetenv("DBUS_SESSION_BUS_PID");
+        return true;
+    }
+
+    bool startMockPlasmaShell() {
+        m_mockShell.start(QCoreApplication::applicationFilePath(), QStringList() << "--mock-plasmashell");
+        QElapsedTimer timer;
+        timer.start();
+        QDBusConnectionInterface *bus = QDBusConnection::sessionBus().interface();
+        while (timer.elapsed() < STARTUP_TIMEOUT_MS) {
+            if (bus->isServiceRegistered("org.kde.plasmashell")) {
+                return true;
+            }
+            QThread::msleep(10);
+        }
+        return false;
+    }
+
+    QString filePath(const QString &name) const {
+        return m_dir->filePath(name);
+    }
+
+private:
+    static void stop(QProcess &process) {
+        if (process.state() != QProcess::NotRunning) {
+            process.terminate();
+            if (!process.waitForFinished(1000)) {
+                process.kill();
+                process.waitForFinished(1000);
+            }
+        }
+    }
+
+    QScopedPointer<QTemporaryDir> m_dir;
+    QProcess m_daemon;
+    QProcess m_mockShell;
+};
+
+/**
+ * @brief 与程序相同的方式依次执行 gsettings，必需的键失败才算失败（旧版 schema 可能没有某些键）
+ */
+Async::Task<bool> applyBySpawn(QString schema, QList<WallpaperCommands::GSetting> settings) {
+    for (const WallpaperCommands::GSetting &setting : settings) {
+        QStringList arguments = WallpaperCommands::gsettingsArguments(schema, setting);
+        Async::ProcessResult result = co_await Async::runProcess("gsettings", arguments, COMMAND_TIMEOUT_MS);
+        if (setting.required && !result.succeeded()) {
+            co_return false;
+        }
+    }
+    co_return true;
+}
+
+#ifdef HAVE_GIO
+/**
+ * @brief 进程内通过 GSettings 一次提交所有键，dconf 只写入一次、只发一条通知
+ */
+Async::Task<bool> applyByGio(GSettings *settings, QList<WallpaperCommands::GSetting> values) {
+    GSettingsSchema *schema = nullptr;
+    g_object_get(settings, "settings-schema", &schema, nullptr);
+    g_settings_delay(settings);
+    bool ok = true;
+    for (const WallpaperCommands::GSetting &value : std::as_const(values)) {
+        QByteArray key = value.key.toUtf8();
+        if (!g_settings_schema_has_key(schema, key.constData())) {
+            continue;
+        }
+        ok = g_settings_set_string(settings, key.constData(), value.value.toUtf8().constData()) && ok;
+    }
+    g_settings_apply(settings);
+    g_settings_sync();
+    g_settings_schema_unref(schema);
+    co_return ok;
+}
+
+GSettings *openSettings(const char *schemaId) {
+    GSettingsSchemaSource *source = g_settings_schema_source_get_default();
+    GSettingsSchema *schema = source ? g_settings_schema_source_lookup(source, schemaId, TRUE) : nullptr;
+    if (!schema) {
+        return nullptr;
+    }
+    g_settings_schema_unref(schema);
+    return g_settings_new(schemaId);
+}
+#endif
+
+Async::Task<bool> applyByQdbus(QString qdbus, QString imagePath) {
+    QStringList arguments = WallpaperCommands::qdbusArguments(kdeScript(imagePath));
+    Async::ProcessResult result = co_await Async::runProcess(qdbus, arguments, COMMAND_TIMEOUT_MS);
+    co_return result.succeeded();
+}
+
+Async::Task<bool> applyByDBusCall(QString imagePath) {
+    QDBusMessage message = QDBusMessage::createMethodCall(WallpaperCommands::PLASMA_SERVICE,
+                                                          WallpaperCommands::PLASMA_PATH,
+                                                          WallpaperCommands::PLASMA_INTERFACE,
+                                                          WallpaperCommands::PLASMA_METHOD);
+    message << kdeScript(imagePath);
+    QDBusPendingCallWatcher watcher(QDBusConnection::sessionBus().asyncCall(message, COMMAND_TIMEOUT_MS));
+    if (!watcher.isFinished()) {
+        auto finished = Async::awaitSignal(&watcher, &QDBusPendingCallWatcher::finished);
+        co_await finished;
+    }
+    co_return !watcher.isError();
+}
+
+Async::Task<bool> schemaInstalled(QString schema) {
+    QStringList arguments;
+    arguments << "list-keys" << schema;
+    Async::ProcessResult result = co_await Async::runProcess("gsettings", arguments, COMMAND_TIMEOUT_MS);
+    co_return result.succeeded();
+}
+
+struct Options {
+    int iterations = DEFAULT_ITERATIONS;
+    QString backend;
+    QString csvPath;
+};
+
+void printRow(const Case &c, const Distribution &visible, const Distribution &total, int failures) {
+    std::printf("%-6s %-10s %5d  %7.1f %7.1f %7.1f %7.1f  %7.1f %7.1f %7.1f %7.1f  %4d\n",
+                qPrintable(c.backend), qPrintable(c.strategy), visible.count,
+                visible.p50, visible.p90, visible.p99, visible.max,
+                total.p50, total.p90, total.p99, total.max, failures);
+}
+
+void appendCsv(const QString &path, const Case &c, const QString &metric, const Distribution &d) {
+    QFile file(path);
+    bool exists = file.exists();
+    if (!file.open(QIODevice::Append | QIODevice::Text)) {
+        return;
+    }
+    if (!exists) {
+        file.write("timestamp,backend,strategy,metric,count,min,p50,p90,p99,max\n");
+    }
+    file.write(QString("%1,%2,%3,%4,%5,%6,%7,%8,%9,%10\n")
+               .arg(QDateTime::currentDateTimeUtc().toString(Qt::ISODate), c.backend, c.strategy, metric)
+               .arg(d.count).arg(d.min, 0, 'f', 2).arg(d.p50, 0, 'f', 2).arg(d.p90, 0, 'f', 2)
+               .arg(d.p99, 0, 'f', 2).arg(d.max, 0, 'f', 2).toUtf8());
+}
+
+Async::Task<void> runCase(Case c, Options options, DconfWatcher *watcher, PrivateSession *session) {
+    if (!c.skipReason.isEmpty()) {
+        std::printf("%-6s %-10s 跳过：%s\n", qPrintable(c.backend), qPrintable(c.strategy), qPrintable(c.skipReason));
+        co_return;
+    }
+
+    QVector<double> visibleMs;
+    QVector<double> totalMs;
+    int failures = 0;
+    for (int i = -WARMUP_ITERATIONS; i < options.iterations; ++i) {
+        // 两张图片交替，保证每次都是真正的修改
+        QString imagePath = session->filePath(i % 2 == 0 ? "a.jpg" : "b.jpg");
+        QElapsedTimer clock;
+        clock.start();
+        watcher->expect(c.watchKey, &clock);
+
+        bool ok = co_await c.apply(imagePath);
+        double total = clock.nsecsElapsed() / 1e6;
+        double visible = total;
+        if (ok && !c.watchKey.isEmpty()) {
+            if (!watcher->hasSeen()) {
+                Async::CancellationToken timeout;
+                auto cancel = [timeout]() mutable {
+                    timeout.cancel();
+                };
+                QTimer::singleShot(VISIBLE_TIMEOUT_MS, cancel);
+                auto seen = Async::awaitSignal(watcher, &DconfWatcher::seen, timeout);
+                co_await seen;
+            }
+            ok = watcher->hasSeen();
+            visible = watcher->seenMs();
+            total = qMax(total, visible);
+        }
+        watcher->expect(QString(), nullptr);
+
+        if (i < 0) {
+            continue;
+        }
+        if (!ok) {
+            ++failures;
+            continue;
+        }
+        visibleMs.append(visible);
+        totalMs.append(total);
+    }
+
+    Distribution visible = distribution(visibleMs);
+    Distribution total = distribution(totalMs);
+    printRow(c, visible, total, failures);
+    if (!options.csvPath.isEmpty()) {
+        appendCsv(options.csvPath, c, "visible", visible);
+        appendCsv(options.csvPath, c, "total", total);
+    }
+}
+
+Async::Task<void> runBenchmarks(Options options, PrivateSession *session) {
+    DconfWatcher watcher;
+    if (!watcher.attach()) {
+        std::fprintf(stderr, "无法监听 dconf 变更通知\n");
+    }
+    // 后端只记录路径，图片内容无关紧要
+    const QStringList images = {"a.jpg", "b.jpg"};
+    for (const QString &image : images) {
+        QFile file(session->filePath(image));
+        if (file.open(QIODevice::WriteOnly)) {
+            file.write("\xFF\xD8\xFF\xD9");
+        }
+    }
+
+    bool haveGsettings = !findExecutable({"gsettings"}).isEmpty();
+    QString qdbus = findExecutable({"qdbus", "qdbus6", "qdbus-qt6", "qdbus-qt5"});
+
+    QList<Case> cases;
+    const QList<QPair<QString, QPair<const char *, const char *>>> gsettingsBackends = {
+        qMakePair(QString("gnome"), qMakePair(WallpaperCommands::GNOME_SCHEMA, GNOME_WATCH_KEY)),
+        qMakePair(QString("ukui"), qMakePair(WallpaperCommands::UKUI_SCHEMA, UKUI_WATCH_KEY)),
+    };
+    for (const auto &backend : gsettingsBackends) {
+        QString name = backend.first;
+        QString schema = backend.second.first;
+        if (!options.backend.isEmpty() && options.backend != name) {
+            continue;
+        }
+        bool installed = false;
+        if (haveGsettings) {
+            installed = co_await schemaInstalled(schema);
+        }
+        QString skipReason = !haveGsettings ? QString("未找到 gsettings")
+                           : !installed ? QString("未安装 schema %1").arg(schema) : QString();
+        auto values = name == "gnome" ? &gnomeSettings : &ukuiSettings;
+
+        Case spawn;
+        spawn.backend = name;
+        spawn.strategy = "spawn";
+        spawn.watchKey = backend.second.second;
+        spawn.skipReason = skipReason;
+        spawn.apply = [schema, values](const QString &imagePath) {
+            return applyBySpawn(schema, values(imagePath));
+        };
+        cases.append(spawn);
+
+        Case inprocess = spawn;
+        inprocess.strategy = "inprocess";
+#ifdef HAVE_GIO
+        GSettings *settings = skipReason.isEmpty() ? openSettings(backend.second.first) : nullptr;
+        if (settings) {
+            // 进程结束时才释放，与程序中长期持有的用法一致
+            inprocess.apply = [settings, values](const QString &imagePath) {
+                return applyByGio(settings, values(imagePath));
+            };
+        } else if (skipReason.isEmpty()) {
+            inprocess.skipReason = "GSettings 无法打开 schema";
+        }
+#else
+        inprocess.skipReason = "编译时未找到 gio-2.0";
+#endif
+        cases.append(inprocess);
+    }
+
+    if (options.backend.isEmpty() || options.backend == "kde") {
+        bool mockStarted = session->startMockPlasmaShell();
+        Case spawn;
+        spawn.backend = "kde";
+        spawn.strategy = "spawn";
+        spawn.skipReason = !mockStarted ? QString("模拟 plasmashell 启动失败")
+                         : qdbus.isEmpty() ? QString("未找到 qdbus") : QString();
+        spawn.apply = [qdbus](const QString &imagePath) {
+            return applyByQdbus(qdbus, imagePath);
+        };
+        cases.append(spawn);
+
+        Case inprocess;
+        inprocess.backend = "kde";
+        inprocess.strategy = "inprocess";
+        inprocess.skipReason = !mockStarted ? QString("模拟 plasmashell 启动失败") : QString();
+        inprocess.apply = [](const QString &imagePath) {
+            return applyByDBusCall(imagePath);
+        };
+        cases.append(inprocess);
+    }
+
+    std::printf("每项 %d 次（另有 %d 次预热），单位 ms\n", options.iterations, WARMUP_ITERATIONS);
+    std::printf("%-6s %-10s %5s  %7s %7s %7s %7s  %7s %7s %7s %7s  %4s\n", "后端", "方式", "次数",
+                "生效p50", "p90", "p99", "max", "完成p50", "p90", "p99", "max", "失败");
+    for (const Case &c : std::as_const(cases)) {
+        co_await runCase(c, options, &watcher, session);
+    }
+    // 所有项目都被跳过时还没有进入事件循环，排队退出
+    QTimer::singleShot(0, QCoreApplication::instance(), &QCoreApplication::quit);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    if (args.contains("--mock-plasmashell")) {
+        return runMockPlasmaShell();
+    }
+
+    Options options;
+    for (int i = 1; i < args.size(); ++i) {
+        if (args.at(i) == "--backend" && i + 1 < args.size()) {
+            options.backend = args.at(++i);
+        } else if (args.at(i) == "--csv" && i + 1 < args.size()) {
+            options.csvPath = args.at(++i);
+        } else if (args.at(i).toInt() > 0) {
+            options.iterations = args.at(i).toInt();
+        }
+    }
+
+    // 私有总线启动失败时直接退出，绝不退回到当前桌面的会话总线
+    PrivateSession session;
+    if (!session.start()) {
+        return 1;
+    }
+
+    Async::spawn(runBenchmarks(options, &session));
+    return app.exec();
+}
+
+#include "ApplyLatencyBenchmark.moc"
@@ -0,0 +1,119 @@
+// 图像分析与锁屏模糊核基准测试：在合成的 4K 帧上比较 SIMD 与标量实现的耗时，并校验两者结果一致
+#include "../ImageKernels.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const int WIDTH = 3840;
+const int HEIGHT = 2160;
+
+std::vector<uint32_t> makeFrame() {
+    // 渐变天空 + 伪随机纹理，既有大块颜色也有边缘
+    std::vector<uint32_t> frame(static_cast<size_t>(WIDTH) * HEIGHT);
+    uint32_t seed = 12345;
+    for (int y = 0; y < HEIGHT; ++y) {
+        for (int x = 0; x < WIDTH; ++x) {
+            seed = seed * 1664525u + 1013904223u;
+            uint32_t noise = (seed >> 24) & 0x1f;
+            uint32_t r = (y < HEIGHT / 2) ? 40 + x * 80 / WIDTH : 120 + noise;
+            uint32_t g = (y < HEIGHT / 2) ? 90 + y * 100 / HEIGHT : 100 + noise;
+            uint32_t b = (y < HEIGHT / 2) ? 200 : 60 + noise;
+            frame[static_cast<size_t>(y) * WIDTH + x] = 0xff000000u | (r << 16) | (g << 8) | b;
+        }
+    }
+    return frame;
+}
+
+template <typename F>
+double medianMs(int iterations, F &&body) {
+    std::vector<double> samples;
+    for (int i = 0; i < iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        auto end = std::chrono::steady_clock::now();
+        samples.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 20;
+    std::vector<uint32_t> frame = makeFrame();
+
+    ImageKernels::setForceScalar(true);
+    ImageKernels::Analysis scalar = ImageKernels::analyze(frame.data(), WIDTH, HEIGHT, WIDTH);
+    double scalarMs = medianMs(iterations, [&]() {
+        ImageKernels::analyze(frame.data(), WIDTH, HEIGHT, WIDTH);
+    });
+
+    ImageKernels::setForceScalar(false);
+    ImageKernels::Analysis simd = ImageKernels::analyze(frame.data(), WIDTH, HEIGHT, WIDTH);
+    double simdMs = medianMs(iterations, [&]() {
+        ImageKernels::analyze(frame.data(), WIDTH, HEIGHT, WIDTH);
+    });
+
+    std::printf("analyze %dx%d  scalar: %.2f ms  %s: %.2f ms\n",
+                WIDTH, HEIGHT, scalarMs, ImageKernels::implementationName(), simdMs);
+    std::printf("luminance %.4f  busyness %.4f  palette", simd.luminance, simd.busyness);
+    for (int i = 0; i < simd.paletteSize; ++i) {
+        std::printf(" #%06x(%.2f)", simd.palette[i], simd.paletteWeights[i]);
+    }
+    std::printf("\n");
+
+    std::vector<uint32_t> dimmed = frame;
+    double dimMs = medianMs(iterations, [&]() {
+        std::memcpy(dimmed.data(), frame.data(), frame.size() * sizeof(uint32_t));
+        ImageKernels::scaleBrightness(dimmed.data(), dimmed.size(), 160);
+    });
+    std::printf("scaleBrightness (含拷贝) %s: %.2f ms\n", ImageKernels::implementationName(), dimMs);
+
+    // 锁屏模糊：先降到 1/4 分辨率，再做 3 次半径 8 的盒式模糊
+    std::vector<uint32_t> reduced(static_cast<size_t>(WIDTH / 4) * (HEIGHT / 4));
+    ImageKernels::downsample4x(frame.data(), WIDTH, HEIGHT, WIDTH, reduced.data());
+    std::vector<uint32_t> blurScalar = reduced;
+    std::vector<uint32_t> blurSimd = reduced;
+    ImageKernels::setForceScalar(true);
+    ImageKernels::boxBlur(blurScalar.data(), WIDTH / 4, HEIGHT / 4, 8, 3);
+    double blurScalarMs = medianMs(iterations, [&]() {
+        std::vector<uint32_t> work = reduced;
+        ImageKernels::boxBlur(work.data(), WIDTH / 4, HEIGHT / 4, 8, 3);
+    });
+    ImageKernels::setForceScalar(false);
+    ImageKernels::boxBlur(blurSimd.data(), WIDTH / 4, HEIGHT / 4, 8, 3);
+    double blurSimdMs = medianMs(iterations, [&]() {
+        std::vector<uint32_t> work(static_cast<size_t>(WIDTH / 4) * (HEIGHT / 4));
+        ImageKernels::downsample4x(frame.data(), WIDTH, HEIGHT, WIDTH, work.data());
+        ImageKernels::boxBlur(work.data(), WIDTH / 4, HEIGHT / 4, 8, 3);
+    });
+    std::printf("lock blur 4K->%dx%d r=8 x3  scalar: %.2f ms  %s (含降采样): %.2f ms\n",
+                WIDTH / 4, HEIGHT / 4, blurScalarMs, ImageKernels::implementationName(), blurSimdMs);
+
+    double fullBlurMs = medianMs(std::max(1, iterations / 4), [&]() {
+        std::vector<uint32_t> work = frame;
+        ImageKernels::boxBlur(work.data(), WIDTH, HEIGHT, 32, 3);
+    });
+    std::printf("full-res blur %dx%d r=32 x3  %s: %.2f ms\n", WIDTH, HEIGHT,
+                ImageKernels::implementationName(), fullBlurMs);
+
+    if (blurScalar != blurSimd) {
+        std::printf("错误: 模糊结果 SIMD 与标量实现不一致\n");
+        return 1;
+    }
+
+    bool same = scalar.luminance == simd.luminance && scalar.busyness == simd.busyness
+             && scalar.paletteSize == simd.paletteSize
+             && std::memcmp(scalar.palette, simd.palette, sizeof(scalar.palette)) == 0;
+    if (!same) {
+        std::printf("错误: SIMD 与标量实现结果不一致 (luminance %.6f/%.6f busyness %.6f/%.6f)\n",
+                    scalar.luminance, simd.luminance, scalar.busyness, simd.busyness);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,144 @@
+// JPEG 结构校验基准测试：在合成的 4K 壁纸大小的数据上比较 SIMD 与标量实现的耗时，
+// 并检查截断、缺少 EOI 等情况的判定。
+// 用法：bench_jpeg_verify [次数]，或 bench_jpeg_verify 0 <文件...> 逐个校验真实文件
+#include "../JpegVerifier.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace {
+
+// Bing 的 4K 壁纸通常在 2~6 MB 之间
+const size_t SCAN_BYTES = 4 * 1024 * 1024;
+
+void appendSegment(std::vector<uint8_t> &out, uint8_t marker, size_t payload) {
+    out.push_back(0xFF);
+    out.push_back(marker);
+    out.push_back(static_cast<uint8_t>((payload + 2) >> 8));
+    out.push_back(static_cast<uint8_t>((payload + 2) & 0xFF));
+    out.insert(out.end(), payload, 0x10);
+}
+
+std::vector<uint8_t> makeJpeg() {
+    std::vector<uint8_t> out = {0xFF, 0xD8};
+    appendSegment(out, 0xE0, 14);       // APP0
+    appendSegment(out, 0xDB, 130);      // DQT
+    appendSegment(out, 0xC0, 15);       // SOF0
+    appendSegment(out, 0xC4, 400);      // DHT
+    appendSegment(out, 0xDD, 2);        // DRI
+    appendSegment(out, 0xDA, 10);       // SOS
+
+    // 伪随机熵编码数据：0xFF 按规范转义为 FF 00，每 64 KB 插入一个重启标记
+    uint32_t seed = 12345;
+    int restart = 0;
+    for (size_t i = 0; i < SCAN_BYTES; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        uint8_t byte = static_cast<uint8_t>(seed >> 24);
+        out.push_back(byte);
+        if (byte == 0xFF) {
+            out.push_back(0x00);
+        }
+        if (i % 65536 == 65535) {
+            out.push_back(0xFF);
+            out.push_back(static_cast<uint8_t>(0xD0 + (restart++ & 7)));
+        }
+    }
+    out.push_back(0xFF);
+    out.push_back(0xD9);
+    return out;
+}
+
+template <typename F>
+double medianMs(int iterations, F &&body) {
+    std::vector<double> samples;
+    for (int i = 0; i < iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        auto end = std::chrono::steady_clock::now();
+        samples.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+int verifyFiles(int count, char *paths[]) {
+    int failures = 0;
+    for (int i = 0; i < count; ++i) {
+        std::ifstream file(paths[i], std::ios::binary);
+        std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        JpegVerifier::Status status = JpegVerifier::verify(data.data(), data.size());
+        std::printf("%-12s %s\n", JpegVerifier::statusName(status), paths[i]);
+        if (status != JpegVerifier::Status::Ok) {
+            ++failures;
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    if (argc > 1 && std::atoi(argv[1]) == 0) {
+        return verifyFiles(argc - 2, argv + 2);
+    }
+
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 50;
+    std::vector<uint8_t> jpeg = makeJpeg();
+
+    JpegVerifier::setForceScalar(true);
+    JpegVerifier::Status scalar = JpegVerifier::verify(jpeg.data(), jpeg.size());
+    double scalarMs = medianMs(iterations, [&]() {
+        JpegVerifier::verify(jpeg.data(), jpeg.size());
+    });
+
+    JpegVerifier::setForceScalar(false);
+    JpegVerifier::Status simd = JpegVerifier::verify(jpeg.data(), jpeg.size());
+    double simdMs = medianMs(iterations, [&]() {
+        JpegVerifier::verify(jpeg.data(), jpeg.size());
+    });
+
+    std::printf("verify %.1f MB  scalar: %.3f ms  %s: %.3f ms  (%s / %s)\n",
+                jpeg.size() / 1048576.0, scalarMs, JpegVerifier::implementationName(), simdMs,
+                JpegVerifier::statusName(scalar), JpegVerifier::statusName(simd));
+    std::printf("10000 张约需 %.1f s（单线程，不含读盘）\n", simdMs * 10000 / 1000.0);
+
+    // 各种损坏情况的判定
+    struct Case {
+        const char *name;
+        size_t size;
+        JpegVerifier::Status expected;
+    };
+    const Case cases[] = {
+        {"完整", jpeg.size(), JpegVerifier::Status::Ok},
+        {"缺少 EOI", jpeg.size() - 2, JpegVerifier::Status::Truncated},
+        {"扫描数据中截断", jpeg.size() / 2, JpegVerifier::Status::Truncated},
+        {"标记段中截断", 30, JpegVerifier::Status::Truncated},
+        {"只有 SOI", 2, JpegVerifier::Status::Truncated},
+        {"空文件", 0, JpegVerifier::Status::NotJpeg},
+    };
+    bool allPassed = scalar == JpegVerifier::Status::Ok && simd == JpegVerifier::Status::Ok;
+    for (const Case &c : cases) {
+        for (bool forceScalar : {true, false}) {
+            JpegVerifier::setForceScalar(forceScalar);
+            JpegVerifier::Status status = JpegVerifier::verify(jpeg.data(), c.size);
+            if (status != c.expected) {
+                std::printf("判定错误 [%s] %s: %s\n", JpegVerifier::implementationName(), c.name,
+                            JpegVerifier::statusName(status));
+                allPassed = false;
+            }
+        }
+    }
+
+    std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+    if (JpegVerifier::verify(png.data(), png.size()) != JpegVerifier::Status::NotJpeg) {
+        std::printf("判定错误: PNG 数据\n");
+        allPassed = false;
+    }
+
+    std::printf("%s\n", allPassed ? "判定全部正确" : "存在判定错误");
+    return allPassed ? 0 : 1;
+}
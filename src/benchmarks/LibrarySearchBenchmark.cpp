@@ -0,0 +1,160 @@
+// 壁纸库检索基准测试：合成 10000 条中英文元数据，测量边输入边搜索的查询耗时，
+// 以及刚添加或更新记录后的第一次查询（索引增量更新，不应随库的大小变慢）。
+// 用法：bench_library_search [条数]，在 QStandardPaths 测试目录中运行，不影响真实的壁纸库
+#include "../WallpaperLibrary.h"
+#include <QCoreApplication>
+#include <QStandardPaths>
+#include <QFile>
+#include <QDate>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+const char *const PLACES[] = {
+    "布莱斯峡谷国家公园", "黄山", "九寨沟", "大堡礁", "冰岛维克", "马特洪峰", "京都岚山", "桂林漓江",
+    "优胜美地国家公园", "圣托里尼", "撒哈拉沙漠", "班夫国家公园", "张家界", "婺源", "普罗旺斯", "喀纳斯湖",
+};
+const char *const COUNTRIES[] = {
+    "美国犹他州", "中国安徽", "中国四川", "澳大利亚", "冰岛", "瑞士", "日本", "中国广西",
+    "美国加利福尼亚州", "希腊", "摩洛哥", "加拿大艾伯塔省", "中国湖南", "中国江西", "法国", "中国新疆",
+};
+const char *const SUBJECTS[] = {
+    "的日出", "上空的银河", "秋色", "雪景", "的灯塔", "中的狐狸", "的瀑布", "倒影",
+};
+const char *const PHOTOGRAPHERS[] = {
+    "Getty Images", "Shutterstock", "Alamy", "Minden Pictures", "Offset", "Amazing Aerial Agency",
+};
+const char *const QUERIES[] = {
+    "g", "ge", "get", "getty", "国家", "国家公园", "山", "银河", "黄山 日出", "alamy 冰岛", "不存在的地点",
+};
+
+template <typename T, size_t N>
+const T &pick(const T (&items)[N], uint32_t &seed) {
+    seed = seed * 1664525u + 1013904223u;
+    return items[(seed >> 16) % N];
+}
+
+WallpaperInfo makeInfo(int i, uint32_t &seed) {
+    WallpaperInfo info;
+    info.date = QDate(2000, 1, 1).addDays(i).toString("yyyyMMdd");
+    info.filePath = QString("/tmp/bing_wallpaper_%1.jpg").arg(info.date);
+    QString place = QString::fromUtf8(pick(PLACES, seed));
+    info.title = place + QString::fromUtf8(pick(SUBJECTS, seed));
+    info.copyright = place + "，" + QString::fromUtf8(pick(COUNTRIES, seed))
+                     + " (© " + QString::fromUtf8(pick(PHOTOGRAPHERS, seed)) + ")";
+    info.location = WallpaperInfo::locationFromCopyright(info.copyright);
+    info.market = "zh-CN";
+    return info;
+}
+
+struct Stats {
+    double p50;
+    double p99;
+    double max;
+};
+
+Stats summarize(std::vector<double> samples) {
+    std::sort(samples.begin(), samples.end());
+    return {samples[samples.size() / 2], samples[samples.size() * 99 / 100], samples.back()};
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("bench_library_search");
+    QStandardPaths::setTestModeEnabled(true);
+    const QString libraryFile = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/library.json";
+    QFile::remove(libraryFile);
+
+    const int count = argc > 1 ? std::atoi(argv[1]) : 10000;
+    const int iterations = 200;
+    uint32_t seed = 12345;
+    bool allPassed = true;
+
+    {
+        WallpaperLibrary library;
+
+        // 按日期顺序逐条添加，与每天下载一张的情况相同
+        std::vector<double> addSamples;
+        for (int i = 0; i < count; ++i) {
+            WallpaperInfo info = makeInfo(i, seed);
+            auto start = std::chrono::steady_clock::now();
+            library.addOrUpdate(info);
+            addSamples.push_back(elapsedMs(start));
+        }
+        Stats add = summarize(addSamples);
+        std::printf("添加 %d 条  p50 %.3f ms  p99 %.3f ms  最大 %.3f ms\n", count, add.p50, add.p99, add.max);
+
+        for (const char *query : QUERIES) {
+            const QString text = QString::fromUtf8(query);
+            int hits = 0;
+            std::vector<double> samples;
+            for (int i = 0; i < iterations; ++i) {
+                auto start = std::chrono::steady_clock::now();
+                hits = library.search(text).size();
+                samples.push_back(elapsedMs(start));
+            }
+            Stats stats = summarize(samples);
+            std::printf("%-16s 命中 %4d  p50 %.3f ms  p99 %.3f ms\n", query, hits, stats.p50, stats.p99);
+        }
+
+        // 下载或分析完成后更新某条记录，紧接着用户继续输入
+        std::vector<double> updateSamples;
+        std::vector<double> firstQuerySamples;
+        for (int i = 0; i < iterations; ++i) {
+            seed = seed * 1664525u + 1013904223u;
+            WallpaperInfo info = makeInfo(int((seed >> 8) % count), seed);
+            info.title += QString(" marker%1").arg(i);
+            auto start = std::chrono::steady_clock::now();
+            library.addOrUpdate(info);
+            updateSamples.push_back(elapsedMs(start));
+
+            start = std::chrono::steady_clock::now();
+            QVector<WallpaperInfo> results = library.search(QString("marker%1").arg(i));
+            firstQuerySamples.push_back(elapsedMs(start));
+            if (results.size() != 1 || results.first().filePath != info.filePath) {
+                std::printf("检索错误: 更新后查不到 marker%d\n", i);
+                allPassed = false;
+            }
+        }
+        Stats update = summarize(updateSamples);
+        Stats firstQuery = summarize(firstQuerySamples);
+        std::printf("更新记录        p50 %.3f ms  p99 %.3f ms\n", update.p50, update.p99);
+        std::printf("更新后首次查询  p50 %.3f ms  p99 %.3f ms\n", firstQuery.p50, firstQuery.p99);
+
+        // 删除后不应再命中，结果按日期从新到旧
+        WallpaperInfo newest = library.entries().last();
+        library.remove(newest.filePath);
+        for (const WallpaperInfo &info : library.search(newest.title, 0)) {
+            if (info.filePath == newest.filePath) {
+                std::printf("检索错误: 已删除的记录仍被命中\n");
+                allPassed = false;
+            }
+        }
+        QVector<WallpaperInfo> ordered = library.search("getty", 0);
+        for (int i = 1; i < ordered.size(); ++i) {
+            if (ordered[i - 1].date < ordered[i].date) {
+                std::printf("检索错误: 结果未按日期排序\n");
+                allPassed = false;
+                break;
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        library.flush();
+        std::printf("写回 library.json  %.1f ms（后台线程）\n", elapsedMs(start));
+    }
+
+    QFile::remove(libraryFile);
+    std::printf("%s\n", allPassed ? "检索结果全部正确" : "存在检索错误");
+    return allPassed ? 0 : 1;
+}
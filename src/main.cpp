@@ -1,8 +1,79 @@
 #include "MainWindow.h"
+#include "WallpaperCacheDaemon.h"
+#include "WallpaperCacheClient.h"
+#include "DownloadPolicy.h"
 #include <QApplication>
+#include <QCoreApplication>
+#include <QCommandLineParser>
 #include <QStyleFactory>
+#include <QTimer>
+#include <cstdio>
+#include <cstring>
+
+static bool hasArgument(int argc, char *argv[], const char *name) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 共享缓存服务不需要图形界面，可以在没有显示器的服务器上运行
+static int runCacheDaemon(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("Bing Wallpaper Setter");
+    app.setOrganizationName("BingWallpaper");
+    app.setOrganizationDomain("bingwallpaper.local");
+    
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Bing壁纸多用户共享缓存服务");
+    parser.addHelpOption();
+    QCommandLineOption daemonOption("cache-daemon", "以共享缓存服务方式运行");
+    QCommandLineOption socketOption("socket", "监听的本地套接字路径", "path",
+                                    WallpaperCacheClient::defaultSocketPath());
+    QCommandLineOption cacheDirOption("cache-dir", "缓存目录", "dir",
+                                      WallpaperCacheDaemon::defaultCacheDir());
+    parser.addOption(daemonOption);
+    parser.addOption(socketOption);
+    parser.addOption(cacheDirOption);
+    parser.process(app);
+    
+    WallpaperCacheDaemon daemon(parser.value(cacheDirOption));
+    if (!daemon.listen(parser.value(socketOption))) {
+        return 1;
+    }
+    return app.exec();
+}
+
+// 输出当前网络和供电状态下的下载策略后退出，供 scripts/test_download_policy.py 检查
+static int printDownloadPolicy(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("Bing Wallpaper Setter");
+    app.setOrganizationName("BingWallpaper");
+    app.setOrganizationDomain("bingwallpaper.local");
+    
+    DownloadPolicy policy;
+    // 系统总线上的属性是异步读取的，等查询返回后再输出
+    QTimer::singleShot(1000, &app, [&policy]() {
+        std::printf("automatic=%s user=%s constraint=%s\n",
+                    qPrintable(DownloadPolicy::decisionName(policy.decide(false))),
+                    qPrintable(DownloadPolicy::decisionName(policy.decide(true))),
+                    policy.constraintDescription().toUtf8().constData());
+        std::fflush(stdout);
+        QCoreApplication::quit();
+    });
+    return app.exec();
+}
 
 int main(int argc, char *argv[]) {
+    if (hasArgument(argc, argv, "--cache-daemon")) {
+        return runCacheDaemon(argc, argv);
+    }
+    if (hasArgument(argc, argv, "--print-download-policy")) {
+        return printDownloadPolicy(argc, argv);
+    }
+    
     QApplication app(argc, argv);
     
     // 设置应用程序信息
@@ -0,0 +1,120 @@
+// 编译时生成图标资源：把 Bing 标志栅格化为各种尺寸的托盘图标（浅色、深色各一套），
+// 把应用图标缩放为各种尺寸，并写出引用这些文件的 icons.qrc。
+// 用法：bing_icon_generator <输出目录> <应用图标 PNG> <托盘图标尺寸,...> <应用图标尺寸,...>
+#include "../BingLogoPath.h"
+#include <QCoreApplication>
+#include <QColor>
+#include <QDir>
+#include <QImage>
+#include <QPainter>
+#include <QSaveFile>
+#include <QStringList>
+#include <cstdio>
+
+namespace {
+
+struct TrayVariant {
+    const char *name;
+    QColor color;
+};
+
+// 浅色图标用于深色面板（与旧版本一致的白色），深色图标用于浅色面板
+const TrayVariant TRAY_VARIANTS[] = {
+    {"light", QColor(255, 255, 255)},
+    {"dark", QColor(32, 32, 32)},
+};
+
+QImage renderTrayIcon(int size, const QColor &color) {
+    QImage image(size, size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(color);
+    // 标志放在 32x32 的画布上，四周各留 4 个单位
+    painter.scale(size / 32.0, size / 32.0);
+    painter.translate(4, 4);
+    painter.drawPath(bingLogoPath());
+    return image;
+}
+
+QList<int> parseSizes(const QString &argument) {
+    QList<int> sizes;
+    const QStringList parts = argument.split(',', Qt::SkipEmptyParts);
+    for (const QString &part : parts) {
+        int size = part.trimmed().toInt();
+        if (size > 0) {
+            sizes.append(size);
+        }
+    }
+    return sizes;
+}
+
+bool saveImage(const QImage &image, const QDir &outputDir, const QString &fileName, QStringList &files) {
+    if (!image.save(outputDir.filePath(fileName), "PNG")) {
+        std::fprintf(stderr, "写入 %s 失败\n", qPrintable(outputDir.filePath(fileName)));
+        return false;
+    }
+    files.append(fileName);
+    return true;
+}
+
+bool writeQrc(const QDir &outputDir, const QStringList &files) {
+    QSaveFile qrc(outputDir.filePath("icons.qrc"));
+    if (!qrc.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return false;
+    }
+    qrc.write("<!DOCTYPE RCC>\n<RCC version=\"1.0\">\n<qresource prefix=\"/icons\">\n");
+    for (const QString &file : files) {
+        qrc.write(QString("    <file>%1</file>\n").arg(file).toUtf8());
+    }
+    qrc.write("</qresource>\n</RCC>\n");
+    return qrc.commit();
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    if (args.size() != 5) {
+        std::fprintf(stderr, "用法: %s <输出目录> <应用图标 PNG> <托盘图标尺寸,...> <应用图标尺寸,...>\n",
+                     qPrintable(args.value(0)));
+        return 2;
+    }
+
+    QDir outputDir(args.at(1));
+    if (!outputDir.mkpath(".")) {
+        std::fprintf(stderr, "无法创建目录 %s\n", qPrintable(args.at(1)));
+        return 1;
+    }
+
+    QImage appIcon(args.at(2));
+    if (appIcon.isNull()) {
+        std::fprintf(stderr, "无法读取应用图标 %s\n", qPrintable(args.at(2)));
+        return 1;
+    }
+
+    QStringList files;
+    for (int size : parseSizes(args.at(3))) {
+        for (const TrayVariant &variant : TRAY_VARIANTS) {
+            QString fileName = QString("tray-%1-%2.png").arg(variant.name).arg(size);
+            if (!saveImage(renderTrayIcon(size, variant.color), outputDir, fileName, files)) {
+                return 1;
+            }
+        }
+    }
+    for (int size : parseSizes(args.at(4))) {
+        QImage scaled = appIcon.scaled(size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        if (!saveImage(scaled, outputDir, QString("app-%1.png").arg(size), files)) {
+            return 1;
+        }
+    }
+
+    if (!writeQrc(outputDir, files)) {
+        std::fprintf(stderr, "写入 icons.qrc 失败\n");
+        return 1;
+    }
+    return 0;
+}